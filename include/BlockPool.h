@@ -0,0 +1,215 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PoolHandle structure
+///////////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct PoolHandle
+{
+    uint32_t    Index       = UINT32_MAX;   // プール内の通し番号.
+    uint32_t    Generation  = 0;            // 生成時の世代番号(0は無効).
+
+    bool IsNull() const
+    { return Index == UINT32_MAX; }
+
+    bool operator == (const PoolHandle& value) const
+    { return Index == value.Index && Generation == value.Generation; }
+
+    bool operator != (const PoolHandle& value) const
+    { return !(*this == value); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// BlockPool class
+///////////////////////////////////////////////////////////////////////////////
+template<typename T, size_t BlockSize>
+class BlockPool
+{
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    BlockPool()
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      デストラクタです.
+    //-------------------------------------------------------------------------
+    ~BlockPool()
+    { Clear(); }
+
+    //-------------------------------------------------------------------------
+    //! @brief      オブジェクトを生成します.
+    //!
+    //! @note       解放済みの領域があれば再利用し，無ければブロック末尾から
+    //!             連続して切り出します.
+    //-------------------------------------------------------------------------
+    template<typename... Args>
+    T* Alloc(Args&&... args)
+    {
+        Item* item = nullptr;
+        if (m_pFreeList != nullptr)
+        {
+            item = m_pFreeList;
+            m_pFreeList = *reinterpret_cast<Item**>(item->Storage);
+        }
+        else
+        {
+            if (m_pBlocks.empty() || m_Used == BlockSize)
+            {
+                m_pBlocks.push_back(new Block());
+                m_Used = 0;
+            }
+
+            item = &m_pBlocks.back()->Items[m_Used];
+            item->Index = uint32_t((m_pBlocks.size() - 1) * BlockSize + m_Used);
+            m_Used++;
+        }
+
+        auto result = new (item->Storage) T(std::forward<Args>(args)...);
+        item->Alive      = true;
+        item->Generation = m_NextGeneration++;
+        m_Count++;
+
+        if (m_NextGeneration == 0)
+        { m_NextGeneration = 1; }
+
+        return result;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      オブジェクトを破棄します.
+    //-------------------------------------------------------------------------
+    void Free(T* ptr)
+    {
+        if (ptr == nullptr)
+        { return; }
+
+        auto item = reinterpret_cast<Item*>(ptr);
+        ptr->~T();
+        item->Alive      = false;
+        item->Generation = 0;
+
+        *reinterpret_cast<Item**>(item->Storage) = m_pFreeList;
+        m_pFreeList = item;
+        m_Count--;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      オブジェクトを破棄せずにハンドルだけを無効化します.
+    //!
+    //! @note       実体は Free() または Clear() を呼び出すまで残ります.
+    //-------------------------------------------------------------------------
+    void Invalidate(T* ptr)
+    {
+        if (ptr == nullptr)
+        { return; }
+
+        reinterpret_cast<Item*>(ptr)->Generation = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      オブジェクトのハンドルを取得します.
+    //-------------------------------------------------------------------------
+    PoolHandle<T> GetHandle(const T* ptr) const
+    {
+        PoolHandle<T> result;
+        if (ptr == nullptr)
+        { return result; }
+
+        auto item = reinterpret_cast<const Item*>(ptr);
+        result.Index      = item->Index;
+        result.Generation = item->Generation;
+        return result;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ハンドルからオブジェクトを取得します.
+    //!
+    //! @note       破棄・無効化済みの場合は nullptr を返します.
+    //-------------------------------------------------------------------------
+    T* Resolve(const PoolHandle<T>& handle) const
+    {
+        if (handle.IsNull() || handle.Generation == 0)
+        { return nullptr; }
+
+        auto block  = handle.Index / BlockSize;
+        auto offset = handle.Index % BlockSize;
+        if (block >= m_pBlocks.size())
+        { return nullptr; }
+
+        if (block + 1 == m_pBlocks.size() && offset >= m_Used)
+        { return nullptr; }
+
+        auto& item = m_pBlocks[block]->Items[offset];
+        if (!item.Alive || item.Generation != handle.Generation)
+        { return nullptr; }
+
+        return reinterpret_cast<T*>(const_cast<uint8_t*>(item.Storage));
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      全オブジェクトを破棄し，ブロックを一括で解放します.
+    //!
+    //! @note       世代番号は引き継ぐため，解放前のハンドルは無効のままです.
+    //-------------------------------------------------------------------------
+    void Clear()
+    {
+        for(size_t i=0; i<m_pBlocks.size(); ++i)
+        {
+            auto block = m_pBlocks[i];
+            auto count = (i + 1 == m_pBlocks.size()) ? m_Used : BlockSize;
+            for(size_t j=0; j<count; ++j)
+            {
+                auto& item = block->Items[j];
+                if (item.Alive)
+                { reinterpret_cast<T*>(item.Storage)->~T(); }
+            }
+
+            delete block;
+        }
+
+        m_pBlocks.clear();
+        m_pFreeList = nullptr;
+        m_Used      = 0;
+        m_Count     = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      生存しているオブジェクト数を取得します.
+    //-------------------------------------------------------------------------
+    size_t GetCount() const
+    { return m_Count; }
+
+private:
+    struct Item
+    {
+        alignas(T) uint8_t  Storage[sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T)];
+        bool                Alive;
+        uint32_t            Generation;     // 世代番号(無効化・解放済みは0).
+        uint32_t            Index;          // プール内の通し番号.
+    };
+
+    struct Block
+    {
+        Item    Items[BlockSize];
+    };
+
+    std::vector<Block*> m_pBlocks;
+    Item*               m_pFreeList = nullptr;
+    size_t              m_Used      = 0;
+    size_t              m_Count     = 0;
+    uint32_t            m_NextGeneration = 1;
+
+    BlockPool       (const BlockPool&) = delete;
+    void operator = (const BlockPool&) = delete;
+};
@@ -1,38 +1,85 @@
-#pragma once
+﻿#pragma once
 
 #include <EditData.h>
 
 
-Node* Sample1D();
-Node* Sample2D();
-//Node* Sample3D();
-//Node* SampleCube();
-//Node* Sample1DArray();
-//Node* Sample2DArray();
-//Node* SampleCubeArray();
+///////////////////////////////////////////////////////////////////////////////
+// NodeCategory enum
+///////////////////////////////////////////////////////////////////////////////
+enum NodeCategory
+{
+    CategoryConstant,       // 定数.
+    CategoryPacking,        // パッキング.
+    CategoryOperator,       // 演算子.
+    CategoryBuiltinFunc,    // 組み込み関数.
+    CategoryTexture,        // テクスチャ.
+    CategoryPresetFunc,     // プリセット関数.
+};
 
-Node* ConstantValue(DataType type);
-Node* Color3();
-Node* Color4();
+///////////////////////////////////////////////////////////////////////////////
+// SlotDescriptor structure
+///////////////////////////////////////////////////////////////////////////////
+struct SlotDescriptor
+{
+    SlotType            Kind;
+    DataType            Type;
+    const char*         Tag;
+};
 
-Node* FromFloat2();
-Node* FromFloat3();
-Node* FromFloat4();
+///////////////////////////////////////////////////////////////////////////////
+// NodeDescriptor structure
+///////////////////////////////////////////////////////////////////////////////
+struct NodeDescriptor
+{
+    NodeCategory            Category;           // メニューの分類.
+    const char*             Group;              // メニューのサブグループ(nullptrは無し).
+    const char*             Label;              // メニューの表示名.
+    NodeType                Type;
+    const char*             Tag;
+    const char*             SourceCodeTemplate;
+    const SlotDescriptor*   pSlots;
+    uint32_t                SlotCount;
+    TextureDimension        Dimension;
+    bool                    AsColor;
+    float                   Values[4];          // 初期値.
+};
 
-Node* ToFloat2();
-Node* ToFloat3();
-Node* ToFloat4();
+uint32_t GetNodeDescriptorCount();
+const NodeDescriptor* GetNodeDescriptor(uint32_t index);
+uint32_t GetNodeDescriptorIndex(const NodeDescriptor* descriptor);
+Node* CreateBuiltinNode(EditData& data, const NodeDescriptor* descriptor);
 
-Node* OpAdd(DataType type);
-Node* OpSub(DataType type);
-Node* OpMul(DataType type);
-Node* OpDiv(DataType type);
 
-Node* GetTexCoord0();
-Node* GetTexCoord1();
-Node* GetTexCoord2();
-Node* GetTexCoord3();
+Node* Sample1D(EditData& data);
+Node* Sample2D(EditData& data);
+//Node* Sample3D(EditData& data);
+//Node* SampleCube(EditData& data);
+//Node* Sample1DArray(EditData& data);
+//Node* Sample2DArray(EditData& data);
+//Node* SampleCubeArray(EditData& data);
 
-Node* GetGeometryNormal();
-Node* GetGeometryTangent();
-Node* GetGeometryBitangent();
+Node* ConstantValue(EditData& data, DataType type);
+Node* Color3(EditData& data);
+Node* Color4(EditData& data);
+
+Node* FromFloat2(EditData& data);
+Node* FromFloat3(EditData& data);
+Node* FromFloat4(EditData& data);
+
+Node* ToFloat2(EditData& data);
+Node* ToFloat3(EditData& data);
+Node* ToFloat4(EditData& data);
+
+Node* OpAdd(EditData& data, DataType type);
+Node* OpSub(EditData& data, DataType type);
+Node* OpMul(EditData& data, DataType type);
+Node* OpDiv(EditData& data, DataType type);
+
+Node* GetTexCoord0(EditData& data);
+Node* GetTexCoord1(EditData& data);
+Node* GetTexCoord2(EditData& data);
+Node* GetTexCoord3(EditData& data);
+
+Node* GetGeometryNormal(EditData& data);
+Node* GetGeometryTangent(EditData& data);
+Node* GetGeometryBitangent(EditData& data);
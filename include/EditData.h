@@ -3,8 +3,16 @@
 //-----------------------------------------------------------------------------
 // Includes
 //-----------------------------------------------------------------------------
+#include <atomic>
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include <BlockPool.h>
+#include <GraphStorage.h>
+#include <GraphTypes.h>
+#include <IdAllocator.h>
+#include <StringPool.h>
 #include <imgui/imgui.h>
 #include <tinyxml2/tinyxml2.h>
 
@@ -13,69 +21,25 @@
 // Forward Declarations.
 //-----------------------------------------------------------------------------
 struct Node;
+struct Slot;
+struct SubGraph;
+struct NodeDescriptor;
+class  EditData;
+class  GraphBinaryView;
+class  GraphBinaryWriter;
+class  ShaderPackWriter;
 
-uint64_t GetNextId();
+typedef PoolHandle<Node> NodeHandle;
+typedef PoolHandle<Slot> SlotHandle;
 
 ///////////////////////////////////////////////////////////////////////////////
-// NodeType enum
-//////////////////////////////////////////////////////////////////////////////
-enum NodeType
-{
-    Function,
-    Texture,
-    Constant,
-    StageOutput,
-};
-
-///////////////////////////////////////////////////////////////////////////////
-// SlotType enum
-///////////////////////////////////////////////////////////////////////////////
-enum SlotType
-{
-    Input,
-    Output,
-};
-
-///////////////////////////////////////////////////////////////////////////////
-// TextureDimension enum
-///////////////////////////////////////////////////////////////////////////////
-enum TextureDimension
-{
-    None,
-    Texture1D,
-    Texture2D,
-    Texture3D,
-    TextureCube,
-    Texture1DArray,
-    Texture2DArray,
-    TextureCubeArray,
-};
-
-///////////////////////////////////////////////////////////////////////////////
-// SamplerType enum
+// GBufferLayout structure
 ///////////////////////////////////////////////////////////////////////////////
-enum SamplerType
+struct GBufferLayout
 {
-    PointWrap,
-    PointClamp,
-    PointMirror,
-    LinearWrap,
-    LinearClamp,
-    LinearMirror,
-    AnisotropicWrap,
-    AnisotropicClamp,
-    AnisotropicMirror,
-};
-
-///////////////////////////////////////////////////////////////////////////////
-// DataType enum
-///////////////////////////////////////////////////////////////////////////////
-enum DataType
-{
-    Float1,
-    Float2,
-    Float3,
-    Float4,
+    bool    OctahedralNormal    = false;    // @𔪖ʑ̃}bsOfloat2Ɉk.
+    bool    YCoCgBaseColor      = false;    // x[XJ[YCoCgfloat2Ɉk.
+    bool    PackedRMO           = false;    // tlXE^lXEՕuintɋl߂.
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -87,24 +51,35 @@ struct Slot
     DataType    Type    = DataType::Float1;
     Node*       pOwner  = nullptr;
     Slot*       pPrev   = nullptr;
-    Slot*       pNext   = nullptr;
-    std::string Tag;
+    std::vector<Slot*>  pNexts;         // ڑ(o̓Xbĝ).
+    Symbol      Tag     = kEmptySymbol;
 
     ImVec2      Pos    = ImVec2(0, 0);  // `ʒu.
     ImGuiID     Id     = 0;             // ImGuił̔ʗp.
     uint64_t    VarId  = 0;             // ϐԍ.
+    uint32_t    NextIndex = 0;          // ڑ pNexts ł̈ʒu(̓Xbĝ).
 
     std::string GenVarName() const;
+    const char* GetTag() const;
 
-    Slot(SlotType kind, DataType type, const char* tag, Node* owner)
+    Slot(SlotType kind, DataType type, Symbol tag, Node* owner, uint64_t varId)
     : Kind  (kind)
     , Type  (type)
     , pOwner(owner)
     , Tag   (tag)
-    , VarId (GetNextId())
+    , VarId (varId)
     { /* DO_NOTHING */ }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// GenContext structure
+///////////////////////////////////////////////////////////////////////////////
+struct GenContext
+{
+    QualityLevel                        Quality = QualityLevel::High;   // i.
+    std::map<const Slot*, const Slot*>  Alias;                          // ꂽo̓Xbg.
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // Node structure
 ///////////////////////////////////////////////////////////////////////////////
@@ -112,8 +87,8 @@ struct Node
 {
     NodeType            Type        = NodeType::Function;
     std::vector<Slot*>  pSlots;
-    std::string         Tag;
-    std::string         SourceCodeTemplate;
+    Symbol              Tag                 = kEmptySymbol;
+    Symbol              SourceCodeTemplate  = kEmptySymbol;
     ImVec2              Pos         = ImVec2(0, 0);
     ImVec2              Size        = ImVec2(100, 10);
 
@@ -122,14 +97,29 @@ struct Node
     SamplerType         Sampler          = LinearWrap;
     float               Values[4]        = {};
     bool                AsColor          = false;
+    QualityLevel        MinQuality       = QualityLevel::Low;  // LƂȂŒi.
+    int                 FallbackInput    = -1;                 // isɑւ͔ԍ(-1͊l).
+    SubGraph*           pSubGraph        = nullptr;            // ĂяoTuOt.
+    EditData*           pGraph           = nullptr;            // ҏWf[^.
+    const NodeDescriptor* pDescriptor    = nullptr;            // m[hLqq(gݍ݃m[ĥ).
+    uint32_t            Order            = 0;                  // g|WJ(ڑقǏ).
+    uint32_t            VisitMark        = 0;                  // Tς݂̈.
+    uint64_t            ContentHash      = 0;                  // m[hg̓ẽnbVl.
+    uint64_t            Hash             = 0;                  // 㗬܂߂ẽnbVl.
+    bool                HashDirty        = false;              // nbVl̍ČvZ҂.
 
     // ꎞf[^ ---
     ImTextureID         TextureId        = nullptr;
+    uint32_t            StorageIndex     = 0;                  // R[hpOtł̃m[hԍ.
     //--------------
 
 
     void Reset();
-    std::string GenMicroCode() const;
+    const char* GetTag() const;
+    const char* GetSourceCodeTemplate() const;
+    std::string GenMicroCode(const GenContext& context) const;
+    bool IsActive(QualityLevel quality) const;
+    Slot* GetFallbackSlot() const;
     void AddInput1(const char* tag); // Float1
     void AddInput2(const char* tag); // Float2
     void AddInput3(const char* tag); // Float3
@@ -140,6 +130,116 @@ struct Node
     void AddOutput4(const char* tag); // Float4
     void AddInput(const char* tag, DataType type);
     void AddOutput(const char* tag, DataType type);
+    void AddInput(Symbol tag, DataType type);
+    void AddOutput(Symbol tag, DataType type);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CodeGenGraph structure
+///////////////////////////////////////////////////////////////////////////////
+struct CodeGenGraph
+{
+    std::vector<Node*>  pNodes;     // m[hԍɑΉm[h(m[h).
+    GraphStorage        Storage;    // CfbNXQƂ̐ڑ֌W.
+
+    void Build();
+    void CollectNodes(QualityLevel quality, std::vector<Node*>& result) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SubGraph structure
+///////////////////////////////////////////////////////////////////////////////
+struct SubGraph
+{
+    std::string         Name;
+    std::vector<Node*>  pNodes;                 // m[h.
+    Node*               pInput  = nullptr;      // ̓m[h(o̓Xbĝ).
+    Node*               pOutput = nullptr;      // o̓m[h(̓Xbĝ).
+    ImVec2              Origin  = ImVec2(0, 0); // W񎞂̔zuʒu.
+    CodeGenGraph        CodeGen;                // R[hp̃Ot.
+
+    void Reset();
+    std::string GetFuncName() const;
+    std::string GenFuncCode(QualityLevel quality, std::vector<SubGraph*>& pCallees) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ClipboardSlot structure
+///////////////////////////////////////////////////////////////////////////////
+struct ClipboardSlot
+{
+    SlotType    Kind        = SlotType::Input;
+    DataType    Type        = DataType::Float1;
+    Symbol      Tag         = kEmptySymbol;
+    int32_t     Prev        = -1;       // ڑ̃Xbgԍ(-1͔͈͊O܂͖ڑ).
+    uint32_t    NextCount   = 0;        // ͈͓̐ڑ̐(o̓Xbĝ).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ClipboardNode structure
+///////////////////////////////////////////////////////////////////////////////
+struct ClipboardNode
+{
+    NodeType                Type                = NodeType::Function;
+    Symbol                  Tag                 = kEmptySymbol;
+    Symbol                  SourceCodeTemplate  = kEmptySymbol;
+    const NodeDescriptor*   pDescriptor         = nullptr;
+    ImVec2                  Pos                 = ImVec2(0, 0);     // Rs[͈͂̍ォ̈ʒu.
+    std::string             TexturePath;
+    TextureDimension        TextureDimension    = TextureDimension::None;
+    SamplerType             Sampler             = LinearWrap;
+    float                   Values[4]           = {};
+    bool                    AsColor             = false;
+    QualityLevel            MinQuality          = QualityLevel::Low;
+    int                     FallbackInput       = -1;
+    SubGraph*               pSubGraph           = nullptr;
+    uint32_t                SlotBegin           = 0;                // Slots ł̐擪ʒu.
+    uint32_t                SlotCount           = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeClipboard structure
+///////////////////////////////////////////////////////////////////////////////
+struct NodeClipboard
+{
+    std::vector<ClipboardNode>  Nodes;
+    std::vector<ClipboardSlot>  Slots;      // Sm[h̃XbgAĊi[.
+
+    void Clear();
+    bool IsEmpty() const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeDiffType enum
+///////////////////////////////////////////////////////////////////////////////
+enum NodeDiffType
+{
+    NodeDiffChanged,        // m[h̓eقȂ.
+    NodeDiffLinked,         // ύXɂ͂ڑĂ.
+    NodeDiffUnlinked,       // ύXOɂ͂ڑĂ.
+    NodeDiffRelinked,       // ڑ̏o̓XbgقȂ.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeDiff structure
+///////////////////////////////////////////////////////////////////////////////
+struct NodeDiff
+{
+    NodeDiffType    Type    = NodeDiffChanged;
+    const Node*     pBefore = nullptr;
+    const Node*     pAfter  = nullptr;
+    uint32_t        Input   = 0;        // ̓Xbgԍ(NodeDiffChanged ȊO).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CollapseError enum
+///////////////////////////////////////////////////////////////////////////////
+enum CollapseError
+{
+    CollapseOk,             // Wł.
+    CollapseInvalidName,    // TuOtƂĎgȂ.
+    CollapseNoTarget,       // Włm[h.
+    CollapseCycle,          // IÕm[hoRđIm[hɖ߂ڑ.
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -152,23 +252,107 @@ public:
     ~EditData();
     void Reset();
     void AddNode(Node* node);
+    void AddNodes(const std::vector<Node*>& nodes);
     void RemoveNode(Node* node);
     std::vector<Node*>& GetNodes();
     Node* GetStageOutput();
+    const Node* GetStageOutput() const;
+
+    Node* CreateNode();
+    void DestroyNode(Node* node);
+    Slot* CreateSlot(SlotType kind, DataType type, Symbol tag, Node* owner);
+    void DestroySlot(Slot* slot);
+    void ReclaimNodes();
+
+    NodeHandle GetHandle(const Node* node) const;
+    SlotHandle GetHandle(const Slot* slot) const;
+    Node* GetNode(NodeHandle handle) const;
+    Slot* GetSlot(SlotHandle handle) const;
+
+    bool AddLink(Slot* output, Slot* input);
+    void RemoveLink(Slot* input);
+    void RemoveLinks(Slot* slot);
+
+    void InvalidateHash(Node* node);
+    void UpdateHashes();
+    void RefreshHashes();
+    uint64_t GetGraphHash();
+
+    void CopyNodes(const std::vector<Node*>& nodes, NodeClipboard& clipboard) const;
+    void PasteNodes(const NodeClipboard& clipboard, const ImVec2& pos, std::vector<Node*>& result);
+
+    Node* CollapseNodes(const std::vector<Node*>& nodes, const char* name, CollapseError* pError = nullptr);
+    bool ExpandSubGraph(Node* node);
+    Node* CreateSubGraphNode(SubGraph* subGraph);
+    bool RenameSubGraph(SubGraph* subGraph, const char* name);
+    bool IsValidSubGraphName(const char* name, const SubGraph* subGraph = nullptr) const;
+    std::string MakeSubGraphName() const;
+    std::vector<SubGraph*>& GetSubGraphs();
+
+    const GBufferLayout& GetGBufferLayout() const;
+    void SetGBufferLayout(const GBufferLayout& layout);
 
     bool Load(const char* path);
     bool Save(const char* path);
+    bool LoadBinary(const char* path);
+    bool SaveBinary(const char* path);
+    void CaptureSnapshot(GraphBinaryWriter& writer) const;
+    void GetFileOrder(std::vector<const Node*>& result) const;
     bool Export();
+    bool ExportPack(ShaderPackWriter& writer, const std::string& name);
 
     bool FindSlot(ImGuiID slotId, Slot** slot);
-    const std::string& GetShaderCode() const;
+    void SetSlotId(Slot* slot, ImGuiID slotId);
+    const std::string& GetShaderCode(QualityLevel quality = QualityLevel::High) const;
     void GenShaderCode();
+    uint64_t GetCodeHash() const;
 
 private:
-    std::vector<Node*>  m_pNodes;
-    Node                m_StageOutput;
-    std::string         m_ExportPath;
-    std::string         m_ShaderCode;
-    uint64_t            m_NextId;
+    BlockPool<Node, 256>    m_NodePool;
+    BlockPool<Slot, 1024>   m_SlotPool;
+    std::vector<Node*>      m_pNodes;
+    std::vector<SubGraph*>  m_pSubGraphs;
+    std::unordered_map<ImGuiID, Slot*>  m_SlotIndex;
+    std::vector<Node*>      m_pGarbageNodes;        // t[I[ŉm[h.
+    std::vector<Node*>      m_pDirtyNodes;          // nbVl̍ČvZ҂̃m[h.
+    Node*                   m_pStageOutput = nullptr;
+    GBufferLayout           m_GBufferLayout;
+    std::string             m_ExportPath;
+    std::string             m_ShaderCode[QualityLevel::High + 1];
+    CodeGenGraph            m_CodeGen;              // R[hp̃Ot.
+    uint64_t                m_CodeHash      = 0;    // VF[_R[h̃Ot̃nbVl.
+    bool                    m_CodeGenerated = false;
+    IdAllocator             m_VarIds;               // ϐԍ(ҏWf[^ɓƗ).
+    uint32_t                m_NextOrder = 0;
+    uint32_t                m_VisitMark = 0;
+
+    void InitStageOutput();
+    void UnregisterSlots(const Node* node);
+    void UpdateStageOutput();
+    bool UpdateOrder(Node* from, Node* to);
+    bool CheckSubGraphNames() const;
+    Node* CloneNode(const Node* node);
+    void GenShaderCode(QualityLevel quality);
 };
 
+//-----------------------------------------------------------------------------
+//! @brief      XibvVbgXML`ŏo܂.
+//!
+//!             pWritten ɂ͏oς݂̃m[hZ܂.
+//-----------------------------------------------------------------------------
+bool SaveGraphXml(const GraphBinaryView& view, const char* path, std::atomic<uint32_t>* pWritten = nullptr);
+
+//-----------------------------------------------------------------------------
+//! @brief      XibvVbgXML`Ńɏo͂܂.
+//!
+//!             pWritten ɂ͏o͍ς݂̃m[hZ܂.
+//-----------------------------------------------------------------------------
+void FormatGraphXml(const GraphBinaryView& view, std::vector<uint8_t>& result, std::atomic<uint32_t>* pWritten = nullptr);
+
+//-----------------------------------------------------------------------------
+//! @brief      2̕ҏWf[^̍擾܂.
+//!
+//!             Xe[Wo͂㗬ցCnbVlقȂ镔H܂.
+//-----------------------------------------------------------------------------
+void DiffGraphs(EditData& before, EditData& after, std::vector<NodeDiff>& result);
+
@@ -0,0 +1,97 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <deque>
+#include <EditData.h>
+
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+class EditJournal;
+
+///////////////////////////////////////////////////////////////////////////////
+// EditCommandType enum
+///////////////////////////////////////////////////////////////////////////////
+enum EditCommandType
+{
+    CommandAddNode,         // ノード追加.
+    CommandRemoveNode,      // ノード削除.
+    CommandAddLink,         // 接続追加.
+    CommandRemoveLink,      // 接続解除.
+    CommandSetValues,       // 定数値変更.
+    CommandMoveNode,        // ノード移動.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// EditCommand structure
+///////////////////////////////////////////////////////////////////////////////
+struct EditCommand
+{
+    EditCommandType Type;
+    uint32_t        Group;          // 取り消し単位.
+    Node*           pNode;          // 対象ノード.
+    Slot*           pOutput;        // 接続元.
+    Slot*           pInput;         // 接続先.
+    Slot*           pOldOutput;     // 置き換え前の接続元.
+    float           OldValues[4];
+    float           NewValues[4];
+    ImVec2          OldPos;
+    ImVec2          NewPos;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// EditHistory class
+///////////////////////////////////////////////////////////////////////////////
+class EditHistory
+{
+public:
+    explicit EditHistory(EditData& data);
+    ~EditHistory();
+
+    void BeginGroup();
+    void EndGroup();
+    void Seal();
+
+    void AddNode(Node* node);
+    void AddNodes(const std::vector<Node*>& nodes);
+    void RemoveNode(Node* node);
+    bool AddLink(Slot* output, Slot* input);
+    void RemoveLink(Slot* input);
+    void SetValues(Node* node, const float* oldValues);
+    void MoveNode(Node* node, const ImVec2& oldPos);
+
+    bool Undo();
+    bool Redo();
+    bool CanUndo() const;
+    bool CanRedo() const;
+    void Clear();
+
+    void SetJournal(EditJournal* journal);
+
+    void SetMemoryBudget(size_t bytes);
+    size_t GetMemoryBudget() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    EditData&               m_Data;
+    EditJournal*            m_pJournal      = nullptr;  // 変更の記録先.
+    std::deque<EditCommand> m_Commands;             // 適用済みと取り消し済みのコマンド.
+    size_t                  m_Cursor        = 0;    // 適用済みコマンド数.
+    size_t                  m_MemoryUsage   = 0;
+    size_t                  m_MemoryBudget  = 16 * 1024 * 1024;
+    uint32_t                m_GroupCounter  = 0;
+    uint32_t                m_GroupDepth    = 0;
+    bool                    m_Sealed        = true;
+
+    EditCommand& Push(EditCommandType type, Node* node);
+    void DiscardRedo();
+    void Evict();
+    void Apply(const EditCommand& command);
+    void Revert(const EditCommand& command);
+    void Release(const EditCommand& command, bool undone);
+    size_t GetCommandSize(const EditCommand& command) const;
+};
@@ -0,0 +1,180 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <EditData.h>
+#include <GraphSaver.h>
+
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+struct EditCommand;
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalEntryType enum
+///////////////////////////////////////////////////////////////////////////////
+enum JournalEntryType
+{
+    JournalAddNodes,        // 新規ノード追加(JournalNodes).
+    JournalRestoreNode,     // 削除済みノードの再追加(ノード番号).
+    JournalRemoveNode,      // ノード削除(ノード番号).
+    JournalAddLink,         // 接続追加(JournalLink).
+    JournalRemoveLink,      // 接続解除(JournalLink の入力側のみ).
+    JournalSetValues,       // 定数値変更(JournalValues).
+    JournalMoveNode,        // ノード移動(JournalMove).
+    JournalSetQuality,      // 品質設定変更(JournalQuality).
+    JournalSetLayout,       // Gバッファのレイアウト変更(JournalLayout).
+    JournalRenameSubGraph,  // サブグラフ名変更(JournalRename の後に名前が続く).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalHeader
+{
+    uint32_t    Magic;          //!< マジック('SJNL').
+    uint32_t    Version;        //!< ファイルバージョン.
+    uint64_t    SnapshotHash;   //!< 起点となるスナップショットのハッシュ値.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalEntryHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalEntryHeader
+{
+    uint32_t    Hash;           //!< Type 以降とデータのハッシュ値(下位32bit).
+    uint16_t    Type;           //!< JournalEntryType.
+    uint16_t    Reserved;       //!< 予約領域.
+    uint32_t    Size;           //!< 後続するデータのサイズ.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalNodes structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalNodes
+{
+    uint32_t    NodeCount;      //!< ノード数(GraphNodeRecord が続く).
+    uint32_t    SlotCount;      //!< スロット数(GraphSlotRecord が続く).
+    uint32_t    StringSize;     //!< 文字列テーブルのサイズ(末尾に続く).
+    uint32_t    Reserved;       //!< 予約領域.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalLink structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalLink
+{
+    uint32_t    OutputNode;     //!< 接続元のノード番号.
+    uint32_t    OutputSlot;     //!< 接続元のスロット番号.
+    uint32_t    InputNode;      //!< 接続先のノード番号.
+    uint32_t    InputSlot;      //!< 接続先のスロット番号.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalValues structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalValues
+{
+    uint32_t    Node;           //!< ノード番号.
+    float       Values[4];      //!< 変更後の定数値.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalMove structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalMove
+{
+    uint32_t    Node;           //!< ノード番号.
+    float       Pos[2];         //!< 変更後の位置.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalQuality structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalQuality
+{
+    uint32_t    Node;           //!< ノード番号.
+    uint32_t    MinQuality;     //!< 有効となる最低品質.
+    int32_t     FallbackInput;  //!< 品質不足時に代替する入力番号.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalLayout structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalLayout
+{
+    uint32_t    Flags;          //!< GraphFlags の組み合わせ.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// JournalRename structure
+///////////////////////////////////////////////////////////////////////////////
+struct JournalRename
+{
+    uint32_t    SubGraph;       //!< サブグラフ番号.
+    uint32_t    NameSize;       //!< 名前の長さ(終端文字を含まない).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// EditJournal class
+///////////////////////////////////////////////////////////////////////////////
+class EditJournal
+{
+public:
+    explicit EditJournal(EditData& data);
+    ~EditJournal();
+
+    void SetPath(const char* snapshotPath, const char* journalPath);
+    bool Recover();
+    bool Checkpoint();
+    void Update();
+    void Close();
+
+    void Record(const EditCommand& command, bool revert);
+    void AddNode(const Node* node);
+    void AddNodes(const std::vector<Node*>& nodes);
+    void RemoveNode(const Node* node);
+    void AddLink(const Slot* output, const Slot* input);
+    void RemoveLink(const Slot* input);
+    void SetValues(const Node* node);
+    void MoveNode(const Node* node);
+    void SetQuality(const Node* node);
+    void SetLayout(const GBufferLayout& layout);
+    void RenameSubGraph(const SubGraph* subGraph);
+
+private:
+    EditData&                               m_Data;
+    std::string                             m_SnapshotPath;
+    std::string                             m_JournalPath;
+    FILE*                                   m_pFile     = nullptr;    // 確定済みのスナップショットに対するジャーナル.
+    GraphSaver                              m_Saver;                    // スナップショットの書き出し.
+    std::vector<uint8_t>                    m_Buffer;                   // 未書き出しのエントリー.
+    size_t                                  m_LastEntry = SIZE_MAX;     // 結合できる直前のエントリーの位置.
+    uint64_t                                m_FileSize  = 0;
+    std::unordered_map<uint64_t, uint32_t>  m_Ids;                      // ノードハンドルからノード番号への対応.
+    std::vector<NodeHandle>                 m_Handles;                  // ノード番号からノードハンドルへの対応.
+    std::chrono::steady_clock::time_point   m_LastSync;
+    bool                                    m_Unsynced  = false;
+    bool                                    m_Retry     = false;        // スナップショットの取り直しが必要か.
+
+    bool IsRecording() const;
+    void FinishCheckpoint();
+    void Commit(bool succeeded);
+    void ResetIds();
+    uint32_t FindId(const Node* node) const;
+    uint32_t AssignId(const Node* node);
+    Node* FindNode(uint32_t id) const;
+    uint8_t* BeginEntry(JournalEntryType type, size_t size);
+    void EndEntry(size_t offset);
+    void WriteLink(JournalEntryType type, const Slot* output, const Slot* input);
+    bool Replay(uint16_t type, const uint8_t* data, uint32_t size);
+    void Flush(bool sync);
+};
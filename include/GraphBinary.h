@@ -0,0 +1,222 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+struct Node;
+struct Slot;
+struct SubGraph;
+class  EditData;
+class  GraphStorage;
+
+static const uint32_t kGraphNoIndex = 0xffffffff;    // 無効な番号.
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphBinaryFlags enum
+///////////////////////////////////////////////////////////////////////////////
+enum GraphBinaryFlags
+{
+    GraphOctahedralNormal   = 0x1,      // GBufferLayout::OctahedralNormal.
+    GraphYCoCgBaseColor     = 0x2,      // GBufferLayout::YCoCgBaseColor.
+    GraphPackedRMO          = 0x4,      // GBufferLayout::PackedRMO.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphBinaryHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct GraphBinaryHeader
+{
+    uint32_t    Magic;          //!< マジック('SGRB').
+    uint32_t    Version;        //!< ファイルバージョン.
+    uint32_t    NodeCount;      //!< ノード数.
+    uint32_t    SlotCount;      //!< スロット数.
+    uint32_t    SubGraphCount;  //!< サブグラフ数.
+    uint32_t    Flags;          //!< Gバッファレイアウト(GraphBinaryFlags の組み合わせ).
+    uint32_t    StringSize;     //!< 文字列テーブルのサイズ.
+    uint32_t    Reserved;       //!< 予約領域.
+    uint64_t    NodeOffset;     //!< ノードテーブルまでのオフセット.
+    uint64_t    SlotOffset;     //!< スロットテーブルまでのオフセット.
+    uint64_t    SubGraphOffset; //!< サブグラフテーブルまでのオフセット.
+    uint64_t    StringOffset;   //!< 文字列テーブルまでのオフセット.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphNodeRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct GraphNodeRecord
+{
+    uint8_t     Type;               //!< NodeType.
+    uint8_t     MinQuality;         //!< QualityLevel.
+    uint8_t     TextureDimension;   //!< TextureDimension.
+    uint8_t     Sampler;            //!< SamplerType.
+    int32_t     FallbackInput;      //!< 品質不足時に代替する入力番号(-1は既定値).
+    uint32_t    SlotBegin;          //!< スロットテーブルでの先頭位置.
+    uint32_t    SlotCount;          //!< スロット数.
+    uint32_t    Tag;                //!< タグ(文字列テーブルのオフセット).
+    uint32_t    Template;           //!< ソースコードテンプレート(文字列テーブルのオフセット).
+    uint32_t    TexturePath;        //!< テクスチャパス(文字列テーブルのオフセット).
+    uint32_t    Descriptor;         //!< ノード記述子の番号(kGraphNoIndex は無し).
+    uint32_t    SubGraph;           //!< 呼び出すサブグラフの番号(kGraphNoIndex は無し).
+    uint32_t    AsColor;            //!< カラーとして編集するかどうか.
+    float       Values[4];          //!< 定数値.
+    float       Pos[2];             //!< 描画位置.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphSlotRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct GraphSlotRecord
+{
+    uint8_t     Kind;           //!< SlotType.
+    uint8_t     Type;           //!< DataType.
+    uint16_t    Reserved;       //!< 予約領域.
+    uint32_t    Owner;          //!< 所属するノードの番号.
+    uint32_t    Tag;            //!< タグ(文字列テーブルのオフセット).
+    int32_t     Prev;           //!< 接続元スロットまでの相対位置(0は未接続).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphSubGraphRecord structure
+///////////////////////////////////////////////////////////////////////////////
+struct GraphSubGraphRecord
+{
+    uint32_t    Name;           //!< 名前(文字列テーブルのオフセット).
+    uint32_t    NodeBegin;      //!< ノードテーブルでの先頭位置(入力ノード).
+    uint32_t    NodeCount;      //!< ノード数(末尾が出力ノード).
+    uint32_t    Reserved;       //!< 予約領域.
+    float       Origin[2];      //!< 集約時の配置位置.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphStringTable class
+///////////////////////////////////////////////////////////////////////////////
+class GraphStringTable
+{
+public:
+    GraphStringTable();
+
+    uint32_t Add(const char* value);
+    const std::string& GetData() const;
+    void Clear();
+
+private:
+    std::string                                 m_Data;     // 終端文字付きの文字列を連結したもの(先頭は空文字列).
+    std::unordered_map<std::string, uint32_t>   m_Offsets;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphBinaryWriter class
+///////////////////////////////////////////////////////////////////////////////
+class GraphBinaryWriter
+{
+public:
+    GraphStringTable& GetStrings();
+    uint32_t AddNode(const GraphNodeRecord& record);
+    uint32_t AddSlot(const GraphSlotRecord& record);
+    uint32_t AddSubGraph(const GraphSubGraphRecord& record);
+    void SetFlags(uint32_t flags);
+    void Serialize(std::vector<uint8_t>& image) const;
+    bool Write(const char* path) const;
+    void Clear();
+
+private:
+    std::vector<GraphNodeRecord>            m_Nodes;
+    std::vector<GraphSlotRecord>            m_Slots;
+    std::vector<GraphSubGraphRecord>        m_SubGraphs;
+    GraphStringTable                        m_Strings;
+    uint32_t                                m_Flags = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphBinaryView class
+///////////////////////////////////////////////////////////////////////////////
+class GraphBinaryView
+{
+public:
+    GraphBinaryView();
+    ~GraphBinaryView();
+
+    bool Open(const char* path);
+    bool Attach(const void* data, size_t size);
+    void Close();
+
+    uint32_t GetFlags() const;
+    uint32_t GetNodeCount() const;
+    uint32_t GetSlotCount() const;
+    uint32_t GetSubGraphCount() const;
+    uint32_t GetMainNodeBegin() const;
+    const GraphNodeRecord*     GetNode(uint32_t index) const;
+    const GraphSlotRecord*     GetSlot(uint32_t index) const;
+    const GraphSubGraphRecord* GetSubGraph(uint32_t index) const;
+    uint32_t GetSlotPrev(uint32_t index) const;
+    const char* GetString(uint32_t offset) const;
+
+private:
+    void*                       m_hFile         = nullptr;
+    void*                       m_hMapping      = nullptr;
+    const uint8_t*              m_pMapped       = nullptr;
+    const GraphBinaryHeader*    m_pHeader       = nullptr;
+    const GraphNodeRecord*      m_pNodes        = nullptr;
+    const GraphSlotRecord*      m_pSlots        = nullptr;
+    const GraphSubGraphRecord*  m_pSubGraphs    = nullptr;
+    const char*                 m_pStrings      = nullptr;
+    std::vector<uint8_t>        m_Buffer;                   // 圧縮コンテナの展開先.
+
+    bool Validate(const uint8_t* data, uint64_t size);
+
+    GraphBinaryView     (const GraphBinaryView&) = delete;
+    void operator =     (const GraphBinaryView&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      ノードをレコードに格納します.
+//!
+//!             スロットの範囲は呼び出し側で設定してください.
+//-----------------------------------------------------------------------------
+void StoreNodeRecord(const Node* node, const std::vector<SubGraph*>& subGraphs, GraphStringTable& strings, GraphNodeRecord& record);
+
+//-----------------------------------------------------------------------------
+//! @brief      スロットをレコードに格納します.
+//!
+//!             接続元は呼び出し側で設定してください.
+//-----------------------------------------------------------------------------
+void StoreSlotRecord(const Slot* slot, uint32_t owner, GraphStringTable& strings, GraphSlotRecord& record);
+
+//-----------------------------------------------------------------------------
+//! @brief      レコードからノードとスロットを生成します.
+//!
+//!             ステージ出力は生成できません. 接続は復元しません.
+//!             文字列のオフセットは範囲チェック済みである必要があります.
+//-----------------------------------------------------------------------------
+Node* RestoreNode(EditData& data, const GraphNodeRecord& record, const GraphSlotRecord* pSlots, const char* strings);
+
+//-----------------------------------------------------------------------------
+//! @brief      GraphBinaryWriter::Serialize() で構築したファイルイメージを書き出します.
+//-----------------------------------------------------------------------------
+bool WriteGraphImage(const std::vector<uint8_t>& image, const char* path);
+
+//-----------------------------------------------------------------------------
+//! @brief      バイナリグラフからコード生成用のグラフストレージを構築します.
+//!
+//!             ノード・スロットの番号はファイル上の番号と一致します.
+//-----------------------------------------------------------------------------
+void BuildGraphStorage(const GraphBinaryView& view, GraphStorage& storage);
+
+//-----------------------------------------------------------------------------
+//! @brief      XML形式のグラフをバイナリ形式に変換します.
+//-----------------------------------------------------------------------------
+bool ConvertGraphToBinary(const char* xmlPath, const char* binaryPath);
+
+//-----------------------------------------------------------------------------
+//! @brief      バイナリ形式のグラフをXML形式に変換します.
+//-----------------------------------------------------------------------------
+bool ConvertGraphToXml(const char* binaryPath, const char* xmlPath);
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedGraphHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct CompressedGraphHeader
+{
+    uint32_t    Magic;          //!< マジック('SGCZ').
+    uint32_t    Version;        //!< ファイルバージョン.
+    uint32_t    ChunkSize;      //!< 展開後のチャンクサイズ(末尾のチャンク以外).
+    uint32_t    ChunkCount;     //!< チャンク数.
+    uint64_t    RawSize;        //!< 展開後の全体のサイズ.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CompressedGraphChunk structure
+///////////////////////////////////////////////////////////////////////////////
+struct CompressedGraphChunk
+{
+    uint64_t    Offset;         //!< 圧縮データまでのオフセット(ファイル先頭から).
+    uint32_t    Size;           //!< 圧縮データのサイズ(RawSize と等しい場合は無圧縮).
+    uint32_t    RawSize;        //!< 展開後のサイズ.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      圧縮コンテナかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsCompressedGraph(const void* data, size_t size);
+
+//-----------------------------------------------------------------------------
+//! @brief      ファイルイメージをチャンク毎に並列で圧縮します.
+//-----------------------------------------------------------------------------
+void CompressGraph(const uint8_t* data, size_t size, std::vector<uint8_t>& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      圧縮コンテナをチャンク毎に並列で展開します.
+//-----------------------------------------------------------------------------
+bool DecompressGraph(const uint8_t* data, size_t size, std::vector<uint8_t>& result);
+
+//-----------------------------------------------------------------------------
+//! @brief      ファイルが圧縮コンテナであれば読み込んで展開します.
+//!
+//!             圧縮コンテナでない場合や展開に失敗した場合は，読み込み位置を
+//!             先頭に戻して false を返します.
+//-----------------------------------------------------------------------------
+bool ReadCompressedGraph(FILE* pFile, std::vector<uint8_t>& result);
@@ -0,0 +1,60 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+class EditData;
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphSaver class
+///////////////////////////////////////////////////////////////////////////////
+class GraphSaver
+{
+public:
+    GraphSaver();
+    ~GraphSaver();
+
+    bool Start(const EditData& data, const char* path, bool binary, bool compress = false);
+    bool Poll(bool& succeeded);
+    void Wait();
+
+    bool IsBusy() const;
+    float GetProgress() const;
+    uint32_t GetNodeCount() const;
+    const std::string& GetPath() const;
+    double GetCaptureMsec() const;
+    double GetElapsedMsec() const;
+    uint64_t GetFileHash() const;
+
+private:
+    std::thread                             m_Thread;
+    std::vector<uint8_t>                    m_Image;                    // スナップショットのファイルイメージ.
+    std::string                             m_Path;
+    bool                                    m_Binary        = false;
+    bool                                    m_Compress      = false;    // 圧縮コンテナで書き出すか.
+    bool                                    m_Pending       = false;    // 結果を取得していない保存があるか.
+    bool                                    m_Result        = false;
+    uint32_t                                m_NodeCount     = 0;
+    uint64_t                                m_FileHash      = 0;        // 書き出したファイルのハッシュ値(XML形式では0).
+    std::atomic<uint32_t>                   m_Written;                  // 書き出し済みのノード数.
+    std::atomic<bool>                       m_Done;
+    std::chrono::steady_clock::time_point   m_Begin;
+    double                                  m_CaptureMsec   = 0.0;
+    double                                  m_ElapsedMsec   = 0.0;
+
+    void Run();
+
+    GraphSaver      (const GraphSaver&) = delete;
+    void operator = (const GraphSaver&) = delete;
+};
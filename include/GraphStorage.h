@@ -0,0 +1,87 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GraphTypes.h>
+#include <StringPool.h>
+
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+typedef uint32_t NodeIndex;
+typedef uint32_t SlotIndex;
+
+static const uint32_t kInvalidIndex = 0xffffffff;
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeDetail structure
+///////////////////////////////////////////////////////////////////////////////
+struct NodeDetail
+{
+    Symbol              Tag                 = kEmptySymbol;
+    Symbol              SourceCodeTemplate  = kEmptySymbol;
+    std::string         TexturePath;
+    TextureDimension    TextureDimension = TextureDimension::None;
+    SamplerType         Sampler          = LinearWrap;
+    float               Values[4]        = {};
+    float               Pos[2]           = {};
+    float               Size[2]          = {};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphStorage class
+///////////////////////////////////////////////////////////////////////////////
+class GraphStorage
+{
+public:
+    void Clear();
+    void Reserve(uint32_t nodeCount, uint32_t slotCount);
+
+    NodeIndex AddNode(NodeType type, QualityLevel minQuality = QualityLevel::Low, int fallbackInput = -1);
+    SlotIndex AddSlot(NodeIndex node, SlotType kind, DataType type, uint64_t varId = 0);
+    bool Connect(SlotIndex output, SlotIndex input);
+
+    uint32_t GetNodeCount() const;
+    uint32_t GetSlotCount() const;
+
+    NodeType     GetNodeType    (NodeIndex node) const;
+    SlotIndex    GetSlotBegin   (NodeIndex node) const;
+    uint32_t     GetSlotCount   (NodeIndex node) const;
+    QualityLevel GetMinQuality  (NodeIndex node) const;
+    NodeDetail&       GetDetail (NodeIndex node);
+    const NodeDetail& GetDetail (NodeIndex node) const;
+
+    SlotType     GetSlotKind    (SlotIndex slot) const;
+    DataType     GetSlotType    (SlotIndex slot) const;
+    NodeIndex    GetSlotOwner   (SlotIndex slot) const;
+    SlotIndex    GetSlotPrev    (SlotIndex slot) const;
+    uint64_t     GetSlotVarId   (SlotIndex slot) const;
+
+    bool IsActive(NodeIndex node, QualityLevel quality) const;
+    bool IsValid(NodeIndex node) const;
+    SlotIndex GetFallbackSlot(NodeIndex node) const;
+    void CollectNodes(NodeIndex root, QualityLevel quality, std::vector<NodeIndex>& result) const;
+
+private:
+    // ノード属性(コード生成・検証で参照するもの) ---
+    std::vector<uint8_t>    m_NodeType;
+    std::vector<uint32_t>   m_SlotBegin;
+    std::vector<uint32_t>   m_SlotCount;
+    std::vector<uint8_t>    m_MinQuality;
+    std::vector<int32_t>    m_FallbackInput;
+
+    // ノード属性(参照頻度の低いもの) ---
+    std::vector<NodeDetail> m_Detail;
+
+    // スロット属性 ---
+    std::vector<uint8_t>    m_SlotKind;
+    std::vector<uint8_t>    m_SlotType;
+    std::vector<uint32_t>   m_SlotOwner;
+    std::vector<uint32_t>   m_SlotPrev;
+    std::vector<uint64_t>   m_SlotVarId;
+};
@@ -0,0 +1,77 @@
+﻿#pragma once
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeType enum
+//////////////////////////////////////////////////////////////////////////////
+enum NodeType
+{
+    Function,
+    Texture,
+    Constant,
+    StageOutput,
+    SubGraphNode,
+    SubGraphInput,
+    SubGraphOutput,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SlotType enum
+///////////////////////////////////////////////////////////////////////////////
+enum SlotType
+{
+    Input,
+    Output,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// TextureDimension enum
+///////////////////////////////////////////////////////////////////////////////
+enum TextureDimension
+{
+    None,
+    Texture1D,
+    Texture2D,
+    Texture3D,
+    TextureCube,
+    Texture1DArray,
+    Texture2DArray,
+    TextureCubeArray,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// SamplerType enum
+///////////////////////////////////////////////////////////////////////////////
+enum SamplerType
+{
+    PointWrap,
+    PointClamp,
+    PointMirror,
+    LinearWrap,
+    LinearClamp,
+    LinearMirror,
+    AnisotropicWrap,
+    AnisotropicClamp,
+    AnisotropicMirror,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// DataType enum
+///////////////////////////////////////////////////////////////////////////////
+enum DataType
+{
+    Float1,
+    Float2,
+    Float3,
+    Float4,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// QualityLevel enum
+///////////////////////////////////////////////////////////////////////////////
+enum QualityLevel
+{
+    Low,
+    Medium,
+    High,
+};
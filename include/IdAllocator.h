@@ -0,0 +1,35 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <cstdint>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// IdAllocator class
+///////////////////////////////////////////////////////////////////////////////
+class IdAllocator
+{
+public:
+    static const uint64_t kBlockSize = 256;     // スレッド毎にまとめて確保する番号数.
+
+    IdAllocator();
+
+    //-------------------------------------------------------------------------
+    //! @brief      番号を割り当てます.
+    //!
+    //! @note       スレッド毎に確保したブロックから払い出すため，複数の
+    //!             スレッドから同時に呼び出せます. 1つのスレッドだけで
+    //!             割り当てる場合は1から連番になります.
+    //-------------------------------------------------------------------------
+    uint64_t Allocate();
+
+private:
+    uint64_t                m_Serial;   // スレッド毎のブロックを識別する通し番号.
+    std::atomic<uint64_t>   m_Next;     // 未確保のブロックの先頭番号.
+
+    IdAllocator     (const IdAllocator&) = delete;
+    void operator = (const IdAllocator&) = delete;
+};
@@ -0,0 +1,95 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+class EditData;
+
+///////////////////////////////////////////////////////////////////////////////
+// CatalogHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct CatalogHeader
+{
+    uint32_t    Magic;          //!< マジック('SCAT').
+    uint32_t    Version;        //!< ファイルバージョン.
+    uint32_t    EntryCount;     //!< エントリー数.
+    uint32_t    TextureCount;   //!< テクスチャ表の要素数.
+    uint32_t    StringSize;     //!< 文字列データのサイズ.
+    uint32_t    Reserved;       //!< 予約領域.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CatalogEntry structure
+///////////////////////////////////////////////////////////////////////////////
+struct CatalogEntry
+{
+    uint64_t    GraphHash;      //!< 保存時のグラフのハッシュ値.
+    uint64_t    CodeHash;       //!< 最後にシェーダを生成したときのグラフのハッシュ値(未生成は0).
+    uint32_t    Path;           //!< フォルダからの相対パスの文字列オフセット.
+    uint32_t    NodeCount;      //!< ノード数.
+    uint32_t    TextureBegin;   //!< テクスチャ表の先頭位置.
+    uint32_t    TextureCount;   //!< 参照するテクスチャ数.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// CatalogItem structure
+///////////////////////////////////////////////////////////////////////////////
+struct CatalogItem
+{
+    std::string                 Path;               // フォルダからの相対パス.
+    uint64_t                    GraphHash   = 0;    // 保存時のグラフのハッシュ値.
+    uint64_t                    CodeHash    = 0;    // 最後にシェーダを生成したときのグラフのハッシュ値(未生成は0).
+    uint32_t                    NodeCount   = 0;    // ノード数.
+    std::vector<std::string>    Textures;           // 参照するテクスチャ(重複なし).
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      編集データからカタログの項目を作成します.
+//!
+//!             パスは設定しません.
+//-----------------------------------------------------------------------------
+void CaptureCatalogItem(EditData& data, CatalogItem& item);
+
+///////////////////////////////////////////////////////////////////////////////
+// ProjectCatalog class
+///////////////////////////////////////////////////////////////////////////////
+class ProjectCatalog
+{
+public:
+    static const char* kFileName;   // フォルダ直下に置くカタログのファイル名.
+
+    bool Load(const char* folder);
+    bool Save() const;
+    void Reset(const char* folder);
+
+    bool Contains(const std::string& path) const;
+    void Update(const std::string& path, const CatalogItem& item);
+    void Inherit(const ProjectCatalog& previous);
+    void Search(const char* text, std::vector<uint32_t>& result) const;
+
+    //-------------------------------------------------------------------------
+    //! @brief      ファイルを登録するカタログのフォルダを探します.
+    //!
+    //! @note       カタログのある祖先フォルダのうち最も外側のものを返し，
+    //!             無ければファイルと同じフォルダを返します.
+    //-------------------------------------------------------------------------
+    static std::string FindFolder(const std::string& path);
+
+    bool IsBroken() const;
+    const std::string& GetFolder() const;
+    const std::vector<CatalogItem>& GetItems() const;
+    std::string GetFullPath(const CatalogItem& item) const;
+
+private:
+    std::string                 m_Folder;
+    std::vector<CatalogItem>    m_Items;            // 相対パスの昇順.
+    bool                        m_Broken = false;   // 読み込めないカタログファイルがあったか.
+};
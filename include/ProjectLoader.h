@@ -0,0 +1,68 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <EditData.h>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ProjectMaterial structure
+///////////////////////////////////////////////////////////////////////////////
+struct ProjectMaterial
+{
+    std::string                 Path;           // グラフファイルのパス.
+    uint64_t                    FileSize = 0;   // ファイルサイズ.
+    std::unique_ptr<EditData>   pData;          // 編集データ(読み込み失敗時は nullptr).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ProjectLoader class
+///////////////////////////////////////////////////////////////////////////////
+class ProjectLoader
+{
+public:
+    static const char* kPackFileName;   // プロジェクトフォルダに出力するシェーダパックの名前.
+
+    ProjectLoader();
+    ~ProjectLoader();
+
+    bool Start(const char* folder);
+    bool Poll();
+    void Wait();
+
+    bool IsBusy() const;
+    float GetProgress() const;
+    const std::string& GetFolder() const;
+    std::vector<ProjectMaterial>& GetMaterials();
+    uint32_t GetFailedCount() const;
+    double GetLoadMsec() const;
+    bool ExportPack();
+
+private:
+    std::vector<std::thread>                m_Workers;
+    std::vector<ProjectMaterial>            m_Pending;              // 読み込み中のマテリアル.
+    std::vector<uint32_t>                   m_Order;                // 読み込む順番(大きいファイルが先).
+    std::atomic<uint32_t>                   m_NextIndex;            // 次に読み込む m_Order の位置.
+    std::atomic<uint32_t>                   m_LoadedCount;          // 読み込みを終えた数.
+    std::string                             m_PendingFolder;
+    std::chrono::steady_clock::time_point   m_Begin;
+    bool                                    m_Loading       = false;    // 公開していない読み込みがあるか.
+
+    std::string                             m_Folder;               // 公開済みのプロジェクト.
+    std::vector<ProjectMaterial>            m_Materials;
+    uint32_t                                m_FailedCount   = 0;
+    double                                  m_LoadMsec      = 0.0;
+
+    void Run();
+
+    ProjectLoader   (const ProjectLoader&) = delete;
+    void operator = (const ProjectLoader&) = delete;
+};
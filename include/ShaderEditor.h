@@ -5,18 +5,16 @@
 //-----------------------------------------------------------------------------
 #include <d3d11.h>
 #include <EditData.h>
+#include <EditHistory.h>
+#include <EditJournal.h>
+#include <GraphSaver.h>
+#include <ProjectCatalog.h>
+#include <ProjectLoader.h>
+#include <ThumbnailCache.h>
+#include <BuiltinNode.h>
 #include <imgui/imgui.h>
 
 
-///////////////////////////////////////////////////////////////////////////////
-// Link structure
-///////////////////////////////////////////////////////////////////////////////
-struct Link
-{
-    Slot* Lhs = nullptr;
-    Slot* Rhs = nullptr;
-};
-
 ///////////////////////////////////////////////////////////////////////////////
 // Editor class
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,6 +37,7 @@ public:
     Editor();
     ~Editor();
     void Render(uint32_t w, uint32_t h);
+    void SetDevice(ID3D11Device* pDevice);
 
     void SetPreview(ImTextureID preview) 
     { m_Preview = preview; }
@@ -48,13 +47,27 @@ private:
     // private variables.
     //=========================================================================
     EditData            m_EditData;                 //!< 編集データ.
+    EditHistory         m_History;                  //!< 編集履歴.
+    EditJournal         m_Journal;                  //!< 自動保存用の編集ジャーナル.
+    GraphSaver          m_Saver;                    //!< バックグラウンド保存.
+    ThumbnailCache      m_Thumbnails;               //!< テクスチャのサムネイル.
+    ProjectLoader       m_Project;                  //!< プロジェクト内の全マテリアル.
+    ProjectCatalog      m_Catalog;                  //!< 表示中のカタログ.
+    CatalogItem         m_SaveItem;                 //!< 保存中のグラフのカタログ項目.
+    std::vector<uint32_t> m_CatalogHits;            //!< カタログの検索結果.
+    char                m_CatalogFilter[256] = {};  //!< カタログの検索文字列.
+    double              m_CatalogSearchMsec = 0.0;  //!< カタログの検索時間.
+    bool                m_ShowCatalog = false;      //!< カタログを表示するか.
+    bool                m_CompressSave = false;     //!< 圧縮コンテナで保存するか.
     ImVec2              m_Size;                     //!< ウィンドウサイズ.
-    Node*               m_pSelectedNode = nullptr;  //!< 選択済みノード.
-    Node*               m_pHoveredNode  = nullptr;  //!< ホバーノード.
+    NodeHandle          m_SelectedNode;             //!< 選択済みノード.
+    NodeHandle          m_HoveredNode;              //!< ホバーノード.
+    std::vector<NodeHandle> m_SelectedNodes;        //!< 複数選択ノード.
+    NodeClipboard       m_Clipboard;                //!< コピーしたノード.
     std::string         m_FilePath;                 //!< 中間ファイルパス.
+    std::string         m_Status;                   //!< 直前のファイル操作の結果.
     ImVec2              m_GeneratePos;              //!< ノード生成位置.
     ImVec2              m_Scroll;                   //!< スクロール.
-    std::vector<Link>   m_Links;
     ImTextureID         m_Preview = nullptr;
 
     //=========================================================================
@@ -63,18 +76,33 @@ private:
     void DrawEditPanel();
     void DrawPropPanel();
     void DrawPreviewPanel();
+    void DrawCatalogPanel();
 
     void DrawNode(Node* node, ImVec2& offset, bool& openContextMenu);
     void DrawSlot(Slot* slot);
     void DrawContextMenu();
 
-    void AddLink(Slot* lhs, Slot* rhs);
-    void RemoveLink(Slot* slot);
+    void DrawNodeMenu(NodeCategory category);
+    void DrawSubGraphNodeMenu();
+
+    Node* GetSelectedNode() const;
+    std::vector<Node*> GetSelectedNodes() const;
+    void ClearSelection();
+
+    void Undo();
+    void Redo();
+    void Copy();
+    void Paste(const ImVec2& pos);
 
-    void DrawOperatorNodeMenu();
-    void DrawTextureNodeMenu();
-    void DrawPackingNodeMenu();
-    void DrawConstantNodeMenu();
-    void DrawBuiltinFuncNodeMenu();
-    void DrawPresetFuncNodeMenu();
+    void NewFile();
+    void OpenFile();
+    void LoadFile(const std::string& path);
+    void SaveFile(bool saveAs);
+    void PollSave();
+    void OpenProject();
+    void PollProject();
+    void RebuildCatalog();
+    void OpenCatalog();
+    void SearchCatalog();
+    void UpdateCatalog(const std::string& path, const CatalogItem& item);
 };
\ No newline at end of file
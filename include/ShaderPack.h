@@ -0,0 +1,97 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderPackHeader structure
+///////////////////////////////////////////////////////////////////////////////
+struct ShaderPackHeader
+{
+    uint32_t    Magic;          //!< マジック('SPAK').
+    uint32_t    Version;        //!< ファイルバージョン.
+    uint32_t    EntryCount;     //!< エントリー数.
+    uint32_t    Reserved;       //!< 予約領域.
+    uint64_t    IndexOffset;    //!< インデックスまでのオフセット.
+    uint64_t    DataOffset;     //!< 文字列データまでのオフセット.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderPackEntry structure
+///////////////////////////////////////////////////////////////////////////////
+struct ShaderPackEntry
+{
+    uint64_t    KeyHash;        //!< 名前のハッシュ値(インデックスはこの値で昇順).
+    uint64_t    CodeHash;       //!< シェーダコードのハッシュ値.
+    uint64_t    NameOffset;     //!< 名前までのオフセット(ファイル先頭から, 終端文字付き).
+    uint64_t    CodeOffset;     //!< シェーダコードまでのオフセット(ファイル先頭から, 終端文字付き).
+    uint32_t    NameSize;       //!< 名前の長さ(終端文字を含まない).
+    uint32_t    CodeSize;       //!< シェーダコードの長さ(終端文字を含まない).
+    uint32_t    Quality;        //!< 品質.
+    uint32_t    Reserved;       //!< 予約領域.
+};
+
+//-----------------------------------------------------------------------------
+//! @brief      シェーダパック用のハッシュ値(FNV-1a 64bit)を計算します.
+//-----------------------------------------------------------------------------
+uint64_t ComputeShaderPackHash(const char* data, size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderPackWriter class
+///////////////////////////////////////////////////////////////////////////////
+class ShaderPackWriter
+{
+public:
+    bool Add(const char* name, uint32_t quality, const std::string& code);
+    bool Write(const char* path) const;
+    void Clear();
+
+private:
+    struct Item
+    {
+        std::string Name;
+        std::string Code;
+        uint32_t    Quality;
+    };
+
+    std::vector<Item>               m_Items;
+    std::unordered_set<std::string> m_Names;    // 追加済みの名前(重複チェック用).
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderPackReader class
+///////////////////////////////////////////////////////////////////////////////
+class ShaderPackReader
+{
+public:
+    ShaderPackReader();
+    ~ShaderPackReader();
+
+    bool Open(const char* path);
+    void Close();
+
+    uint32_t GetCount() const;
+    const ShaderPackEntry* GetEntry(uint32_t index) const;
+    const ShaderPackEntry* Find(uint64_t keyHash) const;
+    const ShaderPackEntry* Find(const char* name) const;
+    const char* GetName(const ShaderPackEntry* entry) const;
+    const char* GetCode(const ShaderPackEntry* entry) const;
+
+private:
+    void*                   m_hFile     = nullptr;
+    void*                   m_hMapping  = nullptr;
+    const uint8_t*          m_pData     = nullptr;
+    const ShaderPackEntry*  m_pEntries  = nullptr;
+    uint32_t                m_Count     = 0;
+
+    bool Validate(const uint8_t* data, uint64_t size);
+
+    ShaderPackReader    (const ShaderPackReader&) = delete;
+    void operator =     (const ShaderPackReader&) = delete;
+};
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+
+
+//-----------------------------------------------------------------------------
+// Type Definitions.
+//-----------------------------------------------------------------------------
+typedef uint32_t Symbol;
+
+static const Symbol kEmptySymbol = 0;   // 空文字列.
+
+//-----------------------------------------------------------------------------
+//! @brief      文字列を登録し，シンボルを取得します.
+//!
+//! @note       同じ内容の文字列には常に同じシンボルが返されます.
+//!             登録された文字列はプログラム終了まで解放されません.
+//-----------------------------------------------------------------------------
+Symbol InternString(const char* text);
+Symbol InternString(const std::string& text);
+
+//-----------------------------------------------------------------------------
+//! @brief      シンボルに対応する文字列を取得します.
+//-----------------------------------------------------------------------------
+const char* GetSymbolString(Symbol symbol);
+
+//-----------------------------------------------------------------------------
+//! @brief      登録済みの文字列数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetSymbolCount();
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <imgui/imgui.h>
+
+
+//-----------------------------------------------------------------------------
+// Forward Declarations.
+//-----------------------------------------------------------------------------
+struct IWICImagingFactory;
+
+///////////////////////////////////////////////////////////////////////////////
+// ThumbnailState enum
+///////////////////////////////////////////////////////////////////////////////
+enum ThumbnailState
+{
+    ThumbnailLoading,       // デコード待ち.
+    ThumbnailReady,         // 表示可能.
+    ThumbnailFailed,        // 読み込み失敗.
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// ThumbnailCache class
+///////////////////////////////////////////////////////////////////////////////
+class ThumbnailCache
+{
+public:
+    static const uint32_t kSize = 64;   // サムネイルの長辺のピクセル数.
+
+    ThumbnailCache();
+    ~ThumbnailCache();
+
+    bool Init(ID3D11Device* pDevice);
+    void Term();
+    ThumbnailState Request(const std::string& path, ImTextureID& texture);
+
+private:
+    struct Entry
+    {
+        ThumbnailState                                      State = ThumbnailLoading;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    pSRV;
+    };
+
+    Microsoft::WRL::ComPtr<ID3D11Device>        m_pDevice;
+    std::vector<std::thread>                    m_Workers;
+    std::mutex                                  m_Mutex;
+    std::condition_variable                     m_Condition;
+    std::deque<std::string>                     m_Queue;        // デコード待ちのパス.
+    std::unordered_map<std::string, Entry>      m_Entries;      // パス毎のサムネイル.
+    bool                                        m_Quit = false;
+
+    void Run();
+    bool Decode(IWICImagingFactory* pFactory, const std::string& path, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& result);
+
+    ThumbnailCache  (const ThumbnailCache&) = delete;
+    void operator = (const ThumbnailCache&) = delete;
+};
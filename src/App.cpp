@@ -479,6 +479,8 @@ bool App::OnInitApp()
     if (!GuiMgr::GetInstance().Init(m_pDevice.Get(), m_pDeviceContext.Get(), m_hWnd, m_Width, m_Height))
     { return false; }
 
+    m_Editor.SetDevice(m_pDevice.Get());
+
     return true;
 }
 
@@ -487,6 +489,7 @@ bool App::OnInitApp()
 //-------------------------------------------------------------------------------------------------
 void App::OnTermApp()
 {
+    m_Editor.SetDevice(nullptr);
     GuiMgr::GetInstance().Term();
 }
 
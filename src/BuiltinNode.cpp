@@ -1,382 +1,401 @@
-
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
 #include <BuiltinNode.h>
+#include <cstring>
+
+
+namespace {
 
-const std::string kType[] = {
-    std::string("float"),
-    std::string("float2"),
-    std::string("float3"),
-    std::string("float4"),
+//-----------------------------------------------------------------------------
+// Slot Descriptors.
+//-----------------------------------------------------------------------------
+constexpr SlotDescriptor kConstantSlots[4][1] = {
+    { { SlotType::Output, DataType::Float1, "value" } },
+    { { SlotType::Output, DataType::Float2, "value" } },
+    { { SlotType::Output, DataType::Float3, "value" } },
+    { { SlotType::Output, DataType::Float4, "value" } },
 };
 
+constexpr SlotDescriptor kColor3Slots[] = {
+    { SlotType::Output, DataType::Float3, "color" },
+};
 
-Node* Sample1D()
-{
-    std::string code;
-    code += "float4 %Output0 = %Texture.Sample(%Sampler, %Input0);\n";
+constexpr SlotDescriptor kColor4Slots[] = {
+    { SlotType::Output, DataType::Float4, "color" },
+};
 
-    auto node = new Node();
-    node->Type = NodeType::Texture;
-    node->Tag = "Sample1D";
-    node->AddInput1("texcoord");
-    node->AddOutput4("result");
-    node->TextureDimension = TextureDimension::Texture1D;
-    node->SourceCodeTemplate = code;
+constexpr SlotDescriptor kFromFloat2Slots[] = {
+    { SlotType::Input,  DataType::Float2, "input" },
+    { SlotType::Output, DataType::Float1, "x" },
+    { SlotType::Output, DataType::Float1, "y" },
+};
 
-    return node;
-}
+constexpr SlotDescriptor kFromFloat3Slots[] = {
+    { SlotType::Input,  DataType::Float3, "input" },
+    { SlotType::Output, DataType::Float1, "x" },
+    { SlotType::Output, DataType::Float1, "y" },
+    { SlotType::Output, DataType::Float1, "z" },
+};
 
-Node* Sample2D()
-{
-    std::string code;
-    code += "float4 %Output0 = %Texture.Sample(%Sampler, %Input0);\n";
+constexpr SlotDescriptor kFromFloat4Slots[] = {
+    { SlotType::Input,  DataType::Float4, "input" },
+    { SlotType::Output, DataType::Float1, "x" },
+    { SlotType::Output, DataType::Float1, "y" },
+    { SlotType::Output, DataType::Float1, "z" },
+    { SlotType::Output, DataType::Float1, "w" },
+};
 
-    auto node = new Node();
-    node->Type = NodeType::Texture;
-    node->Tag = "Sample2D";
-    node->AddInput2("texcoord");
-    node->AddOutput4("result");
-    node->TextureDimension = TextureDimension::Texture2D;
-    node->SourceCodeTemplate = code;
+constexpr SlotDescriptor kToFloat2Slots[] = {
+    { SlotType::Input,  DataType::Float1, "x" },
+    { SlotType::Input,  DataType::Float1, "y" },
+    { SlotType::Output, DataType::Float2, "output" },
+};
 
-    return node;
-}
+constexpr SlotDescriptor kToFloat3Slots[] = {
+    { SlotType::Input,  DataType::Float1, "x" },
+    { SlotType::Input,  DataType::Float1, "y" },
+    { SlotType::Input,  DataType::Float1, "z" },
+    { SlotType::Output, DataType::Float3, "output" },
+};
 
-Node* ConstantValue(DataType type)
-{
-    std::string code;
+constexpr SlotDescriptor kToFloat4Slots[] = {
+    { SlotType::Input,  DataType::Float1, "x" },
+    { SlotType::Input,  DataType::Float1, "y" },
+    { SlotType::Input,  DataType::Float1, "z" },
+    { SlotType::Input,  DataType::Float1, "w" },
+    { SlotType::Output, DataType::Float4, "output" },
+};
 
-    if (type == DataType::Float1)
+constexpr SlotDescriptor kBinaryOpSlots[4][3] = {
     {
-        code += "const float %Output0 = %Value0;\n";
-    }
-    else if (type == DataType::Float2)
+        { SlotType::Input,  DataType::Float1, "lhs" },
+        { SlotType::Input,  DataType::Float1, "rhs" },
+        { SlotType::Output, DataType::Float1, "output" },
+    },
     {
-        code += "const float2 %Output0 = float2(%Value0, %Value1);\n";
-    }
-    else if (type == DataType::Float3)
+        { SlotType::Input,  DataType::Float2, "lhs" },
+        { SlotType::Input,  DataType::Float2, "rhs" },
+        { SlotType::Output, DataType::Float2, "output" },
+    },
     {
-        code += "const float3 %Output0 = float3(%Value0, %Value1, %Value2);\n";
-    }
-    else if (type == DataType::Float4)
+        { SlotType::Input,  DataType::Float3, "lhs" },
+        { SlotType::Input,  DataType::Float3, "rhs" },
+        { SlotType::Output, DataType::Float3, "output" },
+    },
     {
-        code += "const float4 %Output0 = float4(%Value0, %Value1, %Value2, %Value3);\n";
-    }
+        { SlotType::Input,  DataType::Float4, "lhs" },
+        { SlotType::Input,  DataType::Float4, "rhs" },
+        { SlotType::Output, DataType::Float4, "output" },
+    },
+};
 
-    auto node = new Node();
-    node->Type = NodeType::Constant;
-    node->Tag = "Constant";
-    node->AddOutput("value", type);
-    node->SourceCodeTemplate = code;
+constexpr SlotDescriptor kTexCoordSlots[] = {
+    { SlotType::Output, DataType::Float2, "uv" },
+};
 
-    return node;
-}
+constexpr SlotDescriptor kNormalSlots[] = {
+    { SlotType::Output, DataType::Float3, "normal" },
+};
 
-Node* Color3()
-{
-    std::string code;
-    code += "const float3 %Output0 = float3(%Value0, %Value1, %Value2);\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Constant;
-    node->Tag = "Color3";
-    node->AddOutput3("color");
-    node->SourceCodeTemplate = code;
-    node->AsColor = true;
-    node->Values[0] = 1.0f;
-    node->Values[1] = 1.0f;
-    node->Values[2] = 1.0f;
-    node->Values[3] = 1.0f;
+constexpr SlotDescriptor kTangentSlots[] = {
+    { SlotType::Output, DataType::Float3, "tangent" },
+};
 
-    return node;
-}
+constexpr SlotDescriptor kBitangentSlots[] = {
+    { SlotType::Output, DataType::Float3, "bitangent" },
+};
 
-Node* Color4()
-{
-    std::string code;
-    code += "const float4 %Output0 = float4(%Value0, %Value1, %Value2, %Value3);\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Constant;
-    node->Tag = "Color4";
-    node->AddOutput4("color");
-    node->SourceCodeTemplate = code;
-    node->AsColor = true;
-    node->Values[0] = 1.0f;
-    node->Values[1] = 1.0f;
-    node->Values[2] = 1.0f;
-    node->Values[3] = 1.0f;
+constexpr SlotDescriptor kSample1DSlots[] = {
+    { SlotType::Input,  DataType::Float1, "texcoord" },
+    { SlotType::Output, DataType::Float4, "result" },
+};
 
-    return node;
-}
+constexpr SlotDescriptor kSample2DSlots[] = {
+    { SlotType::Input,  DataType::Float2, "texcoord" },
+    { SlotType::Output, DataType::Float4, "result" },
+};
 
-Node* FromFloat2()
-{
-    std::string code;
-    code += "float %Output0 = %Input0.x;\n";
-    code += "float %Output1 = %Input0.y;\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "FromFloat2";
-    node->AddInput2("input");
-    node->AddOutput1("x");
-    node->AddOutput1("y");
-    node->SourceCodeTemplate = code;
+#define SLOTS(x)    x, uint32_t(sizeof(x) / sizeof(x[0]))
+
+#define BINARY_OP(op, type, index) {                                \
+    CategoryOperator, "operator " op, type, NodeType::Function,     \
+    "operator " op, type " %Output0 = %Input0 " op " %Input1;\n",   \
+    SLOTS(kBinaryOpSlots[index]), TextureDimension::None, false, {} }
+
+#define FUNCTION(tag, code, slots) {                                \
+    CategoryBuiltinFunc, nullptr, tag, NodeType::Function,          \
+    tag, code, SLOTS(slots), TextureDimension::None, false, {} }
+
+#define PACKING(tag, code, slots) {                                 \
+    CategoryPacking, nullptr, tag, NodeType::Function,              \
+    tag, code, SLOTS(slots), TextureDimension::None, false, {} }
+
+//-----------------------------------------------------------------------------
+// Node Descriptors.
+//-----------------------------------------------------------------------------
+constexpr NodeDescriptor kConstant[4] = {
+    { CategoryConstant, nullptr, "float",  NodeType::Constant, "Constant",
+      "const float %Output0 = %Value0;\n",
+      SLOTS(kConstantSlots[0]), TextureDimension::None, false, {} },
+    { CategoryConstant, nullptr, "float2", NodeType::Constant, "Constant",
+      "const float2 %Output0 = float2(%Value0, %Value1);\n",
+      SLOTS(kConstantSlots[1]), TextureDimension::None, false, {} },
+    { CategoryConstant, nullptr, "float3", NodeType::Constant, "Constant",
+      "const float3 %Output0 = float3(%Value0, %Value1, %Value2);\n",
+      SLOTS(kConstantSlots[2]), TextureDimension::None, false, {} },
+    { CategoryConstant, nullptr, "float4", NodeType::Constant, "Constant",
+      "const float4 %Output0 = float4(%Value0, %Value1, %Value2, %Value3);\n",
+      SLOTS(kConstantSlots[3]), TextureDimension::None, false, {} },
+};
 
-    return node;
-}
+constexpr NodeDescriptor kColor3 = {
+    CategoryConstant, nullptr, "color3", NodeType::Constant, "Color3",
+    "const float3 %Output0 = float3(%Value0, %Value1, %Value2);\n",
+    SLOTS(kColor3Slots), TextureDimension::None, true, { 1.0f, 1.0f, 1.0f, 1.0f } };
+
+constexpr NodeDescriptor kColor4 = {
+    CategoryConstant, nullptr, "color4", NodeType::Constant, "Color4",
+    "const float4 %Output0 = float4(%Value0, %Value1, %Value2, %Value3);\n",
+    SLOTS(kColor4Slots), TextureDimension::None, true, { 1.0f, 1.0f, 1.0f, 1.0f } };
+
+constexpr NodeDescriptor kToFloat2 = PACKING("ToFloat2",
+    "float2 %Output0 = float2(%Input0, %Input1);\n",
+    kToFloat2Slots);
+
+constexpr NodeDescriptor kToFloat3 = PACKING("ToFloat3",
+    "float3 %Output0 = float3(%Input0, %Input1, %Input2);\n",
+    kToFloat3Slots);
+
+constexpr NodeDescriptor kToFloat4 = PACKING("ToFloat4",
+    "float4 %Output0 = float4(%Input0, %Input1, %Input2, %Input3);\n",
+    kToFloat4Slots);
+
+constexpr NodeDescriptor kFromFloat2 = PACKING("FromFloat2",
+    "float %Output0 = %Input0.x;\n"
+    "float %Output1 = %Input0.y;\n",
+    kFromFloat2Slots);
+
+constexpr NodeDescriptor kFromFloat3 = PACKING("FromFloat3",
+    "float %Output0 = %Input0.x;\n"
+    "float %Output1 = %Input0.y;\n"
+    "float %Output2 = %Input0.z;\n",
+    kFromFloat3Slots);
+
+constexpr NodeDescriptor kFromFloat4 = PACKING("FromFloat4",
+    "float %Output0 = %Input0.x;\n"
+    "float %Output1 = %Input0.y;\n"
+    "float %Output2 = %Input0.z;\n"
+    "float %Output3 = %Input0.w;\n",
+    kFromFloat4Slots);
+
+constexpr NodeDescriptor kOpAdd[4] = {
+    BINARY_OP("+", "float",  0),
+    BINARY_OP("+", "float2", 1),
+    BINARY_OP("+", "float3", 2),
+    BINARY_OP("+", "float4", 3),
+};
 
-Node* FromFloat3()
-{
-    std::string code;
-    code += "float %Output0 = %Input0.x;\n";
-    code += "float %Output1 = %Input0.y;\n";
-    code += "float %Output2 = %Input0.z;\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "FromFloat3";
-    node->AddInput3("input");
-    node->AddOutput1("x");
-    node->AddOutput1("y");
-    node->AddOutput1("z");
-    node->SourceCodeTemplate = code;
+constexpr NodeDescriptor kOpSub[4] = {
+    BINARY_OP("-", "float",  0),
+    BINARY_OP("-", "float2", 1),
+    BINARY_OP("-", "float3", 2),
+    BINARY_OP("-", "float4", 3),
+};
 
-    return node;
-}
+constexpr NodeDescriptor kOpMul[4] = {
+    BINARY_OP("*", "float",  0),
+    BINARY_OP("*", "float2", 1),
+    BINARY_OP("*", "float3", 2),
+    BINARY_OP("*", "float4", 3),
+};
 
-Node* FromFloat4()
-{
-    std::string code;
-    code += "float %Output0 = %Input0.x;\n";
-    code += "float %Output1 = %Input0.y;\n";
-    code += "float %Output2 = %Input0.z;\n";
-    code += "float %Output3 = %Input0.w;\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "FromFloat4";
-    node->AddInput4("input");
-    node->AddOutput1("x");
-    node->AddOutput1("y");
-    node->AddOutput1("z");
-    node->AddOutput1("w");
-    node->SourceCodeTemplate = code;
+constexpr NodeDescriptor kOpDiv[4] = {
+    BINARY_OP("/", "float",  0),
+    BINARY_OP("/", "float2", 1),
+    BINARY_OP("/", "float3", 2),
+    BINARY_OP("/", "float4", 3),
+};
 
-    return node;
-}
+constexpr NodeDescriptor kTexCoord[4] = {
+    FUNCTION("TexCoord0", "float2 %Output0 = input.TexCoord0;\n", kTexCoordSlots),
+    FUNCTION("TexCoord1", "float2 %Output0 = input.TexCoord1;\n", kTexCoordSlots),
+    FUNCTION("TexCoord2", "float2 %Output0 = input.TexCoord2;\n", kTexCoordSlots),
+    FUNCTION("TexCoord3", "float2 %Output0 = input.TexCoord3;\n", kTexCoordSlots),
+};
 
-Node* ToFloat2()
-{
-    std::string code;
-    code += "float2 %Output0 = float2(%Input0, %Input1);\n";
+constexpr NodeDescriptor kGeometryNormal = FUNCTION("Geometry Normal",
+    "float3 %Output0 = geometry.Normal;\n",
+    kNormalSlots);
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "ToFloat2";
-    node->AddInput1("x");
-    node->AddInput1("y");
-    node->AddOutput2("output");
-    node->SourceCodeTemplate = code;
+constexpr NodeDescriptor kGeometryTangent = FUNCTION("Geometry Tangent",
+    "float3 %Output0 = geometry.Tangent;\n",
+    kTangentSlots);
 
-    return node;
-}
+constexpr NodeDescriptor kGeometryBitangent = FUNCTION("Geometry Bitangent",
+    "float3 %Output0 = geometry.Bitangent;\n",
+    kBitangentSlots);
 
-Node* ToFloat3()
-{
-    std::string code;
-    code += "float3 %Output0 = float3(%Input0, %Input1, %Input2);\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "ToFloat3";
-    node->AddInput1("x");
-    node->AddInput1("y");
-    node->AddInput1("z");
-    node->AddOutput3("output");
-    node->SourceCodeTemplate = code;
+constexpr NodeDescriptor kSample1D = {
+    CategoryTexture, nullptr, "Sample1D", NodeType::Texture, "Sample1D",
+    "float4 %Output0 = %Texture.Sample(%Sampler, %Input0);\n",
+    SLOTS(kSample1DSlots), TextureDimension::Texture1D, false, {} };
 
-    return node;
-}
+constexpr NodeDescriptor kSample2D = {
+    CategoryTexture, nullptr, "Sample2D", NodeType::Texture, "Sample2D",
+    "float4 %Output0 = %Texture.Sample(%Sampler, %Input0);\n",
+    SLOTS(kSample2DSlots), TextureDimension::Texture2D, false, {} };
 
-Node* ToFloat4()
-{
-    std::string code;
-    code += "float4 %Output0 = float4(%Input0, %Input1, %Input2, %Input3);\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "ToFloat4";
-    node->AddInput1("x");
-    node->AddInput1("y");
-    node->AddInput1("z");
-    node->AddInput1("w");
-    node->AddOutput4("output");
-    node->SourceCodeTemplate = code;
+#undef PACKING
+#undef FUNCTION
+#undef BINARY_OP
+#undef SLOTS
 
-    return node;
-}
+//-----------------------------------------------------------------------------
+// Registry (メニューの表示順).
+//-----------------------------------------------------------------------------
+constexpr const NodeDescriptor* kRegistry[] = {
+    &kConstant[0], &kConstant[1], &kConstant[2], &kConstant[3],
+    &kColor3, &kColor4,
 
-Node* OpAdd(DataType type)
-{
-    std::string code;
-    code += kType[type] + " %Output0 = %Input0 + %Input1;\n";
+    &kToFloat2, &kToFloat3, &kToFloat4,
+    &kFromFloat2, &kFromFloat3, &kFromFloat4,
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "operator +";
-    node->AddInput("lhs", type);
-    node->AddInput("rhs", type);
-    node->AddOutput("output", type);
-    node->SourceCodeTemplate = code;
+    &kOpAdd[0], &kOpAdd[1], &kOpAdd[2], &kOpAdd[3],
+    &kOpSub[0], &kOpSub[1], &kOpSub[2], &kOpSub[3],
+    &kOpMul[0], &kOpMul[1], &kOpMul[2], &kOpMul[3],
+    &kOpDiv[0], &kOpDiv[1], &kOpDiv[2], &kOpDiv[3],
 
-    return node;
-}
+    &kTexCoord[0], &kTexCoord[1], &kTexCoord[2], &kTexCoord[3],
+    &kGeometryNormal, &kGeometryTangent, &kGeometryBitangent,
 
-Node* OpSub(DataType type)
-{
-    std::string code;
-    code += kType[type] + " %Output0 = %Input0 - %Input1;\n";
+    &kSample1D, &kSample2D,
+};
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "operator -";
-    node->AddInput("lhs", type);
-    node->AddInput("rhs", type);
-    node->AddOutput("output", type);
-    node->SourceCodeTemplate = code;
+} // namespace
 
-    return node;
-}
 
-Node* OpMul(DataType type)
-{
-    std::string code;
-    code += kType[type] + " %Output0 = %Input0 * %Input1;\n";
+//-----------------------------------------------------------------------------
+//      登録済みのノード記述子の数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetNodeDescriptorCount()
+{ return uint32_t(sizeof(kRegistry) / sizeof(kRegistry[0])); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "operator *";
-    node->AddInput("lhs", type);
-    node->AddInput("rhs", type);
-    node->AddOutput("output", type);
-    node->SourceCodeTemplate = code;
+//-----------------------------------------------------------------------------
+//      ノード記述子を取得します.
+//-----------------------------------------------------------------------------
+const NodeDescriptor* GetNodeDescriptor(uint32_t index)
+{
+    if (index >= GetNodeDescriptorCount())
+    { return nullptr; }
 
-    return node;
+    return kRegistry[index];
 }
 
-Node* OpDiv(DataType type)
+//-----------------------------------------------------------------------------
+//      ノード記述子の番号を取得します. 未登録の場合は UINT32_MAX を返します.
+//-----------------------------------------------------------------------------
+uint32_t GetNodeDescriptorIndex(const NodeDescriptor* descriptor)
 {
-    std::string code;
-    code += kType[type] + " %Output0 = %Input0 / %Input1;\n";
+    if (descriptor == nullptr)
+    { return UINT32_MAX; }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "operator /";
-    node->AddInput("lhs", type);
-    node->AddInput("rhs", type);
-    node->AddOutput("output", type);
-    node->SourceCodeTemplate = code;
+    for(uint32_t i=0; i<GetNodeDescriptorCount(); ++i)
+    {
+        if (kRegistry[i] == descriptor)
+        { return i; }
+    }
 
-    return node;
+    return UINT32_MAX;
 }
 
-Node* GetTexCoord0()
+//-----------------------------------------------------------------------------
+//      ノード記述子からノードを生成します.
+//-----------------------------------------------------------------------------
+Node* CreateBuiltinNode(EditData& data, const NodeDescriptor* descriptor)
 {
-    std::string code;
-    code += "float2 %Output0 = input.TexCoord0;\n";
-
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "TexCoord0";
-    node->AddOutput2("uv");
-    node->SourceCodeTemplate = code;
+    auto node = data.CreateNode();
+    node->pDescriptor      = descriptor;
+    node->Type             = descriptor->Type;
+    node->TextureDimension = descriptor->Dimension;
+    node->AsColor          = descriptor->AsColor;
+    memcpy(node->Values, descriptor->Values, sizeof(node->Values));
+
+    node->pSlots.reserve(descriptor->SlotCount);
+    for(uint32_t i=0; i<descriptor->SlotCount; ++i)
+    {
+        auto& slot = descriptor->pSlots[i];
+        if (slot.Kind == SlotType::Input)
+        { node->AddInput(slot.Tag, slot.Type); }
+        else
+        { node->AddOutput(slot.Tag, slot.Type); }
+    }
 
     return node;
 }
 
-Node* GetTexCoord1()
-{
-    std::string code;
-    code += "float2 %Output0 = input.TexCoord1;\n";
+Node* Sample1D(EditData& data)
+{ return CreateBuiltinNode(data, &kSample1D); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "TexCoord1";
-    node->AddOutput2("uv");
-    node->SourceCodeTemplate = code;
+Node* Sample2D(EditData& data)
+{ return CreateBuiltinNode(data, &kSample2D); }
 
-    return node;
-}
+Node* ConstantValue(EditData& data, DataType type)
+{ return CreateBuiltinNode(data, &kConstant[type]); }
 
-Node* GetTexCoord2()
-{
-    std::string code;
-    code += "float2 %Output0 = input.TexCoord2;\n";
+Node* Color3(EditData& data)
+{ return CreateBuiltinNode(data, &kColor3); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "TexCoord2";
-    node->AddOutput2("uv");
-    node->SourceCodeTemplate = code;
+Node* Color4(EditData& data)
+{ return CreateBuiltinNode(data, &kColor4); }
 
-    return node;
-}
+Node* FromFloat2(EditData& data)
+{ return CreateBuiltinNode(data, &kFromFloat2); }
 
-Node* GetTexCoord3()
-{
-    std::string code;
-    code += "float2 %Output0 = input.TexCoord3;\n";
+Node* FromFloat3(EditData& data)
+{ return CreateBuiltinNode(data, &kFromFloat3); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "TexCoord3";
-    node->AddOutput2("uv");
-    node->SourceCodeTemplate = code;
+Node* FromFloat4(EditData& data)
+{ return CreateBuiltinNode(data, &kFromFloat4); }
 
-    return node;
-}
+Node* ToFloat2(EditData& data)
+{ return CreateBuiltinNode(data, &kToFloat2); }
 
+Node* ToFloat3(EditData& data)
+{ return CreateBuiltinNode(data, &kToFloat3); }
 
-Node* GetGeometryNormal()
-{
-    std::string code;
-    code += "float3 %Output0 = geometry.Normal;\n";
+Node* ToFloat4(EditData& data)
+{ return CreateBuiltinNode(data, &kToFloat4); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "Geometry Normal";
-    node->AddOutput3("normal");
-    node->SourceCodeTemplate = code;
+Node* OpAdd(EditData& data, DataType type)
+{ return CreateBuiltinNode(data, &kOpAdd[type]); }
 
-    return node;
-}
+Node* OpSub(EditData& data, DataType type)
+{ return CreateBuiltinNode(data, &kOpSub[type]); }
 
-Node* GetGeometryTangent()
-{
-    std::string code;
-    code += "float3 %Output0 = geometry.Tangent;\n";
+Node* OpMul(EditData& data, DataType type)
+{ return CreateBuiltinNode(data, &kOpMul[type]); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "Geometry Tangent";
-    node->AddOutput3("tangent");
-    node->SourceCodeTemplate = code;
+Node* OpDiv(EditData& data, DataType type)
+{ return CreateBuiltinNode(data, &kOpDiv[type]); }
 
-    return node;
-}
+Node* GetTexCoord0(EditData& data)
+{ return CreateBuiltinNode(data, &kTexCoord[0]); }
 
+Node* GetTexCoord1(EditData& data)
+{ return CreateBuiltinNode(data, &kTexCoord[1]); }
 
-Node* GetGeometryBitangent()
-{
-    std::string code;
-    code += "float3 %Output0 = geometry.Binormal;\n";
+Node* GetTexCoord2(EditData& data)
+{ return CreateBuiltinNode(data, &kTexCoord[2]); }
 
-    auto node = new Node();
-    node->Type = NodeType::Function;
-    node->Tag = "Geometry Bitangent";
-    node->AddOutput3("bitangent");
-    node->SourceCodeTemplate = code;
+Node* GetTexCoord3(EditData& data)
+{ return CreateBuiltinNode(data, &kTexCoord[3]); }
 
-    return node;
-}
\ No newline at end of file
+Node* GetGeometryNormal(EditData& data)
+{ return CreateBuiltinNode(data, &kGeometryNormal); }
+
+Node* GetGeometryTangent(EditData& data)
+{ return CreateBuiltinNode(data, &kGeometryTangent); }
+
+Node* GetGeometryBitangent(EditData& data)
+{ return CreateBuiltinNode(data, &kGeometryBitangent); }
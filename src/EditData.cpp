@@ -3,15 +3,23 @@
 // Includes
 //-----------------------------------------------------------------------------
 #include <EditData.h>
+#include <BuiltinNode.h>
+#include <GraphBinary.h>
+#include <GraphCompression.h>
+#include <GraphStorage.h>
+#include <ShaderPack.h>
 #include <atomic>
-#include <deque>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <map>
+#include <set>
+#include <unordered_map>
 #include <asura_sdk/StringHelper.h>
 
 
 namespace {
 
-uint64_t g_NextId = 1;
-
 static const char* kSamplerName[] = {
     "PointWrap",
     "PointClamp",
@@ -50,477 +58,3072 @@ static const char* kDefaultValueString[] = {
     "float4(0.0f, 0.0f, 0.0f, 0.0f)"
 };
 
+static const char* kTypeName[] = {
+    "float",
+    "float2",
+    "float3",
+    "float4",
+};
+
+static const char* kQualitySuffix[] = {
+    "_low",
+    "_medium",
+    "_high",
+};
+
 //-----------------------------------------------------------------------------
-//      コード生成に必要なノードのみを収集します.
+//      品質を考慮して入力スロットに渡す変数名を解決します.
 //-----------------------------------------------------------------------------
-void CollectNodes(Node* node, std::deque<Node*>& result)
+std::string ResolveVarName(const Slot* input, const GenContext& context)
 {
-    if (node == nullptr)
-    { return; }
+    const Slot* slot = input->pPrev;
 
-    // ノードが有効かどうかチェック.
-    auto valid = true;
-    for(size_t i=0; i<node->pSlots.size(); ++i)
+    // 品質不足のノードは代替入力を辿る.
+    while (slot != nullptr && !slot->pOwner->IsActive(context.Quality))
     {
-        auto slot = node->pSlots[i];
-
-        // 入力ピンのみを調べる.
-        if (slot->Kind == SlotType::Output)
-        { continue; }
-
-        auto prevSlot = slot->pPrev;
-
-        // 接続無し.
-        if (prevSlot == nullptr)
-        {
-            // つながっていないピンがあるので，このノードは無効.
-            valid = false;
-            continue;
-        }
-    }
+        auto fallback = slot->pOwner->GetFallbackSlot();
+        if (fallback == nullptr || fallback->Type != slot->Type)
+        { return kDefaultValueString[input->Type]; }
 
-    // 無効なノード.
-    if (!valid) {
-        return;
+        slot = fallback->pPrev;
     }
 
-    // ノードを追加.
-    result.push_front(node);
-
-    for(size_t i=0; i<node->pSlots.size(); ++i)
-    {
-        auto slot = node->pSlots[i];
-
-        // 入力ピンのみを調べる.
-        if (slot->Kind == SlotType::Output)
-        { continue; }
+    // 接続無し.
+    if (slot == nullptr)
+    { return kDefaultValueString[input->Type]; }
 
-        auto prevSlot = slot->pPrev;
-        if (prevSlot == nullptr)
-        { continue; }
+    // 統合済みの出力は統合先の変数を参照する.
+    auto itr = context.Alias.find(slot);
+    if (itr != context.Alias.end())
+    { slot = itr->second; }
 
-        CollectNodes(prevSlot->pOwner, result);
-    }
+    return slot->GenVarName();
 }
 
-} // namespace
-
-
 //-----------------------------------------------------------------------------
-//      変数IDを取得します.
+//      出力ファイル名に品質の接尾辞を付加します.
 //-----------------------------------------------------------------------------
-uint64_t GetNextId()
+std::string GetExportPath(const std::string& path, QualityLevel quality)
 {
-    auto result = g_NextId;
-    g_NextId++;
-    return result;
-}
+    auto pos = path.find_last_of('.');
+    if (pos == std::string::npos)
+    { return path + kQualitySuffix[quality]; }
 
-///////////////////////////////////////////////////////////////////////////////
-// Slot structure
-///////////////////////////////////////////////////////////////////////////////
+    return path.substr(0, pos) + kQualitySuffix[quality] + path.substr(pos);
+}
 
 //-----------------------------------------------------------------------------
-//      変数名を生成します.
+//      Gバッファのパッキング関数を生成します.
 //-----------------------------------------------------------------------------
-std::string Slot::GenVarName() const
+std::string GenGBufferFuncs(const GBufferLayout& layout)
 {
-    std::string name;
-    name += "var_" + std::to_string(VarId);
-    return name;
-}
+    std::string code;
 
-///////////////////////////////////////////////////////////////////////////////
-// Node structure
-///////////////////////////////////////////////////////////////////////////////
+    if (layout.OctahedralNormal)
+    {
+        code += "float2 GBufferEncodeOctahedral(float3 n)\r\n";
+        code += "{\r\n";
+        code += "    n /= (abs(n.x) + abs(n.y) + abs(n.z));\r\n";
+        code += "    float2 signs = float2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);\r\n";
+        code += "    float2 result = (n.z >= 0.0f) ? n.xy : (1.0f - abs(n.yx)) * signs;\r\n";
+        code += "    return result * 0.5f + 0.5f;\r\n";
+        code += "}\r\n";
+        code += "\r\n";
+    }
 
-//-----------------------------------------------------------------------------
-//      リセット処理を行ないます.
-//-----------------------------------------------------------------------------
-void Node::Reset()
-{
-    for(size_t i=0; i<pSlots.size(); ++i)
+    if (layout.YCoCgBaseColor)
     {
-        auto slot = pSlots[i];
-        pSlots[i] = nullptr;
+        // 輝度と，画素位置で交互に選んだ色差の2成分を格納.
+        code += "float2 GBufferEncodeYCoCg(float3 color, uint2 pixel)\r\n";
+        code += "{\r\n";
+        code += "    float  Y  = dot(color, float3( 0.25f, 0.5f,  0.25f));\r\n";
+        code += "    float  Co = dot(color, float3( 0.5f,  0.0f, -0.5f )) + 0.5f;\r\n";
+        code += "    float  Cg = dot(color, float3(-0.25f, 0.5f, -0.25f)) + 0.5f;\r\n";
+        code += "    return float2(Y, ((pixel.x ^ pixel.y) & 1) ? Cg : Co);\r\n";
+        code += "}\r\n";
+        code += "\r\n";
+    }
 
-        if (slot != nullptr)
-        { delete slot; }
+    if (layout.PackedRMO)
+    {
+        code += "uint GBufferPackRMO(float roughness, float metalness, float occlusion)\r\n";
+        code += "{\r\n";
+        code += "    uint3 v = uint3(saturate(float3(roughness, metalness, occlusion)) * 255.0f + 0.5f);\r\n";
+        code += "    return v.x | (v.y << 8) | (v.z << 16);\r\n";
+        code += "}\r\n";
+        code += "\r\n";
     }
 
-    pSlots.clear();
-    Tag.clear();
-    SourceCodeTemplate.clear();
+    return code;
 }
 
 //-----------------------------------------------------------------------------
-//      マイクロコードを生成します.
+//      同一テクスチャ・同一UVのフェッチを1回にまとめます.
 //-----------------------------------------------------------------------------
-std::string Node::GenMicroCode() const 
+void MergeTextureFetches(std::vector<Node*>& nodes, GenContext& context)
 {
-    auto code = SourceCodeTemplate;
+    std::map<std::string, Node*> fetches;
 
-    switch(Type)
+    auto itr = nodes.begin();
+    while(itr != nodes.end())
     {
-    case NodeType::Constant:
-        {
-            code = StringHelper::Replace(code, "%Output0", pSlots[0]->GenVarName());
-            code = StringHelper::Replace(code, "%Value0", std::to_string(Values[0]));
-            code = StringHelper::Replace(code, "%Value1", std::to_string(Values[1]));
-            code = StringHelper::Replace(code, "%Value2", std::to_string(Values[2]));
-            code = StringHelper::Replace(code, "%Value3", std::to_string(Values[3]));
-        }
-        break;
-
-    case NodeType::Function:
+        auto node = *itr;
+        if (node->Type != NodeType::Texture)
         {
-            int input = 0;
-            int output = 0;
-            for(size_t i=0; i<pSlots.size(); ++i)
-            {
-                auto slot = pSlots[i];
-                char pattern[32] = {};
-                std::string varName;
-
-                if (slot->Kind == SlotType::Input)
-                {
-                    sprintf_s(pattern, "%sInput%d", "%", input);
-                    input++;
-                    varName = slot->pPrev->GenVarName();
-                }
-                else
-                {
-                    sprintf_s(pattern, "%sOutput%d", "%", output);
-                    output++;
-                    varName = slot->GenVarName();
-                }
-
-                code = StringHelper::Replace(code, pattern, varName);
-            }
+            itr++;
+            continue;
         }
-        break;
 
-    case NodeType::Texture:
+        // テクスチャ・サンプラー・次元・解決済みUVが一致するものを同一フェッチとみなす.
+        std::string key;
+        key += node->TexturePath;
+        key += '\n';
+        key += std::to_string(node->Sampler);
+        key += '\n';
+        key += std::to_string(node->TextureDimension);
+        key += '\n';
+        key += ResolveVarName(node->pSlots[0], context);
+
+        auto found = fetches.find(key);
+        if (found == fetches.end())
         {
-            code = StringHelper::Replace(code, "%Output0", pSlots[0]->GenVarName());
-            code = StringHelper::Replace(code, "%Sampler", kSamplerName[Sampler]);
-            code = StringHelper::Replace(code, "%Texture", kTextureName[0]);
-            code = StringHelper::Replace(code, "%Input0",  pSlots[0]->pPrev->GenVarName());
+            fetches[key] = node;
+            itr++;
+            continue;
         }
-        break;
-
-    case NodeType::StageOutput:
-        {
-            int input = 0;
-            for(size_t i=0; i<pSlots.size(); ++i)
-            {
-                auto slot = pSlots[i];
-                char pattern[32] = {};
-                std::string varName;
-                sprintf_s(pattern, "%sInput%d", "%", input);
-                input++;
-
-                if (slot->pPrev == nullptr)
-                {
-                    varName = kDefaultValueString[slot->Type];
-                }
-                else
-                {
-                    varName = slot->pPrev->GenVarName();
-                }
 
-                code = StringHelper::Replace(code, pattern, varName);
-            }
-        }
-        break;
+        // 後続の参照は最初のフェッチ結果を読む.
+        context.Alias[node->pSlots[1]] = found->second->pSlots[1];
+        itr = nodes.erase(itr);
     }
-
-    return code;
 }
 
 //-----------------------------------------------------------------------------
-//      入力スロットを追加します.
+//      サブグラフの関数コードを呼び出し先が先になるよう生成します.
 //-----------------------------------------------------------------------------
-void Node::AddInput(const char* tag, DataType type)
+void GenSubGraphFuncs
+(
+    SubGraph*               subGraph,
+    QualityLevel            quality,
+    std::set<SubGraph*>&    emitted,
+    std::string&            code
+)
 {
-    auto slot = new Slot(SlotType::Input, type, tag, this);
-    pSlots.push_back(slot);
+    // 生成済み.
+    if (!emitted.insert(subGraph).second)
+    { return; }
+
+    std::vector<SubGraph*> callees;
+    auto func = subGraph->GenFuncCode(quality, callees);
+
+    for(size_t i=0; i<callees.size(); ++i)
+    { GenSubGraphFuncs(callees[i], quality, emitted, code); }
+
+    code += func;
 }
 
 //-----------------------------------------------------------------------------
-//      出力スロットを追加します.
+//      スロット番号を取得します.
 //-----------------------------------------------------------------------------
-void Node::AddOutput(const char* tag, DataType type)
+size_t FindSlotIndex(const Node* node, const Slot* slot)
 {
-    auto slot = new Slot(SlotType::Output, type, tag, this);
-    pSlots.push_back(slot);
-}
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        if (node->pSlots[i] == slot)
+        { return i; }
+    }
 
-//-----------------------------------------------------------------------------
-//      入力スロットにfloatを追加します.
-//-----------------------------------------------------------------------------
-void Node::AddInput1(const char* tag)
-{ AddInput(tag, DataType::Float1); }
+    return node->pSlots.size();
+}
 
-//-----------------------------------------------------------------------------
-//      入力スロットにfloat2を追加します.
-//-----------------------------------------------------------------------------
-void Node::AddInput2(const char* tag)
-{ AddInput(tag, DataType::Float2); }
+static const char* kNodeTypeName[] = {
+    "Function",
+    "Texture",
+    "Constant",
+    "StageOutput",
+    "SubGraphNode",
+    "SubGraphInput",
+    "SubGraphOutput",
+};
 
-//-----------------------------------------------------------------------------
-//      入力スロットにfloat3を追加します.
-//-----------------------------------------------------------------------------
-void Node::AddInput3(const char* tag)
-{ AddInput(tag, DataType::Float3); }
+static const char* kSlotKindName[] = {
+    "Input",
+    "Output",
+};
 
-//-----------------------------------------------------------------------------
-//      入力スロットにfloat4を追加します.
-//-----------------------------------------------------------------------------
-void Node::AddInput4(const char* tag)
-{ AddInput(tag, DataType::Float4); }
+static const char* kDimensionName[] = {
+    "None",
+    "Texture1D",
+    "Texture2D",
+    "Texture3D",
+    "TextureCube",
+    "Texture1DArray",
+    "Texture2DArray",
+    "TextureCubeArray",
+};
 
-//-----------------------------------------------------------------------------
-//      出力スロットにfloatを追加します.
-//-----------------------------------------------------------------------------
-void Node::AddOutput1(const char* tag)
-{ AddOutput(tag, DataType::Float1); }
+static const char* kQualityName[] = {
+    "Low",
+    "Medium",
+    "High",
+};
 
-//-----------------------------------------------------------------------------
-//      出力スロットにfloat2を追加します.
-//-----------------------------------------------------------------------------
-void Node::AddOutput2(const char* tag)
-{ AddOutput(tag, DataType::Float2); }
+static const uint32_t kGraphFileVersion = 1;
 
 //-----------------------------------------------------------------------------
-//      出力スロットにfloat3を追加します.
+//      名前テーブルから番号を検索します. 見つからなければ既定値を返します.
 //-----------------------------------------------------------------------------
-void Node::AddOutput3(const char* tag)
-{ AddOutput(tag, DataType::Float3); }
+template<size_t N>
+int FindName(const char* (&names)[N], const char* name, int defaultValue)
+{
+    if (name == nullptr)
+    { return defaultValue; }
 
-//-----------------------------------------------------------------------------
-//      出力スロットにfloat4を追加します.
-//-----------------------------------------------------------------------------
-void Node::AddOutput4(const char* tag)
-{ AddOutput(tag, DataType::Float4); }
+    for(size_t i=0; i<N; ++i)
+    {
+        if (strcmp(names[i], name) == 0)
+        { return int(i); }
+    }
 
+    return defaultValue;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
-// EditData class
+// PendingLink structure
 ///////////////////////////////////////////////////////////////////////////////
+struct PendingLink
+{
+    Slot*       pInput;     // 接続先.
+    uint32_t    Node;       // 接続元のノード番号.
+    uint32_t    Slot;       // 接続元のスロット番号.
+};
 
-//-----------------------------------------------------------------------------
-//      コンストラクタです.
-//-----------------------------------------------------------------------------
-EditData::EditData()
+///////////////////////////////////////////////////////////////////////////////
+// GraphReader class
+///////////////////////////////////////////////////////////////////////////////
+class GraphReader : public tinyxml2::XMLVisitor
 {
-    std::string code;
-    code += "GBuffer gbuffer;\r\n";
-    code += "gbuffer.BaseColor = %Input0;\r\n";
-    code += "gbuffer.Normal    = %Input1;\r\n";
-    code += "gbuffer.Roughness = %Input2;\r\n";
-    code += "gbuffer.Metalness = %Input3;\r\n";
-    code += "gbuffer.Occlusion = %Input4;\r\n";
-    code += "gbuffer.Emissive  = %Input5;\r\n";
-    code += "output = EncodeGBuffer(gbuffer);\r\n";
+public:
+    //-------------------------------------------------------------------------
+    //! @brief      コンストラクタです.
+    //-------------------------------------------------------------------------
+    explicit GraphReader(EditData& data)
+    : m_Data(data)
+    { /* DO_NOTHING */ }
+
+    //-------------------------------------------------------------------------
+    //! @brief      要素の開始を処理します.
+    //-------------------------------------------------------------------------
+    bool VisitEnter(const tinyxml2::XMLElement& element, const tinyxml2::XMLAttribute*) override
+    {
+        auto name = element.Name();
 
-    m_StageOutput.Type = NodeType::StageOutput;
-    m_StageOutput.Tag = "Stage Output";
-    m_StageOutput.AddInput3("BaseColor");
-    m_StageOutput.AddInput3("Normal");
-    m_StageOutput.AddInput1("Roughness");
-    m_StageOutput.AddInput1("Metalness");
-    m_StageOutput.AddInput1("Occlusion");
-    m_StageOutput.AddInput3("Emissive");
-    m_StageOutput.SourceCodeTemplate = code;
+        if (strcmp(name, "Slot") == 0)
+        { return ReadSlot(element); }
 
-    m_ExportPath = "shader.hlsl";
-}
+        if (strcmp(name, "Node") == 0)
+        { return ReadNode(element); }
 
-//-----------------------------------------------------------------------------
-//      デストラクタです.
-//-----------------------------------------------------------------------------
-EditData::~EditData()
-{ Reset(); }
+        if (strcmp(name, "SubGraph") == 0)
+        { return ReadSubGraph(element); }
 
-//-----------------------------------------------------------------------------
-//      リセット処理を行ないます.
-//-----------------------------------------------------------------------------
-void EditData::Reset()
-{
-    for(size_t i=0; i<m_pNodes.size(); ++i)
-    { m_pNodes[i]->Reset(); }
+        if (strcmp(name, "GBuffer") == 0)
+        {
+            GBufferLayout layout;
+            layout.OctahedralNormal = element.BoolAttribute("OctahedralNormal");
+            layout.YCoCgBaseColor   = element.BoolAttribute("YCoCgBaseColor");
+            layout.PackedRMO        = element.BoolAttribute("PackedRMO");
+            m_Data.SetGBufferLayout(layout);
+            return true;
+        }
 
-    m_pNodes.clear();
-}
+        if (strcmp(name, "ShaderGraph") == 0)
+        { return ReadRoot(element); }
 
-//-----------------------------------------------------------------------------
-//      ファイルを読み込みます.
-//-----------------------------------------------------------------------------
-bool EditData::Load(const char* path)
-{
+        // 未知の要素は読み飛ばす.
+        return false;
+    }
 
-    g_NextId = m_NextId;
+    //-------------------------------------------------------------------------
+    //! @brief      要素の終了を処理します.
+    //-------------------------------------------------------------------------
+    bool VisitExit(const tinyxml2::XMLElement& element) override
+    {
+        auto name = element.Name();
 
-    return false;
-}
+        if (strcmp(name, "Node") == 0)
+        { m_pNode = nullptr; }
+        else if (strcmp(name, "SubGraph") == 0)
+        { m_pSubGraph = nullptr; }
 
-//-----------------------------------------------------------------------------
-//      ファイルを書き込みます.
-//-----------------------------------------------------------------------------
-bool EditData::Save(const char* path)
-{
-    m_NextId = g_NextId;
+        return !m_Failed;
+    }
 
-    return false;
-}
+    //-------------------------------------------------------------------------
+    //! @brief      読み込んだノードを登録し，接続を復元します.
+    //-------------------------------------------------------------------------
+    bool Finish()
+    {
+        if (m_Failed)
+        { return false; }
 
-//-----------------------------------------------------------------------------
-//      シェーダコードを生成します.
-//-----------------------------------------------------------------------------
-void EditData::GenShaderCode()
-{
-    std::string code;
+        // 接続元が先に並んでいれば，接続はトポロジカル順序を崩さない.
+        for(size_t i=0; i<m_Links.size(); ++i)
+        {
+            auto& link = m_Links[i];
+            if (link.Node >= m_pNodes.size() || m_pNodes[link.Node] == nullptr)
+            { return false; }
 
-    code += "//-----------------------------------------------------------------------------\r\n";
-    code += "// <auto-generated>\r\n";
-    code += "//     This code was generated by a tool.\r\n";
-    code += "//\r\n";
-    code += "//     Changes to this file may cause incorrect behavior and will be lost if\r\n";
-    code += "//     the code is regenerated.\r\n";
-    code += "// </auto-generated>\r\n";
-    code += "//-----------------------------------------------------------------------------\r\n";
-    code += "\r\n";
-    code += "#include \"ShaderEditorDefine.hlsli\"\r\n";
-    code += "#include \"ShaderEditorPreset.hlsli\"\r\n";
-    code += "\r\n";
-    code += "PSOutput main(const PSInput input)\r\n";
-    code += "{\r\n";
+            auto node = m_pNodes[link.Node];
+            if (link.Slot >= node->pSlots.size())
+            { return false; }
+
+            auto output = node->pSlots[link.Slot];
+            if (output->Kind != SlotType::Output || output->Type != link.pInput->Type)
+            { return false; }
+
+            if (!m_Data.AddLink(output, link.pInput))
+            { return false; }
+        }
+
+        // サブグラフの入出力ノードが揃っているか確認.
+        auto& subGraphs = m_Data.GetSubGraphs();
+        for(size_t i=0; i<subGraphs.size(); ++i)
+        {
+            if (subGraphs[i]->pInput == nullptr || subGraphs[i]->pOutput == nullptr)
+            { return false; }
+        }
+
+        m_Data.AddNodes(m_pMainNodes);
+        return true;
+    }
+
+private:
+    EditData&                   m_Data;
+    std::vector<Node*>          m_pNodes;           // ファイル上の番号順のノード.
+    std::vector<Node*>          m_pMainNodes;       // メイングラフに追加するノード.
+    std::vector<PendingLink>    m_Links;
+    SubGraph*                   m_pSubGraph     = nullptr;
+    Node*                       m_pNode         = nullptr;
+    uint32_t                    m_SlotIndex     = 0;
+    uint32_t                    m_SubGraphIndex = 0;
+    bool                        m_RootFound     = false;
+    bool                        m_Failed        = false;
+
+    bool Fail()
+    {
+        m_Failed = true;
+        return false;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      サブグラフを取得します. 範囲外の場合は nullptr を返します.
+    //-------------------------------------------------------------------------
+    SubGraph* GetSubGraph(uint32_t index)
+    {
+        auto& subGraphs = m_Data.GetSubGraphs();
+        if (index >= subGraphs.size())
+        { return nullptr; }
+
+        return subGraphs[index];
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ルート要素を読み込みます.
+    //!
+    //!             ノード番号やサブグラフ番号でメモリを確保しないよう，
+    //!             先にノード数とサブグラフ数を数えて配列を確定します.
+    //!             ノード数は属性の値と実際の要素数が一致する必要があります.
+    //-------------------------------------------------------------------------
+    bool ReadRoot(const tinyxml2::XMLElement& element)
+    {
+        if (m_RootFound || element.UnsignedAttribute("Version") != kGraphFileVersion)
+        { return Fail(); }
+
+        m_RootFound = true;
+
+        uint32_t nodeCount     = 0;
+        uint32_t subGraphCount = 0;
+        for(auto child = element.FirstChildElement(); child != nullptr; child = child->NextSiblingElement())
+        {
+            if (strcmp(child->Name(), "Node") == 0)
+            { nodeCount++; }
+            else if (strcmp(child->Name(), "SubGraph") == 0)
+            {
+                subGraphCount++;
+                for(auto node = child->FirstChildElement("Node"); node != nullptr; node = node->NextSiblingElement("Node"))
+                { nodeCount++; }
+            }
+        }
+
+        if (element.UnsignedAttribute("NodeCount", UINT32_MAX) != nodeCount)
+        { return Fail(); }
+
+        m_pNodes.resize(nodeCount, nullptr);
+        m_pMainNodes.reserve(nodeCount);
+
+        auto& subGraphs = m_Data.GetSubGraphs();
+        for(uint32_t i=0; i<subGraphCount; ++i)
+        { subGraphs.push_back(new SubGraph()); }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      サブグラフ要素を読み込みます.
+    //-------------------------------------------------------------------------
+    bool ReadSubGraph(const tinyxml2::XMLElement& element)
+    {
+        auto name = element.Attribute("Name");
+
+        m_pSubGraph = GetSubGraph(m_SubGraphIndex++);
+        if (m_pSubGraph == nullptr)
+        { return Fail(); }
+
+        m_pSubGraph->Name     = (name != nullptr) ? name : "";
+        m_pSubGraph->Origin.x = element.FloatAttribute("OriginX");
+        m_pSubGraph->Origin.y = element.FloatAttribute("OriginY");
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      ノード要素を読み込みます.
+    //-------------------------------------------------------------------------
+    bool ReadNode(const tinyxml2::XMLElement& element)
+    {
+        auto id   = element.UnsignedAttribute("Id", UINT32_MAX);
+        auto type = NodeType(FindName(kNodeTypeName, element.Attribute("Type"), -1));
+        if (id >= m_pNodes.size() || m_pNodes[id] != nullptr || int(type) < 0)
+        { return Fail(); }
+
+        Node* node = nullptr;
+        if (type == NodeType::StageOutput)
+        {
+            if (m_pSubGraph != nullptr)
+            { return Fail(); }
+
+            node = m_Data.GetStageOutput();
+        }
+        else
+        {
+            node = m_Data.CreateNode();
+            node->Type = type;
+
+            auto tag = element.Attribute("Tag");
+            if (tag != nullptr)
+            { node->Tag = InternString(tag); }
+
+            auto code = element.Attribute("Template");
+            if (code != nullptr)
+            { node->SourceCodeTemplate = InternString(code); }
+
+            // 記述子はタグが一致する場合のみ復元する.
+            auto descriptor = GetNodeDescriptor(element.UnsignedAttribute("Descriptor", UINT32_MAX));
+            if (descriptor != nullptr && tag != nullptr && strcmp(descriptor->Tag, tag) == 0)
+            { node->pDescriptor = descriptor; }
+
+            auto path = element.Attribute("TexturePath");
+            if (path != nullptr)
+            { node->TexturePath = path; }
+
+            node->TextureDimension = TextureDimension(FindName(kDimensionName, element.Attribute("TextureDimension"), TextureDimension::None));
+            node->Sampler          = SamplerType(FindName(kSamplerName, element.Attribute("Sampler"), LinearWrap));
+            node->MinQuality       = QualityLevel(FindName(kQualityName, element.Attribute("MinQuality"), QualityLevel::Low));
+            node->FallbackInput    = element.IntAttribute("FallbackInput", -1);
+            node->AsColor          = element.BoolAttribute("AsColor");
+
+            auto values = element.Attribute("Values");
+            if (values != nullptr)
+            {
+                char* cursor = const_cast<char*>(values);
+                for(auto i=0; i<4; ++i)
+                { node->Values[i] = strtof(cursor, &cursor); }
+            }
+
+            if (type == NodeType::SubGraphNode)
+            {
+                node->pSubGraph = GetSubGraph(element.UnsignedAttribute("SubGraph", UINT32_MAX));
+                if (node->pSubGraph == nullptr)
+                { return Fail(); }
+            }
+
+            if (m_pSubGraph == nullptr)
+            { m_pMainNodes.push_back(node); }
+            else if (type == NodeType::SubGraphInput)
+            { m_pSubGraph->pInput = node; }
+            else if (type == NodeType::SubGraphOutput)
+            { m_pSubGraph->pOutput = node; }
+            else
+            { m_pSubGraph->pNodes.push_back(node); }
+        }
+
+        node->Pos.x = element.FloatAttribute("X");
+        node->Pos.y = element.FloatAttribute("Y");
+
+        m_pNodes[id] = node;
+        m_pNode      = node;
+        m_SlotIndex  = 0;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    //! @brief      スロット要素を読み込みます.
+    //-------------------------------------------------------------------------
+    bool ReadSlot(const tinyxml2::XMLElement& element)
+    {
+        if (m_pNode == nullptr)
+        { return Fail(); }
+
+        auto kind = SlotType(FindName(kSlotKindName, element.Attribute("Kind"), -1));
+        auto type = DataType(FindName(kTypeName, element.Attribute("Type"), -1));
+        if (int(kind) < 0 || int(type) < 0)
+        { return Fail(); }
+
+        Slot* slot = nullptr;
+        if (m_pNode->Type == NodeType::StageOutput)
+        {
+            // ステージ出力のスロットは生成済みのものを使う.
+            if (m_SlotIndex >= m_pNode->pSlots.size())
+            { return Fail(); }
+
+            slot = m_pNode->pSlots[m_SlotIndex];
+            if (slot->Kind != kind || slot->Type != type)
+            { return Fail(); }
+        }
+        else
+        {
+            auto tag = element.Attribute("Tag");
+            auto symbol = (tag != nullptr) ? InternString(tag) : kEmptySymbol;
+            if (kind == SlotType::Input)
+            { m_pNode->AddInput(symbol, type); }
+            else
+            { m_pNode->AddOutput(symbol, type); }
+
+            slot = m_pNode->pSlots.back();
+        }
+
+        auto prevNode = element.UnsignedAttribute("PrevNode", UINT32_MAX);
+        auto prevSlot = element.UnsignedAttribute("PrevSlot", UINT32_MAX);
+        if (kind == SlotType::Input && prevNode != UINT32_MAX && prevSlot != UINT32_MAX)
+        { m_Links.push_back(PendingLink{ slot, prevNode, prevSlot }); }
+
+        m_SlotIndex++;
+        return true;
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      浮動小数値を往復で値が変わらない最短の精度で文字列化します.
+//-----------------------------------------------------------------------------
+void FormatFloat(char* buffer, size_t size, float value)
+{ snprintf(buffer, size, "%.9g", value); }
+
+//-----------------------------------------------------------------------------
+//      ノードを書き出します.
+//
+//      ノード番号はファイル上の並び順と一致します.
+//-----------------------------------------------------------------------------
+void WriteNode(tinyxml2::XMLPrinter& printer, const GraphBinaryView& view, uint32_t index)
+{
+    auto record = view.GetNode(index);
+    auto type   = NodeType(record->Type);
+    char buffer[128];
+
+    printer.OpenElement("Node");
+    printer.PushAttribute("Id",   index);
+    printer.PushAttribute("Type", kNodeTypeName[type]);
+
+    FormatFloat(buffer, sizeof(buffer), record->Pos[0]);
+    printer.PushAttribute("X", buffer);
+    FormatFloat(buffer, sizeof(buffer), record->Pos[1]);
+    printer.PushAttribute("Y", buffer);
+
+    if (type != NodeType::StageOutput)
+    {
+        printer.PushAttribute("Tag", view.GetString(record->Tag));
+
+        if (record->Descriptor != kGraphNoIndex)
+        { printer.PushAttribute("Descriptor", record->Descriptor); }
+        else if (record->Template != 0)
+        { printer.PushAttribute("Template", view.GetString(record->Template)); }
+
+        if (type == NodeType::Constant)
+        {
+            auto length = 0;
+            for(auto i=0; i<4; ++i)
+            {
+                if (i > 0)
+                { buffer[length++] = ' '; }
+
+                FormatFloat(buffer + length, sizeof(buffer) - length, record->Values[i]);
+                length += int(strlen(buffer + length));
+            }
+            printer.PushAttribute("Values",  buffer);
+            printer.PushAttribute("AsColor", record->AsColor != 0);
+        }
+
+        if (type == NodeType::Texture)
+        {
+            printer.PushAttribute("TexturePath",      view.GetString(record->TexturePath));
+            printer.PushAttribute("TextureDimension", kDimensionName[record->TextureDimension]);
+            printer.PushAttribute("Sampler",          kSamplerName[record->Sampler]);
+        }
+
+        if (type == NodeType::SubGraphNode)
+        { printer.PushAttribute("SubGraph", record->SubGraph); }
+
+        if (record->MinQuality != QualityLevel::Low)
+        { printer.PushAttribute("MinQuality", kQualityName[record->MinQuality]); }
+
+        if (record->FallbackInput >= 0)
+        { printer.PushAttribute("FallbackInput", record->FallbackInput); }
+    }
+
+    for(uint32_t i=0; i<record->SlotCount; ++i)
+    {
+        auto slot = view.GetSlot(record->SlotBegin + i);
+
+        printer.OpenElement("Slot");
+        printer.PushAttribute("Kind", kSlotKindName[slot->Kind]);
+        printer.PushAttribute("Type", kTypeName[slot->Type]);
+        printer.PushAttribute("Tag",  view.GetString(slot->Tag));
+
+        auto prev = view.GetSlotPrev(record->SlotBegin + i);
+        if (slot->Kind == SlotType::Input && prev != kGraphNoIndex)
+        {
+            auto owner = view.GetSlot(prev)->Owner;
+            printer.PushAttribute("PrevNode", owner);
+            printer.PushAttribute("PrevSlot", prev - view.GetNode(owner)->SlotBegin);
+        }
+
+        printer.CloseElement();
+    }
+
+    printer.CloseElement();
+}
+
+//-----------------------------------------------------------------------------
+//      スナップショットをXML形式で出力します.
+//
+//      読み込み時の接続がトポロジカル順序を崩さないよう，接続元から順に
+//      書き出します.
+//-----------------------------------------------------------------------------
+void PrintGraph(tinyxml2::XMLPrinter& printer, const GraphBinaryView& view, std::atomic<uint32_t>* pWritten)
+{
+    auto flags = view.GetFlags();
+
+    printer.PushHeader(false, true);
+    printer.OpenElement("ShaderGraph");
+    printer.PushAttribute("Version",   kGraphFileVersion);
+    printer.PushAttribute("NodeCount", view.GetNodeCount());
+
+    printer.OpenElement("GBuffer");
+    printer.PushAttribute("OctahedralNormal", (flags & GraphOctahedralNormal) != 0);
+    printer.PushAttribute("YCoCgBaseColor",   (flags & GraphYCoCgBaseColor)   != 0);
+    printer.PushAttribute("PackedRMO",        (flags & GraphPackedRMO)        != 0);
+    printer.CloseElement();
+
+    for(uint32_t i=0; i<view.GetSubGraphCount(); ++i)
+    {
+        auto record = view.GetSubGraph(i);
+        char buffer[64];
+
+        printer.OpenElement("SubGraph");
+        printer.PushAttribute("Name", view.GetString(record->Name));
+        FormatFloat(buffer, sizeof(buffer), record->Origin[0]);
+        printer.PushAttribute("OriginX", buffer);
+        FormatFloat(buffer, sizeof(buffer), record->Origin[1]);
+        printer.PushAttribute("OriginY", buffer);
+
+        for(uint32_t j=0; j<record->NodeCount; ++j)
+        {
+            WriteNode(printer, view, record->NodeBegin + j);
+            if (pWritten != nullptr)
+            { pWritten->fetch_add(1, std::memory_order_relaxed); }
+        }
+
+        printer.CloseElement();
+    }
+
+    for(uint32_t i=view.GetMainNodeBegin(); i<view.GetNodeCount(); ++i)
+    {
+        WriteNode(printer, view, i);
+        if (pWritten != nullptr)
+        { pWritten->fetch_add(1, std::memory_order_relaxed); }
+    }
+
+    printer.CloseElement();
+}
+
+//-----------------------------------------------------------------------------
+//      トポロジカル順序で並べたノードリストを取得します.
+//-----------------------------------------------------------------------------
+std::vector<const Node*> SortByOrder(const std::vector<Node*>& nodes)
+{
+    std::vector<const Node*> result(nodes.begin(), nodes.end());
+    std::sort(result.begin(), result.end(), [](const Node* lhs, const Node* rhs) { return lhs->Order < rhs->Order; });
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイル上の並び順でノードを収集します.
+//
+//      サブグラフ毎に入力ノード・内部ノード・出力ノードの順で並べ，最後に
+//      メイングラフのノードとステージ出力を並べます. 戻り値は総ノード数です.
+//-----------------------------------------------------------------------------
+uint32_t CollectFileNodes
+(
+    const std::vector<SubGraph*>&               subGraphs,
+    const std::vector<Node*>&                   mainNodes,
+    const Node*                                 stageOutput,
+    std::vector<std::vector<const Node*>>&      subGraphNodes,
+    std::vector<const Node*>&                   nodes
+)
+{
+    uint32_t count = 0;
+
+    subGraphNodes.resize(subGraphs.size());
+    for(size_t i=0; i<subGraphs.size(); ++i)
+    {
+        auto  subGraph = subGraphs[i];
+        auto& result   = subGraphNodes[i];
+        result.push_back(subGraph->pInput);
+
+        auto sorted = SortByOrder(subGraph->pNodes);
+        result.insert(result.end(), sorted.begin(), sorted.end());
+        result.push_back(subGraph->pOutput);
+        count += uint32_t(result.size());
+    }
+
+    nodes = SortByOrder(mainNodes);
+    nodes.push_back(stageOutput);
+    count += uint32_t(nodes.size());
+
+    return count;
+}
+
+static const uint64_t kHashBasis = 0xcbf29ce484222325ull;  // FNV-1a のオフセット基底.
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値にバイト列を加えます.
+//-----------------------------------------------------------------------------
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    for(size_t i=0; i<size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値に値を加えます.
+//-----------------------------------------------------------------------------
+template<typename T>
+uint64_t HashValue(uint64_t hash, const T& value)
+{ return HashBytes(hash, &value, sizeof(value)); }
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値に文字列を加えます. 終端文字も含めて区切りとします.
+//-----------------------------------------------------------------------------
+uint64_t HashString(uint64_t hash, const char* text)
+{ return HashBytes(hash, text, strlen(text) + 1); }
+
+//-----------------------------------------------------------------------------
+//      ノードのハッシュ値を計算し，変化したかどうかを返します.
+//
+//      位置やサイズなど生成結果に影響しないものは含めません. 入力は接続元の
+//      ハッシュ値と出力スロット番号で表すので，接続元を先に計算してください.
+//      シンボルの番号はプロセス毎に異なるため文字列で計算します.
+//-----------------------------------------------------------------------------
+bool AssignHash(Node* node)
+{
+    auto hash = kHashBasis;
+    hash = HashValue (hash, uint32_t(node->Type));
+    hash = HashString(hash, node->GetTag());
+    hash = HashString(hash, node->GetSourceCodeTemplate());
+    hash = HashString(hash, node->TexturePath.c_str());
+    hash = HashValue (hash, uint32_t(node->TextureDimension));
+    hash = HashValue (hash, uint32_t(node->Sampler));
+    hash = HashBytes (hash, node->Values, sizeof(node->Values));
+    hash = HashValue (hash, uint32_t(node->AsColor));
+    hash = HashValue (hash, uint32_t(node->MinQuality));
+    hash = HashValue (hash, int32_t(node->FallbackInput));
+
+    // サブグラフの内容は出力ノードのハッシュ値に集約されている.
+    if (node->pSubGraph != nullptr)
+    {
+        hash = HashString(hash, node->pSubGraph->Name.c_str());
+        if (node->pSubGraph->pOutput != nullptr)
+        { hash = HashValue(hash, node->pSubGraph->pOutput->Hash); }
+    }
+
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        auto slot = node->pSlots[i];
+        hash = HashValue (hash, uint32_t(slot->Kind));
+        hash = HashValue (hash, uint32_t(slot->Type));
+        hash = HashString(hash, slot->GetTag());
+    }
+
+    auto content = hash;
+
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        auto slot = node->pSlots[i];
+        if (slot->Kind != SlotType::Input)
+        { continue; }
+
+        auto prev = slot->pPrev;
+        if (prev == nullptr)
+        {
+            hash = HashValue(hash, uint64_t(0));
+            continue;
+        }
+
+        hash = HashValue(hash, prev->pOwner->Hash);
+        hash = HashValue(hash, uint32_t(FindSlotIndex(prev->pOwner, prev)));
+    }
+
+    if (node->ContentHash == content && node->Hash == hash)
+    { return false; }
+
+    node->ContentHash = content;
+    node->Hash        = hash;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      接続元のノードを取得します.
+//-----------------------------------------------------------------------------
+const Node* GetPrevNode(const Node* node, size_t index)
+{
+    if (index >= node->pSlots.size() || node->pSlots[index]->pPrev == nullptr)
+    { return nullptr; }
+
+    return node->pSlots[index]->pPrev->pOwner;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Slot structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      変数名を生成します.
+//-----------------------------------------------------------------------------
+std::string Slot::GenVarName() const
+{
+    std::string name;
+    name += "var_" + std::to_string(VarId);
+    return name;
+}
+
+//-----------------------------------------------------------------------------
+//      タグを取得します.
+//-----------------------------------------------------------------------------
+const char* Slot::GetTag() const
+{ return GetSymbolString(Tag); }
+
+///////////////////////////////////////////////////////////////////////////////
+// Node structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      リセット処理を行ないます.
+//-----------------------------------------------------------------------------
+void Node::Reset()
+{
+    for(size_t i=0; i<pSlots.size(); ++i)
+    {
+        auto slot = pSlots[i];
+        pSlots[i] = nullptr;
+
+        if (slot != nullptr)
+        { pGraph->DestroySlot(slot); }
+    }
+
+    pSlots.clear();
+    Tag                = kEmptySymbol;
+    SourceCodeTemplate = kEmptySymbol;
+    pDescriptor = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      タグを取得します.
+//-----------------------------------------------------------------------------
+const char* Node::GetTag() const
+{
+    if (pDescriptor != nullptr)
+    { return pDescriptor->Tag; }
+
+    return GetSymbolString(Tag);
+}
+
+//-----------------------------------------------------------------------------
+//      ソースコードテンプレートを取得します.
+//-----------------------------------------------------------------------------
+const char* Node::GetSourceCodeTemplate() const
+{
+    if (pDescriptor != nullptr)
+    { return pDescriptor->SourceCodeTemplate; }
+
+    return GetSymbolString(SourceCodeTemplate);
+}
+
+//-----------------------------------------------------------------------------
+//      マイクロコードを生成します.
+//-----------------------------------------------------------------------------
+std::string Node::GenMicroCode(const GenContext& context) const 
+{
+    std::string code = GetSourceCodeTemplate();
+
+    switch(Type)
+    {
+    case NodeType::Constant:
+        {
+            code = StringHelper::Replace(code, "%Output0", pSlots[0]->GenVarName());
+            code = StringHelper::Replace(code, "%Value0", std::to_string(Values[0]));
+            code = StringHelper::Replace(code, "%Value1", std::to_string(Values[1]));
+            code = StringHelper::Replace(code, "%Value2", std::to_string(Values[2]));
+            code = StringHelper::Replace(code, "%Value3", std::to_string(Values[3]));
+        }
+        break;
+
+    case NodeType::Function:
+        {
+            int input = 0;
+            int output = 0;
+            for(size_t i=0; i<pSlots.size(); ++i)
+            {
+                auto slot = pSlots[i];
+                char pattern[32] = {};
+                std::string varName;
+
+                if (slot->Kind == SlotType::Input)
+                {
+                    sprintf_s(pattern, "%sInput%d", "%", input);
+                    input++;
+                    varName = ResolveVarName(slot, context);
+                }
+                else
+                {
+                    sprintf_s(pattern, "%sOutput%d", "%", output);
+                    output++;
+                    varName = slot->GenVarName();
+                }
+
+                code = StringHelper::Replace(code, pattern, varName);
+            }
+        }
+        break;
+
+    case NodeType::Texture:
+        {
+            code = StringHelper::Replace(code, "%Output0", pSlots[1]->GenVarName());
+            code = StringHelper::Replace(code, "%Sampler", kSamplerName[Sampler]);
+            code = StringHelper::Replace(code, "%Texture", kTextureName[0]);
+            code = StringHelper::Replace(code, "%Input0",  ResolveVarName(pSlots[0], context));
+        }
+        break;
+
+    case NodeType::StageOutput:
+        {
+            int input = 0;
+            for(size_t i=0; i<pSlots.size(); ++i)
+            {
+                auto slot = pSlots[i];
+                char pattern[32] = {};
+                std::string varName;
+                sprintf_s(pattern, "%sInput%d", "%", input);
+                input++;
+
+                varName = ResolveVarName(slot, context);
+
+                code = StringHelper::Replace(code, pattern, varName);
+            }
+        }
+        break;
+
+    case NodeType::SubGraphNode:
+        {
+            // 出力変数を宣言してから関数を呼び出す.
+            // 頂点入力とジオメトリは呼び出し元から引き継ぐ(入れ子の呼び出しも同じ名前).
+            std::string args = "input, geometry";
+            for(size_t i=0; i<pSlots.size(); ++i)
+            {
+                auto slot = pSlots[i];
+                args += ", ";
+
+                if (slot->Kind == SlotType::Input)
+                {
+                    args += ResolveVarName(slot, context);
+                }
+                else
+                {
+                    code += kTypeName[slot->Type];
+                    code += " " + slot->GenVarName() + ";\r\n";
+                    args += slot->GenVarName();
+                }
+            }
+
+            code += pSubGraph->GetFuncName() + "(" + args + ");\r\n";
+        }
+        break;
+
+    case NodeType::SubGraphInput:
+        {
+            // 出力スロットは関数の引数なので何も生成しない.
+        }
+        break;
+
+    case NodeType::SubGraphOutput:
+        {
+            for(size_t i=0; i<pSlots.size(); ++i)
+            {
+                auto slot = pSlots[i];
+                code += slot->GenVarName() + " = " + ResolveVarName(slot, context) + ";\r\n";
+            }
+        }
+        break;
+    }
+
+    return code;
+}
+
+//-----------------------------------------------------------------------------
+//      指定品質でノードが有効かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool Node::IsActive(QualityLevel quality) const
+{ return MinQuality <= quality; }
+
+//-----------------------------------------------------------------------------
+//      品質不足時に代替する入力スロットを取得します.
+//-----------------------------------------------------------------------------
+Slot* Node::GetFallbackSlot() const
+{
+    if (FallbackInput < 0)
+    { return nullptr; }
+
+    int input = 0;
+    for(size_t i=0; i<pSlots.size(); ++i)
+    {
+        if (pSlots[i]->Kind != SlotType::Input)
+        { continue; }
+
+        if (input == FallbackInput)
+        { return pSlots[i]; }
+
+        input++;
+    }
+
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      入力スロットを追加します.
+//-----------------------------------------------------------------------------
+void Node::AddInput(const char* tag, DataType type)
+{ AddInput(InternString(tag), type); }
+
+//-----------------------------------------------------------------------------
+//      入力スロットを追加します.
+//-----------------------------------------------------------------------------
+void Node::AddInput(Symbol tag, DataType type)
+{
+    auto slot = pGraph->CreateSlot(SlotType::Input, type, tag, this);
+    pSlots.push_back(slot);
+}
+
+//-----------------------------------------------------------------------------
+//      出力スロットを追加します.
+//-----------------------------------------------------------------------------
+void Node::AddOutput(const char* tag, DataType type)
+{ AddOutput(InternString(tag), type); }
+
+//-----------------------------------------------------------------------------
+//      出力スロットを追加します.
+//-----------------------------------------------------------------------------
+void Node::AddOutput(Symbol tag, DataType type)
+{
+    auto slot = pGraph->CreateSlot(SlotType::Output, type, tag, this);
+    pSlots.push_back(slot);
+}
+
+//-----------------------------------------------------------------------------
+//      入力スロットにfloatを追加します.
+//-----------------------------------------------------------------------------
+void Node::AddInput1(const char* tag)
+{ AddInput(tag, DataType::Float1); }
+
+//-----------------------------------------------------------------------------
+//      入力スロットにfloat2を追加します.
+//-----------------------------------------------------------------------------
+void Node::AddInput2(const char* tag)
+{ AddInput(tag, DataType::Float2); }
+
+//-----------------------------------------------------------------------------
+//      入力スロットにfloat3を追加します.
+//-----------------------------------------------------------------------------
+void Node::AddInput3(const char* tag)
+{ AddInput(tag, DataType::Float3); }
+
+//-----------------------------------------------------------------------------
+//      入力スロットにfloat4を追加します.
+//-----------------------------------------------------------------------------
+void Node::AddInput4(const char* tag)
+{ AddInput(tag, DataType::Float4); }
+
+//-----------------------------------------------------------------------------
+//      出力スロットにfloatを追加します.
+//-----------------------------------------------------------------------------
+void Node::AddOutput1(const char* tag)
+{ AddOutput(tag, DataType::Float1); }
+
+//-----------------------------------------------------------------------------
+//      出力スロットにfloat2を追加します.
+//-----------------------------------------------------------------------------
+void Node::AddOutput2(const char* tag)
+{ AddOutput(tag, DataType::Float2); }
+
+//-----------------------------------------------------------------------------
+//      出力スロットにfloat3を追加します.
+//-----------------------------------------------------------------------------
+void Node::AddOutput3(const char* tag)
+{ AddOutput(tag, DataType::Float3); }
+
+//-----------------------------------------------------------------------------
+//      出力スロットにfloat4を追加します.
+//-----------------------------------------------------------------------------
+void Node::AddOutput4(const char* tag)
+{ AddOutput(tag, DataType::Float4); }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// CodeGenGraph structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      pNodes からインデックス参照のグラフを構築します.
+//
+//      pNodes[i] がノード番号 i に対応します. 一覧に含まれないノードからの
+//      接続は未接続として扱います. 収集には接続関係しか使わないので，
+//      詳細データは設定しません. 配列は使い回すので，再構築で確保し直す
+//      ことはほとんどありません.
+//-----------------------------------------------------------------------------
+void CodeGenGraph::Build()
+{
+    uint32_t slotCount = 0;
+    for(size_t i=0; i<pNodes.size(); ++i)
+    {
+        pNodes[i]->StorageIndex = uint32_t(i);
+        slotCount += uint32_t(pNodes[i]->pSlots.size());
+    }
+
+    Storage.Clear();
+    Storage.Reserve(uint32_t(pNodes.size()), slotCount);
+
+    for(size_t i=0; i<pNodes.size(); ++i)
+    {
+        auto node  = pNodes[i];
+        auto index = Storage.AddNode(node->Type, node->MinQuality, node->FallbackInput);
+
+        for(size_t j=0; j<node->pSlots.size(); ++j)
+        {
+            auto slot = node->pSlots[j];
+            Storage.AddSlot(index, slot->Kind, slot->Type, slot->VarId);
+        }
+    }
+
+    // ノードのスロットは連続しているので，接続元の番号はノード番号から求まる.
+    for(size_t i=0; i<pNodes.size(); ++i)
+    {
+        auto node  = pNodes[i];
+        auto begin = Storage.GetSlotBegin(NodeIndex(i));
+        for(size_t j=0; j<node->pSlots.size(); ++j)
+        {
+            auto slot = node->pSlots[j];
+            if (slot->Kind != SlotType::Input || slot->pPrev == nullptr)
+            { continue; }
+
+            auto owner = slot->pPrev->pOwner;
+            if (owner->StorageIndex >= pNodes.size() || pNodes[owner->StorageIndex] != owner)
+            { continue; }
+
+            auto prev = Storage.GetSlotBegin(owner->StorageIndex) + FindSlotIndex(owner, slot->pPrev);
+            Storage.Connect(SlotIndex(prev), SlotIndex(begin + j));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      コード生成に必要なノードのみを上流が先になる順で収集します.
+//
+//      pNodes の末尾を根ノードとして扱います.
+//-----------------------------------------------------------------------------
+void CodeGenGraph::CollectNodes(QualityLevel quality, std::vector<Node*>& result) const
+{
+    std::vector<NodeIndex> order;
+    Storage.CollectNodes(NodeIndex(pNodes.size() - 1), quality, order);
+
+    result.reserve(order.size());
+    for(size_t i=0; i<order.size(); ++i)
+    { result.push_back(pNodes[order[i]]); }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SubGraph structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      リセット処理を行ないます.
+//-----------------------------------------------------------------------------
+void SubGraph::Reset()
+{
+    // ノードの実体は編集データがまとめて解放する.
+    pNodes.clear();
+    pInput  = nullptr;
+    pOutput = nullptr;
+    Name.clear();
+    CodeGen.pNodes.clear();
+    CodeGen.Storage.Clear();
+}
+
+//-----------------------------------------------------------------------------
+//      関数名を取得します.
+//-----------------------------------------------------------------------------
+std::string SubGraph::GetFuncName() const
+{ return "SubGraph_" + Name; }
+
+//-----------------------------------------------------------------------------
+//      関数コードを生成します.
+//-----------------------------------------------------------------------------
+std::string SubGraph::GenFuncCode(QualityLevel quality, std::vector<SubGraph*>& pCallees) const
+{
+    std::vector<Node*> validNodes;
+    CodeGen.CollectNodes(quality, validNodes);
+
+    GenContext context;
+    context.Quality = quality;
+    MergeTextureFetches(validNodes, context);
+
+    // 内部のノードが main() と同じ名前で頂点入力とジオメトリを参照できるよう，
+    // 先頭で受け取る. 入力ノードの出力を in 引数，出力ノードの入力を out 引数とする.
+    std::string args = "in PSInput input, in Geometry geometry";
+    for(size_t i=0; i<pInput->pSlots.size(); ++i)
+    {
+        auto slot = pInput->pSlots[i];
+        args += ", in ";
+        args += kTypeName[slot->Type];
+        args += " " + slot->GenVarName();
+    }
+    for(size_t i=0; i<pOutput->pSlots.size(); ++i)
+    {
+        auto slot = pOutput->pSlots[i];
+        args += ", out ";
+        args += kTypeName[slot->Type];
+        args += " " + slot->GenVarName();
+    }
+
+    std::string code;
+    code += "void " + GetFuncName() + "(" + args + ")\r\n";
+    code += "{\r\n";
+
+    for(size_t i=0; i<validNodes.size(); ++i)
+    {
+        auto node = validNodes[i];
+        if (node->Type == NodeType::SubGraphNode)
+        { pCallees.push_back(node->pSubGraph); }
+
+        code += node->GenMicroCode(context);
+    }
+
+    code += "}\r\n";
+    code += "\r\n";
+
+    return code;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// NodeClipboard structure
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      内容を破棄します.
+//-----------------------------------------------------------------------------
+void NodeClipboard::Clear()
+{
+    Nodes.clear();
+    Slots.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      空かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool NodeClipboard::IsEmpty() const
+{ return Nodes.empty(); }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// EditData class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+EditData::EditData()
+{
+    InitStageOutput();
+
+    m_ExportPath = "shader.hlsl";
+}
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+EditData::~EditData()
+{
+    // ノードとスロットはプールの破棄時にまとめて解放される.
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    { delete m_pSubGraphs[i]; }
+
+    m_pSubGraphs.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      リセット処理を行ないます.
+//-----------------------------------------------------------------------------
+void EditData::Reset()
+{
+    m_pNodes.clear();
+
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    {
+        m_pSubGraphs[i]->Reset();
+        delete m_pSubGraphs[i];
+    }
+
+    m_pSubGraphs.clear();
+
+    // ノードとスロットを個別に破棄せず，ブロック単位でまとめて解放.
+    auto pos = m_pStageOutput->Pos;
+    m_SlotIndex.clear();
+    m_pGarbageNodes.clear();
+    m_pDirtyNodes.clear();
+    m_pStageOutput = nullptr;
+    m_NodePool.Clear();
+    m_SlotPool.Clear();
+
+    // 生成済みのシェーダコードは破棄したグラフのものなので使わない.
+    m_CodeGenerated = false;
+    m_CodeHash      = 0;
+
+    InitStageOutput();
+    m_pStageOutput->Pos = pos;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを生成します.
+//-----------------------------------------------------------------------------
+Node* EditData::CreateNode()
+{
+    auto node = m_NodePool.Alloc();
+    node->pGraph = this;
+    node->Order  = m_NextOrder++;
+    return node;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを破棄します.
+//
+//      接続を解除してハンドルを無効化し，実体の解放は ReclaimNodes() まで
+//      遅延します. それまでは同じフレーム内で保持しているポインタも有効です.
+//-----------------------------------------------------------------------------
+void EditData::DestroyNode(Node* node)
+{
+    if (node == nullptr)
+    { return; }
+
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        RemoveLinks(node->pSlots[i]);
+        m_SlotPool.Invalidate(node->pSlots[i]);
+    }
+
+    UnregisterSlots(node);
+    m_NodePool.Invalidate(node);
+    m_pGarbageNodes.push_back(node);
+}
+
+//-----------------------------------------------------------------------------
+//      破棄されたノードとスロットを解放します.
+//
+//      ポインタを保持している処理が無いフレーム終端で呼び出してください.
+//-----------------------------------------------------------------------------
+void EditData::ReclaimNodes()
+{
+    // 再計算待ちのリストに解放するノードを残さない.
+    UpdateHashes();
+
+    for(size_t i=0; i<m_pGarbageNodes.size(); ++i)
+    {
+        auto node = m_pGarbageNodes[i];
+        node->Reset();
+        m_NodePool.Free(node);
+    }
+
+    m_pGarbageNodes.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      ノードのハンドルを取得します.
+//-----------------------------------------------------------------------------
+NodeHandle EditData::GetHandle(const Node* node) const
+{ return m_NodePool.GetHandle(node); }
+
+//-----------------------------------------------------------------------------
+//      スロットのハンドルを取得します.
+//-----------------------------------------------------------------------------
+SlotHandle EditData::GetHandle(const Slot* slot) const
+{ return m_SlotPool.GetHandle(slot); }
+
+//-----------------------------------------------------------------------------
+//      ハンドルからノードを取得します. 破棄済みの場合は nullptr を返します.
+//-----------------------------------------------------------------------------
+Node* EditData::GetNode(NodeHandle handle) const
+{ return m_NodePool.Resolve(handle); }
+
+//-----------------------------------------------------------------------------
+//      ハンドルからスロットを取得します. 破棄済みの場合は nullptr を返します.
+//-----------------------------------------------------------------------------
+Slot* EditData::GetSlot(SlotHandle handle) const
+{ return m_SlotPool.Resolve(handle); }
+
+//-----------------------------------------------------------------------------
+//      スロットを生成します.
+//
+//      変数番号は編集データ毎の IdAllocator から払い出します. スレッド毎に
+//      確保したブロックから採番するので，ワーカースレッドで構築しても
+//      グローバルなロックは不要です.
+//-----------------------------------------------------------------------------
+Slot* EditData::CreateSlot(SlotType kind, DataType type, Symbol tag, Node* owner)
+{ return m_SlotPool.Alloc(kind, type, tag, owner, m_VarIds.Allocate()); }
+
+//-----------------------------------------------------------------------------
+//      スロットを破棄します.
+//-----------------------------------------------------------------------------
+void EditData::DestroySlot(Slot* slot)
+{
+    if (slot == nullptr)
+    { return; }
+
+    auto itr = m_SlotIndex.find(slot->Id);
+    if (itr != m_SlotIndex.end() && itr->second == slot)
+    { m_SlotIndex.erase(itr); }
+
+    m_SlotPool.Free(slot);
+}
+
+//-----------------------------------------------------------------------------
+//      出力スロットを入力スロットに接続します.
+//
+//      入力スロットに既に接続がある場合は置き換えます. 接続によって循環が
+//      できる場合は接続せずに false を返します.
+//-----------------------------------------------------------------------------
+bool EditData::AddLink(Slot* output, Slot* input)
+{
+    if (input->pPrev == output)
+    { return true; }
+
+    if (!UpdateOrder(output->pOwner, input->pOwner))
+    { return false; }
+
+    RemoveLink(input);
+
+    input->pPrev     = output;
+    input->NextIndex = uint32_t(output->pNexts.size());
+    output->pNexts.push_back(input);
+
+    InvalidateHash(input->pOwner);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      from から to への接続を追加できるようにトポロジカル順序を更新します.
+//
+//      Pearce-Kelly 法により，順序が逆転している区間に含まれるノードだけを
+//      探索して並べ替えます. to の下流に from がある場合は循環となるため
+//      false を返します.
+//-----------------------------------------------------------------------------
+bool EditData::UpdateOrder(Node* from, Node* to)
+{
+    if (from == to)
+    { return false; }
+
+    auto lower = to  ->Order;
+    auto upper = from->Order;
+
+    // 既に順序を満たしている.
+    if (upper < lower)
+    { return true; }
+
+    m_VisitMark++;
+
+    std::vector<Node*> forward;
+    std::vector<Node*> backward;
+    std::vector<Node*> stack;
+
+    // to から下流を upper までの範囲で探索.
+    to->VisitMark = m_VisitMark;
+    stack.push_back(to);
+    while(!stack.empty())
+    {
+        auto node = stack.back();
+        stack.pop_back();
+        forward.push_back(node);
+
+        for(size_t i=0; i<node->pSlots.size(); ++i)
+        {
+            auto slot = node->pSlots[i];
+            if (slot->Kind != SlotType::Output)
+            { continue; }
+
+            for(size_t j=0; j<slot->pNexts.size(); ++j)
+            {
+                auto next = slot->pNexts[j]->pOwner;
+                if (next == from)
+                { return false; }
+
+                if (next->VisitMark != m_VisitMark && next->Order < upper)
+                {
+                    next->VisitMark = m_VisitMark;
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+
+    // from から上流を lower までの範囲で探索.
+    from->VisitMark = m_VisitMark;
+    stack.push_back(from);
+    while(!stack.empty())
+    {
+        auto node = stack.back();
+        stack.pop_back();
+        backward.push_back(node);
+
+        for(size_t i=0; i<node->pSlots.size(); ++i)
+        {
+            auto slot = node->pSlots[i];
+            if (slot->Kind != SlotType::Input || slot->pPrev == nullptr)
+            { continue; }
+
+            auto prev = slot->pPrev->pOwner;
+            if (prev->VisitMark != m_VisitMark && prev->Order > lower)
+            {
+                prev->VisitMark = m_VisitMark;
+                stack.push_back(prev);
+            }
+        }
+    }
+
+    // 上流側を先に，下流側を後にして，区間内の順序番号を割り当て直す.
+    auto compare = [](const Node* lhs, const Node* rhs) { return lhs->Order < rhs->Order; };
+    std::sort(forward .begin(), forward .end(), compare);
+    std::sort(backward.begin(), backward.end(), compare);
+
+    std::vector<uint32_t> orders;
+    orders.reserve(forward.size() + backward.size());
+    for(size_t i=0; i<backward.size(); ++i)
+    { orders.push_back(backward[i]->Order); }
+    for(size_t i=0; i<forward.size(); ++i)
+    { orders.push_back(forward[i]->Order); }
+    std::sort(orders.begin(), orders.end());
+
+    size_t index = 0;
+    for(size_t i=0; i<backward.size(); ++i)
+    { backward[i]->Order = orders[index++]; }
+    for(size_t i=0; i<forward.size(); ++i)
+    { forward[i]->Order = orders[index++]; }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      入力スロットの接続を解除します.
+//-----------------------------------------------------------------------------
+void EditData::RemoveLink(Slot* input)
+{
+    auto prev = input->pPrev;
+    if (prev == nullptr)
+    { return; }
+
+    // 末尾の接続先と入れ替えて削除.
+    auto& nexts = prev->pNexts;
+    auto  last  = nexts.back();
+    nexts[input->NextIndex] = last;
+    last->NextIndex = input->NextIndex;
+    nexts.pop_back();
+
+    input->pPrev     = nullptr;
+    input->NextIndex = 0;
+
+    InvalidateHash(input->pOwner);
+}
+
+//-----------------------------------------------------------------------------
+//      スロットの全ての接続を解除します.
+//-----------------------------------------------------------------------------
+void EditData::RemoveLinks(Slot* slot)
+{
+    if (slot->Kind == SlotType::Input)
+    {
+        RemoveLink(slot);
+        return;
+    }
+
+    while(!slot->pNexts.empty())
+    { RemoveLink(slot->pNexts.back()); }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードのハッシュ値を再計算待ちにします.
+//
+//      編集の度に下流へ伝播すると大きなグラフでは接続の度に全体を辿るため，
+//      印を付けるだけにして UpdateHashes() でまとめて計算します.
+//-----------------------------------------------------------------------------
+void EditData::InvalidateHash(Node* node)
+{
+    if (node->HashDirty)
+    { return; }
+
+    node->HashDirty = true;
+    m_pDirtyNodes.push_back(node);
+}
+
+//-----------------------------------------------------------------------------
+//      再計算待ちのノードのハッシュ値を更新し，下流へ伝播します.
+//
+//      トポロジカル順序の小さいノードから計算するので，各ノードは全ての
+//      接続元より後に一度だけ計算されます. ハッシュ値が変わらなかった
+//      ノードの下流へは伝播しません.
+//-----------------------------------------------------------------------------
+void EditData::UpdateHashes()
+{
+    if (m_pDirtyNodes.empty())
+    { return; }
+
+    auto compare = [](const Node* lhs, const Node* rhs) { return lhs->Order > rhs->Order; };
+
+    m_VisitMark++;
+
+    std::vector<Node*> heap;
+    heap.swap(m_pDirtyNodes);
+    for(size_t i=0; i<heap.size(); ++i)
+    {
+        heap[i]->HashDirty = false;
+        heap[i]->VisitMark = m_VisitMark;
+    }
+    std::make_heap(heap.begin(), heap.end(), compare);
+
+    while(!heap.empty())
+    {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        auto node = heap.back();
+        heap.pop_back();
+
+        if (!AssignHash(node))
+        { continue; }
+
+        for(size_t i=0; i<node->pSlots.size(); ++i)
+        {
+            auto slot = node->pSlots[i];
+            if (slot->Kind != SlotType::Output)
+            { continue; }
+
+            for(size_t j=0; j<slot->pNexts.size(); ++j)
+            {
+                auto next = slot->pNexts[j]->pOwner;
+                if (next->VisitMark != m_VisitMark)
+                {
+                    next->VisitMark = m_VisitMark;
+                    heap.push_back(next);
+                    std::push_heap(heap.begin(), heap.end(), compare);
+                }
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      全てのノードのハッシュ値を計算し直します.
+//
+//      サブグラフ呼び出しノードは呼び出し先の出力ノードに依存するため，
+//      ファイル上の並び順(呼び出し先のサブグラフが先)で計算します.
+//-----------------------------------------------------------------------------
+void EditData::RefreshHashes()
+{
+    for(size_t i=0; i<m_pDirtyNodes.size(); ++i)
+    { m_pDirtyNodes[i]->HashDirty = false; }
+
+    m_pDirtyNodes.clear();
+
+    std::vector<const Node*> order;
+    GetFileOrder(order);
+
+    for(size_t i=0; i<order.size(); ++i)
+    { AssignHash(const_cast<Node*>(order[i])); }
+}
+
+//-----------------------------------------------------------------------------
+//      グラフ全体のハッシュ値を取得します.
+//
+//      ステージ出力に到達するノードとGバッファのレイアウトから決まり，
+//      シェーダコードが変わらない編集(配置の移動や未接続ノードの追加)では
+//      変化しません.
+//-----------------------------------------------------------------------------
+uint64_t EditData::GetGraphHash()
+{
+    UpdateHashes();
+    return m_pStageOutput->Hash;
+}
+
+//-----------------------------------------------------------------------------
+//      2つの編集データの差分を取得します.
+//
+//      ステージ出力から上流へ，ハッシュ値が異なるノードの組だけを辿ります.
+//      同じ入力スロットに接続されたノード同士を対応付けるので，変更の無い
+//      部分グラフは比較しません.
+//-----------------------------------------------------------------------------
+void DiffGraphs(EditData& before, EditData& after, std::vector<NodeDiff>& result)
+{
+    before.UpdateHashes();
+    after .UpdateHashes();
+
+    std::set<std::pair<const Node*, const Node*>>       visited;
+    std::vector<std::pair<const Node*, const Node*>>    stack;
+    stack.push_back(std::make_pair(before.GetStageOutput(), after.GetStageOutput()));
+
+    while(!stack.empty())
+    {
+        auto lhs = stack.back().first;
+        auto rhs = stack.back().second;
+        stack.pop_back();
+
+        if (lhs->Hash == rhs->Hash || !visited.insert(std::make_pair(lhs, rhs)).second)
+        { continue; }
+
+        if (lhs->ContentHash != rhs->ContentHash)
+        {
+            NodeDiff diff;
+            diff.Type    = NodeDiffChanged;
+            diff.pBefore = lhs;
+            diff.pAfter  = rhs;
+            result.push_back(diff);
+
+            // 呼び出し先のサブグラフが異なる場合は内部も比較する.
+            if (lhs->pSubGraph != nullptr && rhs->pSubGraph != nullptr)
+            { stack.push_back(std::make_pair(lhs->pSubGraph->pOutput, rhs->pSubGraph->pOutput)); }
+        }
+
+        auto count = (std::max)(lhs->pSlots.size(), rhs->pSlots.size());
+        for(size_t i=0; i<count; ++i)
+        {
+            auto prevBefore = GetPrevNode(lhs, i);
+            auto prevAfter  = GetPrevNode(rhs, i);
+            if (prevBefore == nullptr && prevAfter == nullptr)
+            { continue; }
+
+            NodeDiff diff;
+            diff.pBefore = lhs;
+            diff.pAfter  = rhs;
+            diff.Input   = uint32_t(i);
+
+            if (prevBefore == nullptr || prevAfter == nullptr)
+            {
+                diff.Type = (prevBefore == nullptr) ? NodeDiffLinked : NodeDiffUnlinked;
+                result.push_back(diff);
+                continue;
+            }
+
+            if (FindSlotIndex(prevBefore, lhs->pSlots[i]->pPrev) != FindSlotIndex(prevAfter, rhs->pSlots[i]->pPrev))
+            {
+                diff.Type = NodeDiffRelinked;
+                result.push_back(diff);
+            }
+
+            stack.push_back(std::make_pair(prevBefore, prevAfter));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ステージ出力ノードを生成します.
+//-----------------------------------------------------------------------------
+void EditData::InitStageOutput()
+{
+    m_pStageOutput = CreateNode();
+    m_pStageOutput->Type  = NodeType::StageOutput;
+    m_pStageOutput->Tag   = InternString("Stage Output");
+    m_pStageOutput->Order = UINT32_MAX;    // 常に全ノードの下流.
+
+    m_pStageOutput->AddInput3("BaseColor");
+    m_pStageOutput->AddInput3("Normal");
+    m_pStageOutput->AddInput1("Roughness");
+    m_pStageOutput->AddInput1("Metalness");
+    m_pStageOutput->AddInput1("Occlusion");
+    m_pStageOutput->AddInput3("Emissive");
+    UpdateStageOutput();
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを読み込みます.
+//
+//      tinyxml2 にはプル型のパーサが無いため，解析済みの文書を XMLVisitor で
+//      1回だけ走査してノードを生成します. 要素はノードとスロットのみで，
+//      値は全て属性に持たせているので文書が保持する要素数はこれに比例します.
+//      圧縮コンテナの場合はチャンクを並列に展開してから解析します.
+//-----------------------------------------------------------------------------
+bool EditData::Load(const char* path)
+{
+    FILE* pFile = nullptr;
+    if (fopen_s(&pFile, path, "rb") != 0)
+    { return false; }
+
+    Reset();
+
+    auto result = false;
+    {
+        // 圧縮コンテナは展開したバッファをそのまま解析する.
+        std::vector<uint8_t> text;
+        tinyxml2::XMLDocument doc;
+        auto error = ReadCompressedGraph(pFile, text)
+            ? doc.Parse(reinterpret_cast<const char*>(text.data()), text.size())
+            : doc.LoadFile(pFile);
+        if (error == tinyxml2::XML_SUCCESS)
+        {
+            GraphReader reader(*this);
+            doc.Accept(&reader);
+            result = reader.Finish();
+        }
+    }
+
+    fclose(pFile);
+
+    // サブグラフ名は関数名としてそのまま出力するので，ここで検証する.
+    if (!result || !CheckSubGraphNames())
+    {
+        Reset();
+        return false;
+    }
+
+    UpdateStageOutput();
+    RefreshHashes();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを書き込みます.
+//
+//      スナップショットを取り，SaveGraphXml() で書き出します.
+//-----------------------------------------------------------------------------
+bool EditData::Save(const char* path)
+{
+    GraphBinaryWriter writer;
+    CaptureSnapshot(writer);
+
+    std::vector<uint8_t> image;
+    writer.Serialize(image);
+
+    GraphBinaryView view;
+    if (!view.Attach(image.data(), image.size()))
+    { return false; }
+
+    return SaveGraphXml(view, path);
+}
+
+//-----------------------------------------------------------------------------
+//      スナップショットをXML形式で書き出します.
+//
+//      XMLPrinter でファイルに直接書き出し，文書全体は構築しません.
+//      編集データには触れないのでワーカースレッドから呼び出せます.
+//-----------------------------------------------------------------------------
+bool SaveGraphXml(const GraphBinaryView& view, const char* path, std::atomic<uint32_t>* pWritten)
+{
+    FILE* pFile = nullptr;
+    if (fopen_s(&pFile, path, "wb") != 0)
+    { return false; }
+
+    tinyxml2::XMLPrinter printer(pFile);
+    PrintGraph(printer, view, pWritten);
+
+    auto result = (ferror(pFile) == 0);
+    fclose(pFile);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      スナップショットをXML形式でメモリ上に出力します.
+//
+//      圧縮して保存する場合に使います. 終端文字は含めません.
+//-----------------------------------------------------------------------------
+void FormatGraphXml(const GraphBinaryView& view, std::vector<uint8_t>& result, std::atomic<uint32_t>* pWritten)
+{
+    tinyxml2::XMLPrinter printer;
+    PrintGraph(printer, view, pWritten);
+
+    auto text = reinterpret_cast<const uint8_t*>(printer.CStr());
+    result.assign(text, text + printer.CStrSize() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリ形式のファイルを読み込みます.
+//
+//      ファイルはメモリマップしたまま参照し，レコードの値をそのままノードに
+//      設定します. 接続元が先に並んでいるので，接続はトポロジカル順序を
+//      崩しません.
+//-----------------------------------------------------------------------------
+bool EditData::LoadBinary(const char* path)
+{
+    GraphBinaryView view;
+    if (!view.Open(path))
+    { return false; }
+
+    Reset();
+
+    auto flags = view.GetFlags();
+    m_GBufferLayout.OctahedralNormal = (flags & GraphOctahedralNormal) != 0;
+    m_GBufferLayout.YCoCgBaseColor   = (flags & GraphYCoCgBaseColor)   != 0;
+    m_GBufferLayout.PackedRMO        = (flags & GraphPackedRMO)        != 0;
+
+    for(uint32_t i=0; i<view.GetSubGraphCount(); ++i)
+    {
+        auto record   = view.GetSubGraph(i);
+        auto subGraph = new SubGraph();
+        subGraph->Name     = view.GetString(record->Name);
+        subGraph->Origin.x = record->Origin[0];
+        subGraph->Origin.y = record->Origin[1];
+        m_pSubGraphs.push_back(subGraph);
+    }
+
+    std::vector<Node*> mainNodes;
+    std::vector<Slot*> slots(view.GetSlotCount(), nullptr);
+    auto strings   = view.GetString(0);   // 文字列テーブルの先頭.
+    auto mainBegin = view.GetMainNodeBegin();
+    auto subGraph  = uint32_t(0);
+    auto result    = true;
+
+    mainNodes.reserve(view.GetNodeCount() - mainBegin);
+
+    for(uint32_t i=0; i<view.GetNodeCount() && result; ++i)
+    {
+        auto record = view.GetNode(i);
+        auto type   = NodeType(record->Type);
+
+        // サブグラフの範囲は入力ノードで始まり出力ノードで終わる.
+        SubGraph* owner = nullptr;
+        if (i < mainBegin)
+        {
+            auto range = view.GetSubGraph(subGraph);
+            auto first = (i == range->NodeBegin);
+            auto last  = (i == range->NodeBegin + range->NodeCount - 1);
+            if ((type == NodeType::SubGraphInput) != first || (type == NodeType::SubGraphOutput) != last)
+            { result = false; break; }
+
+            owner = m_pSubGraphs[subGraph];
+            if (last)
+            { subGraph++; }
+        }
+        else if (type == NodeType::SubGraphInput || type == NodeType::SubGraphOutput)
+        { result = false; break; }
+
+        Node* node = nullptr;
+        if (type == NodeType::StageOutput)
+        {
+            // ステージ出力のスロットは生成済みのものを使う.
+            node = m_pStageOutput;
+            if (i + 1 != view.GetNodeCount() || record->SlotCount != node->pSlots.size())
+            { result = false; break; }
+
+            for(uint32_t j=0; j<record->SlotCount; ++j)
+            {
+                auto slot = view.GetSlot(record->SlotBegin + j);
+                if (node->pSlots[j]->Kind != SlotType(slot->Kind) || node->pSlots[j]->Type != DataType(slot->Type))
+                { result = false; }
+
+                slots[record->SlotBegin + j] = node->pSlots[j];
+            }
+        }
+        else
+        {
+            node = RestoreNode(*this, *record, view.GetSlot(record->SlotBegin), strings);
+            if (node == nullptr)
+            { result = false; break; }
+
+            for(uint32_t j=0; j<record->SlotCount; ++j)
+            { slots[record->SlotBegin + j] = node->pSlots[j]; }
+
+            if (owner == nullptr)
+            { mainNodes.push_back(node); }
+            else if (type == NodeType::SubGraphInput)
+            { owner->pInput = node; }
+            else if (type == NodeType::SubGraphOutput)
+            { owner->pOutput = node; }
+            else
+            { owner->pNodes.push_back(node); }
+        }
+
+        node->Pos.x = record->Pos[0];
+        node->Pos.y = record->Pos[1];
+    }
+
+    for(uint32_t i=0; i<view.GetSlotCount() && result; ++i)
+    {
+        auto prev = view.GetSlotPrev(i);
+        if (prev != kGraphNoIndex && !AddLink(slots[prev], slots[i]))
+        { result = false; }
+    }
+
+    if (!result || !CheckSubGraphNames())
+    {
+        Reset();
+        return false;
+    }
+
+    AddNodes(mainNodes);
+    UpdateStageOutput();
+    RefreshHashes();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリ形式のファイルを書き込みます.
+//
+//      ノードの並び順は Save() と同じです.
+//-----------------------------------------------------------------------------
+bool EditData::SaveBinary(const char* path)
+{
+    GraphBinaryWriter writer;
+    CaptureSnapshot(writer);
+    return writer.Write(path);
+}
+
+//-----------------------------------------------------------------------------
+//      現在の編集内容のスナップショットを取ります.
+//
+//      ノードとスロットを値だけのレコードに写すので，取得後は編集データを
+//      変更しても影響を受けません. 並び順はファイル上の並び順と一致します.
+//-----------------------------------------------------------------------------
+void EditData::CaptureSnapshot(GraphBinaryWriter& writer) const
+{
+    std::vector<const Node*> order;
+    GetFileOrder(order);
+
+    // スロット番号を決定.
+    std::unordered_map<const Slot*, uint32_t> slotIds;
+    for(size_t i=0; i<order.size(); ++i)
+    {
+        for(size_t j=0; j<order[i]->pSlots.size(); ++j)
+        { slotIds[order[i]->pSlots[j]] = uint32_t(slotIds.size()); }
+    }
+
+    writer.Clear();
+    auto& strings = writer.GetStrings();
+    writer.SetFlags(
+        (m_GBufferLayout.OctahedralNormal ? GraphOctahedralNormal : 0) |
+        (m_GBufferLayout.YCoCgBaseColor   ? GraphYCoCgBaseColor   : 0) |
+        (m_GBufferLayout.PackedRMO        ? GraphPackedRMO        : 0));
+
+    uint32_t nodeBegin = 0;
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    {
+        GraphSubGraphRecord record = {};
+        record.Name      = strings.Add(m_pSubGraphs[i]->Name.c_str());
+        record.NodeBegin = nodeBegin;
+        record.NodeCount = uint32_t(m_pSubGraphs[i]->pNodes.size() + 2);   // 入出力ノードを含む.
+        record.Origin[0] = m_pSubGraphs[i]->Origin.x;
+        record.Origin[1] = m_pSubGraphs[i]->Origin.y;
+        writer.AddSubGraph(record);
+
+        nodeBegin += record.NodeCount;
+    }
+
+    uint32_t slotBegin = 0;
+    for(size_t i=0; i<order.size(); ++i)
+    {
+        auto node = order[i];
+
+        GraphNodeRecord record;
+        StoreNodeRecord(node, m_pSubGraphs, strings, record);
+        record.SlotBegin = slotBegin;
+        writer.AddNode(record);
+
+        for(size_t j=0; j<node->pSlots.size(); ++j)
+        {
+            auto slot = node->pSlots[j];
+
+            GraphSlotRecord slotRecord;
+            StoreSlotRecord(slot, uint32_t(i), strings, slotRecord);
+
+            // 接続元は自身からの相対位置で持つ.
+            if (slot->Kind == SlotType::Input && slot->pPrev != nullptr)
+            { slotRecord.Prev = int32_t(int64_t(slotIds.at(slot->pPrev)) - int64_t(slotBegin + j)); }
+
+            writer.AddSlot(slotRecord);
+        }
+
+        slotBegin += record.SlotCount;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ファイル上の並び順で全ノードを取得します.
+//
+//      サブグラフのノードが先に並び，末尾はステージ出力です.
+//      保存したファイルを読み込み直しても同じ並びになります.
+//-----------------------------------------------------------------------------
+void EditData::GetFileOrder(std::vector<const Node*>& result) const
+{
+    std::vector<std::vector<const Node*>> subGraphNodes;
+    std::vector<const Node*> nodes;
+
+    auto count = CollectFileNodes(m_pSubGraphs, m_pNodes, m_pStageOutput, subGraphNodes, nodes);
+
+    result.clear();
+    result.reserve(count);
+    for(size_t i=0; i<subGraphNodes.size(); ++i)
+    { result.insert(result.end(), subGraphNodes[i].begin(), subGraphNodes[i].end()); }
+    result.insert(result.end(), nodes.begin(), nodes.end());
+}
+
+//-----------------------------------------------------------------------------
+//      Gバッファのレイアウトを取得します.
+//-----------------------------------------------------------------------------
+const GBufferLayout& EditData::GetGBufferLayout() const
+{ return m_GBufferLayout; }
+
+//-----------------------------------------------------------------------------
+//      Gバッファのレイアウトを設定します.
+//-----------------------------------------------------------------------------
+void EditData::SetGBufferLayout(const GBufferLayout& layout)
+{
+    m_GBufferLayout = layout;
+    UpdateStageOutput();
+}
+
+//-----------------------------------------------------------------------------
+//      Gバッファのレイアウトに合わせてステージ出力のテンプレートを更新します.
+//-----------------------------------------------------------------------------
+void EditData::UpdateStageOutput()
+{
+    auto& layout = m_GBufferLayout;
+
+    std::string code;
+    code += "GBuffer gbuffer;\r\n";
+
+    if (layout.YCoCgBaseColor)
+    { code += "gbuffer.BaseColor = GBufferEncodeYCoCg(%Input0, uint2(input.Position.xy));\r\n"; }
+    else
+    { code += "gbuffer.BaseColor = %Input0;\r\n"; }
+
+    if (layout.OctahedralNormal)
+    { code += "gbuffer.Normal    = GBufferEncodeOctahedral(%Input1);\r\n"; }
+    else
+    { code += "gbuffer.Normal    = %Input1;\r\n"; }
+
+    if (layout.PackedRMO)
+    {
+        code += "gbuffer.RMO       = GBufferPackRMO(%Input2, %Input3, %Input4);\r\n";
+    }
+    else
+    {
+        code += "gbuffer.Roughness = %Input2;\r\n";
+        code += "gbuffer.Metalness = %Input3;\r\n";
+        code += "gbuffer.Occlusion = %Input4;\r\n";
+    }
+
+    code += "gbuffer.Emissive  = %Input5;\r\n";
+    code += "output = EncodeGBuffer(gbuffer);\r\n";
+
+    m_pStageOutput->SourceCodeTemplate = InternString(code);
+    InvalidateHash(m_pStageOutput);
+}
+
+//-----------------------------------------------------------------------------
+//      全品質のシェーダコードを生成します.
+//
+//      前回の生成からグラフのハッシュ値が変わっていなければ生成し直しません.
+//-----------------------------------------------------------------------------
+void EditData::GenShaderCode()
+{
+    auto hash = GetGraphHash();
+    if (m_CodeGenerated && m_CodeHash == hash)
+    { return; }
+
+    // 接続関係は全品質で共通なので1回だけ構築する.
+    m_CodeGen.pNodes = m_pNodes;
+    m_CodeGen.pNodes.push_back(m_pStageOutput);
+    m_CodeGen.Build();
+
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    {
+        auto subGraph = m_pSubGraphs[i];
+        subGraph->CodeGen.pNodes = subGraph->pNodes;
+        subGraph->CodeGen.pNodes.push_back(subGraph->pInput);
+        subGraph->CodeGen.pNodes.push_back(subGraph->pOutput);
+        subGraph->CodeGen.Build();
+    }
+
+    GenShaderCode(QualityLevel::Low);
+    GenShaderCode(QualityLevel::Medium);
+    GenShaderCode(QualityLevel::High);
+
+    m_CodeHash      = hash;
+    m_CodeGenerated = true;
+}
+
+//-----------------------------------------------------------------------------
+//      指定品質のシェーダコードを生成します.
+//-----------------------------------------------------------------------------
+void EditData::GenShaderCode(QualityLevel quality)
+{
+    std::string funcs;
+    std::string body;
+
+    // 自動生成コード.
+    {
+        std::set<SubGraph*> emitted;
+        std::vector<Node*>  validNodes;
+
+        m_CodeGen.CollectNodes(quality, validNodes);
+
+        GenContext context;
+        context.Quality = quality;
+        MergeTextureFetches(validNodes, context);
+
+        for(size_t i=0; i<validNodes.size(); ++i)
+        {
+            auto node = validNodes[i];
+
+            // サブグラフは関数として1度だけ生成する.
+            if (node->Type == NodeType::SubGraphNode)
+            { GenSubGraphFuncs(node->pSubGraph, quality, emitted, funcs); }
+
+            body += node->GenMicroCode(context);
+        }
+
+        validNodes.clear();
+    }
+
+    std::string code;
+
+    code += "//-----------------------------------------------------------------------------\r\n";
+    code += "// <auto-generated>\r\n";
+    code += "//     This code was generated by a tool.\r\n";
+    code += "//\r\n";
+    code += "//     Changes to this file may cause incorrect behavior and will be lost if\r\n";
+    code += "//     the code is regenerated.\r\n";
+    code += "// </auto-generated>\r\n";
+    code += "//-----------------------------------------------------------------------------\r\n";
+    code += "\r\n";
+
+    // Gバッファ構造体の切り替え用.
+    auto& layout = m_GBufferLayout;
+    if (layout.OctahedralNormal || layout.YCoCgBaseColor || layout.PackedRMO)
+    {
+        if (layout.OctahedralNormal)
+        { code += "#define GBUFFER_NORMAL_OCTAHEDRAL   (1)\r\n"; }
+        if (layout.YCoCgBaseColor)
+        { code += "#define GBUFFER_BASECOLOR_YCOCG     (1)\r\n"; }
+        if (layout.PackedRMO)
+        { code += "#define GBUFFER_PACKED_RMO          (1)\r\n"; }
+        code += "\r\n";
+    }
+
+    code += "#include \"ShaderEditorDefine.hlsli\"\r\n";
+    code += "#include \"ShaderEditorPreset.hlsli\"\r\n";
+    code += "\r\n";
+    code += GenGBufferFuncs(layout);
+    code += funcs;
+    code += "PSOutput main(const PSInput input)\r\n";
+    code += "{\r\n";
     code += "     PSOutput output = (PSOutput)0;\r\n";
     code += "     Geometry geometry;\r\n";
     code += "     geometry.Normal    = normalize(input.Normal);\r\n";
     code += "     geometry.Tangent   = normalize(input.Tangent);\r\n";
     code += "     geometry.Bitangent = normalize(input.Bitangent);\r\n";
     code += "\r\n";
+    code += body;
+    code += "\r\n";
+    code += "     return output;\r\n";
+    code += "}\r\n";
+
+    m_ShaderCode[quality] = code;
+}
+
+//-----------------------------------------------------------------------------
+//      シェーダを出力します.
+//-----------------------------------------------------------------------------
+bool EditData::Export()
+{
+    GenShaderCode();
+
+    // 品質ごとにファイルに出力.
+    for(auto i=0; i<=QualityLevel::High; ++i)
+    {
+        auto& code = m_ShaderCode[i];
+        auto  path = GetExportPath(m_ExportPath, QualityLevel(i));
+
+        FILE* pFile;
+        auto err = fopen_s(&pFile, path.c_str(), "wb");
+        if (err != 0)
+        { return false; }
+
+        fwrite(code.c_str(), code.size(), 1, pFile);
+        fclose(pFile);
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      全品質のシェーダをシェーダパックに追加します.
+//
+//      キーは "<name>/<品質名>" です. 名前が重複した場合は false を返します.
+//-----------------------------------------------------------------------------
+bool EditData::ExportPack(ShaderPackWriter& writer, const std::string& name)
+{
+    GenShaderCode();
+
+    for(auto i=0; i<=QualityLevel::High; ++i)
+    {
+        auto key = name + "/" + kQualityName[i];
+        if (!writer.Add(key.c_str(), uint32_t(i), m_ShaderCode[i]))
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを追加します.
+//-----------------------------------------------------------------------------
+void EditData::AddNode(Node* node)
+{
+    m_pNodes.push_back(node);
+    InvalidateHash(node);
+}
+
+//-----------------------------------------------------------------------------
+//      複数のノードをまとめて追加します.
+//-----------------------------------------------------------------------------
+void EditData::AddNodes(const std::vector<Node*>& nodes)
+{
+    m_pNodes.insert(m_pNodes.end(), nodes.begin(), nodes.end());
+
+    for(size_t i=0; i<nodes.size(); ++i)
+    { InvalidateHash(nodes[i]); }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを削除します.
+//-----------------------------------------------------------------------------
+void EditData::RemoveNode(Node* node)
+{
+    // 追加直後のノードの取り消しは末尾から外すだけで済ませる.
+    if (!m_pNodes.empty() && m_pNodes.back() == node)
+    {
+        UnregisterSlots(node);
+        m_pNodes.pop_back();
+        return;
+    }
+
+    auto itr = m_pNodes.begin();
+    while(itr != m_pNodes.end())
+    {
+        if (*itr == node)
+        {
+            UnregisterSlots(node);
+            m_pNodes.erase(itr);
+            break;
+        }
+
+        itr++;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを取得します.
+//-----------------------------------------------------------------------------
+std::vector<Node*>& EditData::GetNodes()
+{ return m_pNodes; }
+
+//-----------------------------------------------------------------------------
+//      ステージ出力を取得します.
+//-----------------------------------------------------------------------------
+Node* EditData::GetStageOutput() 
+{ return m_pStageOutput; }
+
+//-----------------------------------------------------------------------------
+//      ステージ出力を取得します.
+//-----------------------------------------------------------------------------
+const Node* EditData::GetStageOutput() const
+{ return m_pStageOutput; }
+
+//-----------------------------------------------------------------------------
+//      ノード群と内部の接続をクリップボードにコピーします.
+//
+//      ステージ出力はコピーしません. 範囲外との接続は切り捨てます.
+//-----------------------------------------------------------------------------
+void EditData::CopyNodes(const std::vector<Node*>& nodes, NodeClipboard& clipboard) const
+{
+    clipboard.Clear();
+    clipboard.Nodes.reserve(nodes.size());
 
-    // 自動生成コード挿入.
+    // 接続元が先になるように並べておけば，貼り付け時に採番される順序が
+    // そのまま接続の向きを満たす.
+    auto sorted = nodes;
+    std::sort(sorted.begin(), sorted.end(), [](const Node* lhs, const Node* rhs) { return lhs->Order < rhs->Order; });
+
+    std::unordered_map<const Slot*, int32_t> indices;
+
+    // 配置の基準となる左上位置.
+    auto origin = ImVec2(FLT_MAX, FLT_MAX);
+    for(size_t i=0; i<sorted.size(); ++i)
+    {
+        if (sorted[i]->Type == NodeType::StageOutput)
+        { continue; }
+
+        origin.x = std::min(origin.x, sorted[i]->Pos.x);
+        origin.y = std::min(origin.y, sorted[i]->Pos.y);
+    }
+
+    // ノードとスロットを格納.
+    for(size_t i=0; i<sorted.size(); ++i)
     {
-        std::deque<Node*> validNodes;
-        validNodes.push_back(&m_StageOutput);
+        auto node = sorted[i];
+        if (node->Type == NodeType::StageOutput)
+        { continue; }
 
-        for(size_t i=0; i<m_StageOutput.pSlots.size(); ++i)
+        ClipboardNode dst;
+        dst.Type                = node->Type;
+        dst.Tag                 = node->Tag;
+        dst.SourceCodeTemplate  = node->SourceCodeTemplate;
+        dst.pDescriptor         = node->pDescriptor;
+        dst.Pos                 = ImVec2(node->Pos.x - origin.x, node->Pos.y - origin.y);
+        dst.TexturePath         = node->TexturePath;
+        dst.TextureDimension    = node->TextureDimension;
+        dst.Sampler             = node->Sampler;
+        dst.AsColor             = node->AsColor;
+        dst.MinQuality          = node->MinQuality;
+        dst.FallbackInput       = node->FallbackInput;
+        dst.pSubGraph           = node->pSubGraph;
+        dst.SlotBegin           = uint32_t(clipboard.Slots.size());
+        dst.SlotCount           = uint32_t(node->pSlots.size());
+        memcpy(dst.Values, node->Values, sizeof(dst.Values));
+
+        for(size_t j=0; j<node->pSlots.size(); ++j)
         {
-            auto slot = m_StageOutput.pSlots[i]->pPrev;
-            if (slot == nullptr)
-            { continue; }
+            auto slot = node->pSlots[j];
+            indices[slot] = int32_t(clipboard.Slots.size());
 
-            CollectNodes(slot->pOwner, validNodes);
+            ClipboardSlot clip;
+            clip.Kind = slot->Kind;
+            clip.Type = slot->Type;
+            clip.Tag  = slot->Tag;
+            clipboard.Slots.push_back(clip);
         }
 
-        for(size_t i=0; i<validNodes.size(); ++i)
-        { code += validNodes[i]->GenMicroCode(); }
+        clipboard.Nodes.push_back(dst);
+    }
 
-        validNodes.clear();
+    // 範囲内の接続をスロット番号で記録.
+    for(auto itr = indices.begin(); itr != indices.end(); ++itr)
+    {
+        auto slot = itr->first;
+        if (slot->Kind != SlotType::Input || slot->pPrev == nullptr)
+        { continue; }
+
+        auto prev = indices.find(slot->pPrev);
+        if (prev == indices.end())
+        { continue; }
+
+        clipboard.Slots[itr->second].Prev = prev->second;
+        clipboard.Slots[prev->second].NextCount++;
     }
+}
 
-    code += "\r\n";
-    code += "     return output;\r\n";
-    code += "}\r\n";
+//-----------------------------------------------------------------------------
+//      クリップボードの内容を複製します.
+//
+//      スロットはクリップボード上の番号から新しいスロットに付け替えて接続を
+//      復元します. 生成したノードは result に追加するだけで編集データには
+//      追加しないため，AddNodes() でまとめて追加してください.
+//      この編集データに存在しないサブグラフの呼び出しノードは複製しません.
+//-----------------------------------------------------------------------------
+void EditData::PasteNodes(const NodeClipboard& clipboard, const ImVec2& pos, std::vector<Node*>& result)
+{
+    std::vector<Slot*> slots(clipboard.Slots.size(), nullptr);
+    result.reserve(result.size() + clipboard.Nodes.size());
+
+    // ノードとスロットを生成.
+    for(size_t i=0; i<clipboard.Nodes.size(); ++i)
+    {
+        auto& src = clipboard.Nodes[i];
+        if (src.pSubGraph != nullptr
+        && std::find(m_pSubGraphs.begin(), m_pSubGraphs.end(), src.pSubGraph) == m_pSubGraphs.end())
+        { continue; }
+
+        auto node = CreateNode();
+        node->Type                = src.Type;
+        node->Tag                 = src.Tag;
+        node->SourceCodeTemplate  = src.SourceCodeTemplate;
+        node->pDescriptor         = src.pDescriptor;
+        node->Pos                 = ImVec2(src.Pos.x + pos.x, src.Pos.y + pos.y);
+        node->TexturePath         = src.TexturePath;
+        node->TextureDimension    = src.TextureDimension;
+        node->Sampler             = src.Sampler;
+        node->AsColor             = src.AsColor;
+        node->MinQuality          = src.MinQuality;
+        node->FallbackInput       = src.FallbackInput;
+        node->pSubGraph           = src.pSubGraph;
+        memcpy(node->Values, src.Values, sizeof(node->Values));
+
+        node->pSlots.reserve(src.SlotCount);
+        for(uint32_t j=0; j<src.SlotCount; ++j)
+        {
+            auto& clip = clipboard.Slots[src.SlotBegin + j];
+            auto  slot = CreateSlot(clip.Kind, clip.Type, clip.Tag, node);
+            slot->pNexts.reserve(clip.NextCount);
+            node->pSlots.push_back(slot);
+            slots[src.SlotBegin + j] = slot;
+        }
+
+        result.push_back(node);
+    }
+
+    // 接続を復元. 入力スロットは全て未接続なので置き換えの確認は不要.
+    for(size_t i=0; i<clipboard.Slots.size(); ++i)
+    {
+        auto prev = clipboard.Slots[i].Prev;
+        if (prev < 0 || slots[i] == nullptr || slots[prev] == nullptr)
+        { continue; }
 
-    m_ShaderCode = code;
+        auto input  = slots[i];
+        auto output = slots[prev];
+        input->pPrev     = output;
+        input->NextIndex = uint32_t(output->pNexts.size());
+        output->pNexts.push_back(input);
+    }
 }
 
 //-----------------------------------------------------------------------------
-//      シェーダを出力します.
+//      ノード群をサブグラフに集約します.
+//
+//      集約できない場合は何も変更せず nullptr を返し，pError に理由を設定します.
 //-----------------------------------------------------------------------------
-bool EditData::Export()
+Node* EditData::CollapseNodes(const std::vector<Node*>& nodes, const char* name, CollapseError* pError)
 {
-    GenShaderCode();
+    auto fail = [pError](CollapseError error)
+    {
+        if (pError != nullptr)
+        { *pError = error; }
+        return nullptr;
+    };
+
+    if (!IsValidSubGraphName(name))
+    { return fail(CollapseInvalidName); }
 
-    // ファイルに出力.
+    // 集約対象を決定. ステージ出力と未登録のノードは除外.
+    std::set<Node*> targets;
+    for(size_t i=0; i<nodes.size(); ++i)
     {
-        FILE* pFile;
-        auto err = fopen_s(&pFile, m_ExportPath.c_str(), "wb");
-        if (err != 0)
-        { return false; }
+        auto node = nodes[i];
+        if (node == nullptr || node->Type == NodeType::StageOutput)
+        { continue; }
 
-        fwrite(m_ShaderCode.c_str(), m_ShaderCode.size(), 1, pFile);
-        fclose(pFile);
+        if (std::find(m_pNodes.begin(), m_pNodes.end(), node) == m_pNodes.end())
+        { continue; }
+
+        targets.insert(node);
+    }
+
+    if (targets.empty())
+    { return fail(CollapseNoTarget); }
+
+    // 集約対象の外を経由して集約対象に戻る経路があると，集約後に循環となる.
+    {
+        std::set<Node*>    visited;
+        std::vector<Node*> stack;
+        for(auto itr = targets.begin(); itr != targets.end(); ++itr)
+        { stack.push_back(*itr); }
+
+        while(!stack.empty())
+        {
+            auto node = stack.back();
+            stack.pop_back();
+
+            for(size_t i=0; i<node->pSlots.size(); ++i)
+            {
+                auto slot = node->pSlots[i];
+                if (slot->Kind != SlotType::Output)
+                { continue; }
+
+                for(size_t j=0; j<slot->pNexts.size(); ++j)
+                {
+                    auto next = slot->pNexts[j]->pOwner;
+                    auto inside = targets.find(next) != targets.end();
+                    if (inside && targets.find(node) == targets.end())
+                    { return fail(CollapseCycle); }
+
+                    if (!inside && visited.insert(next).second)
+                    { stack.push_back(next); }
+                }
+            }
+        }
+    }
+
+    auto subGraph = new SubGraph();
+    subGraph->Name = name;
+
+    subGraph->pInput = CreateNode();
+    subGraph->pInput->Type = NodeType::SubGraphInput;
+    subGraph->pInput->Tag  = InternString("Input");
+
+    subGraph->pOutput = CreateNode();
+    subGraph->pOutput->Type = NodeType::SubGraphOutput;
+    subGraph->pOutput->Tag  = InternString("Output");
+
+    // 配置位置は集約ノードの中心とする.
+    ImVec2 center(0.0f, 0.0f);
+    for(auto itr = targets.begin(); itr != targets.end(); ++itr)
+    {
+        center.x += (*itr)->Pos.x;
+        center.y += (*itr)->Pos.y;
+    }
+    center.x /= float(targets.size());
+    center.y /= float(targets.size());
+    subGraph->Origin = center;
+
+    // 外部からの入力と外部への出力を境界スロットに付け替える.
+    // 同じ外部出力を参照する入力は1つの境界スロットを共有する.
+    std::vector<std::pair<Slot*, Slot*>>                inputs;     // (外部出力, 境界出力)
+    std::vector<std::pair<Slot*, std::vector<Slot*>>>   outputs;    // (境界入力, 外部入力)
+    std::map<Slot*, Slot*>                              boundaries; // 外部出力 -> 境界出力
+    for(size_t i=0; i<m_pNodes.size(); ++i)
+    {
+        auto node = m_pNodes[i];
+        if (targets.find(node) == targets.end())
+        { continue; }
+
+        for(size_t j=0; j<node->pSlots.size(); ++j)
+        {
+            auto slot = node->pSlots[j];
+            if (slot->Kind == SlotType::Input)
+            {
+                auto prev = slot->pPrev;
+                if (prev == nullptr || targets.find(prev->pOwner) != targets.end())
+                { continue; }
+
+                auto found = boundaries.find(prev);
+                if (found == boundaries.end())
+                {
+                    subGraph->pInput->AddOutput(slot->Tag, slot->Type);
+                    auto boundary = subGraph->pInput->pSlots.back();
+                    inputs.push_back(std::make_pair(prev, boundary));
+                    found = boundaries.insert(std::make_pair(prev, boundary)).first;
+                }
+
+                AddLink(found->second, slot);
+            }
+            else
+            {
+                std::vector<Slot*> externals;
+                for(size_t k=0; k<slot->pNexts.size(); ++k)
+                {
+                    auto next = slot->pNexts[k];
+                    if (targets.find(next->pOwner) == targets.end())
+                    { externals.push_back(next); }
+                }
+
+                if (externals.empty())
+                { continue; }
+
+                subGraph->pOutput->AddInput(slot->Tag, slot->Type);
+                auto boundary = subGraph->pOutput->pSlots.back();
+                AddLink(slot, boundary);
+                outputs.push_back(std::make_pair(boundary, externals));
+            }
+        }
+
+        subGraph->pNodes.push_back(node);
+    }
+
+    // 集約したノードを取り除く.
+    auto itr = m_pNodes.begin();
+    while(itr != m_pNodes.end())
+    {
+        if (targets.find(*itr) != targets.end())
+        {
+            UnregisterSlots(*itr);
+            itr = m_pNodes.erase(itr);
+        }
+        else
+        { itr++; }
+    }
+
+    m_pSubGraphs.push_back(subGraph);
+
+    // 呼び出しノードを生成して外部と接続.
+    auto node = CreateSubGraphNode(subGraph);
+    node->Pos = center;
+
+    size_t input  = 0;
+    size_t output = 0;
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        auto slot = node->pSlots[i];
+        if (slot->Kind == SlotType::Input)
+        {
+            AddLink(inputs[input].first, slot);
+            input++;
+        }
+        else
+        {
+            auto& externals = outputs[output].second;
+            for(size_t j=0; j<externals.size(); ++j)
+            { AddLink(slot, externals[j]); }
+            output++;
+        }
+    }
+
+    m_pNodes.push_back(node);
+    RefreshHashes();
+
+    if (pError != nullptr)
+    { *pError = CollapseOk; }
+
+    return node;
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフ呼び出しノードを展開します.
+//-----------------------------------------------------------------------------
+bool EditData::ExpandSubGraph(Node* node)
+{
+    if (node == nullptr || node->Type != NodeType::SubGraphNode)
+    { return false; }
+
+    auto subGraph = node->pSubGraph;
+
+    // 境界スロットに対応する呼び出しノード側のスロット.
+    std::vector<Slot*> inputs;
+    std::vector<Slot*> outputs;
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        auto slot = node->pSlots[i];
+        if (slot->Kind == SlotType::Input)
+        { inputs.push_back(slot); }
+        else
+        { outputs.push_back(slot); }
+    }
+
+    // 内部ノードを複製.
+    std::map<const Node*, Node*> clones;
+    for(size_t i=0; i<subGraph->pNodes.size(); ++i)
+    {
+        auto src   = subGraph->pNodes[i];
+        auto clone = CloneNode(src);
+        clone->Pos.x = src->Pos.x - subGraph->Origin.x + node->Pos.x;
+        clone->Pos.y = src->Pos.y - subGraph->Origin.y + node->Pos.y;
+        clones[src] = clone;
+    }
+
+    // 内部の接続と外部からの入力を復元.
+    for(size_t i=0; i<subGraph->pNodes.size(); ++i)
+    {
+        auto src   = subGraph->pNodes[i];
+        auto clone = clones[src];
+
+        for(size_t j=0; j<src->pSlots.size(); ++j)
+        {
+            auto slot = src->pSlots[j];
+            if (slot->Kind != SlotType::Input || slot->pPrev == nullptr)
+            { continue; }
+
+            auto prev = slot->pPrev;
+            if (prev->pOwner == subGraph->pInput)
+            {
+                auto external = inputs[FindSlotIndex(subGraph->pInput, prev)]->pPrev;
+                if (external != nullptr)
+                { AddLink(external, clone->pSlots[j]); }
+            }
+            else
+            {
+                auto owner = clones[prev->pOwner];
+                AddLink(owner->pSlots[FindSlotIndex(prev->pOwner, prev)], clone->pSlots[j]);
+            }
+        }
+    }
+
+    // 外部への出力を復元.
+    for(size_t i=0; i<subGraph->pOutput->pSlots.size(); ++i)
+    {
+        auto boundary  = subGraph->pOutput->pSlots[i];
+        auto externals = outputs[i]->pNexts;
+        auto prev      = boundary->pPrev;
+        if (prev == nullptr)
+        { continue; }
+
+        Slot* source = nullptr;
+        if (prev->pOwner == subGraph->pInput)
+        {
+            // 入力がそのまま出力に渡っている.
+            source = inputs[FindSlotIndex(subGraph->pInput, prev)]->pPrev;
+        }
+        else
+        {
+            auto owner = clones[prev->pOwner];
+            source = owner->pSlots[FindSlotIndex(prev->pOwner, prev)];
+        }
+
+        for(size_t j=0; j<externals.size(); ++j)
+        {
+            if (source != nullptr)
+            { AddLink(source, externals[j]); }
+            else
+            { RemoveLink(externals[j]); }
+        }
     }
 
+    for(size_t i=0; i<subGraph->pNodes.size(); ++i)
+    { m_pNodes.push_back(clones[subGraph->pNodes[i]]); }
+
+    // 呼び出しノードを破棄.
+    RemoveNode(node);
+    DestroyNode(node);
+
+    RefreshHashes();
     return true;
 }
 
 //-----------------------------------------------------------------------------
-//      ノードを追加します.
+//      サブグラフ呼び出しノードを生成します.
 //-----------------------------------------------------------------------------
-void EditData::AddNode(Node* node)
-{ m_pNodes.push_back(node); }
+Node* EditData::CreateSubGraphNode(SubGraph* subGraph)
+{
+    auto node = CreateNode();
+    node->Type      = NodeType::SubGraphNode;
+    node->Tag       = InternString(subGraph->Name);
+    node->pSubGraph = subGraph;
+
+    for(size_t i=0; i<subGraph->pInput->pSlots.size(); ++i)
+    {
+        auto slot = subGraph->pInput->pSlots[i];
+        node->AddInput(slot->Tag, slot->Type);
+    }
+
+    for(size_t i=0; i<subGraph->pOutput->pSlots.size(); ++i)
+    {
+        auto slot = subGraph->pOutput->pSlots[i];
+        node->AddOutput(slot->Tag, slot->Type);
+    }
+
+    return node;
+}
 
 //-----------------------------------------------------------------------------
-//      ノードを削除します.
+//      ノードを複製します. 接続は複製しません.
 //-----------------------------------------------------------------------------
-void EditData::RemoveNode(Node* node)
+Node* EditData::CloneNode(const Node* node)
 {
-    auto itr = m_pNodes.begin();
-    while(itr != m_pNodes.end())
+    auto result = CreateNode();
+    result->Type                = node->Type;
+    result->Tag                 = node->Tag;
+    result->SourceCodeTemplate  = node->SourceCodeTemplate;
+    result->pDescriptor         = node->pDescriptor;
+    result->Pos                 = node->Pos;
+    result->Size                = node->Size;
+    result->TexturePath         = node->TexturePath;
+    result->TextureDimension    = node->TextureDimension;
+    result->Sampler             = node->Sampler;
+    result->AsColor             = node->AsColor;
+    result->MinQuality          = node->MinQuality;
+    result->FallbackInput       = node->FallbackInput;
+    result->pSubGraph           = node->pSubGraph;
+    memcpy(result->Values, node->Values, sizeof(result->Values));
+
+    for(size_t i=0; i<node->pSlots.size(); ++i)
     {
-        if (*itr == node)
+        auto slot = node->pSlots[i];
+        if (slot->Kind == SlotType::Input)
+        { result->AddInput(slot->Tag, slot->Type); }
+        else
+        { result->AddOutput(slot->Tag, slot->Type); }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフ名を変更します.
+//
+//      識別子でない名前や他のサブグラフと重複する名前の場合は変更せず
+//      false を返します.
+//-----------------------------------------------------------------------------
+bool EditData::RenameSubGraph(SubGraph* subGraph, const char* name)
+{
+    if (!IsValidSubGraphName(name, subGraph))
+    { return false; }
+
+    subGraph->Name = name;
+
+    auto tag = InternString(name);
+
+    for(size_t i=0; i<m_pNodes.size(); ++i)
+    {
+        if (m_pNodes[i]->pSubGraph == subGraph)
+        { m_pNodes[i]->Tag = tag; }
+    }
+
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    {
+        auto& nodes = m_pSubGraphs[i]->pNodes;
+        for(size_t j=0; j<nodes.size(); ++j)
         {
-            m_pNodes.erase(itr);
-            break;
+            if (nodes[j]->pSubGraph == subGraph)
+            { nodes[j]->Tag = tag; }
         }
+    }
 
-        itr++;
+    RefreshHashes();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフ名として使えるかどうかチェックします.
+//
+//      名前は関数名としてシェーダコードにそのまま出力するので，識別子であり，
+//      他のサブグラフと重複しない必要があります. subGraph 自身の名前とは
+//      比較しません.
+//-----------------------------------------------------------------------------
+bool EditData::IsValidSubGraphName(const char* name, const SubGraph* subGraph) const
+{
+    if (name == nullptr || !StringHelper::IsVariable(name))
+    { return false; }
+
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    {
+        if (m_pSubGraphs[i] != subGraph && m_pSubGraphs[i]->Name == name)
+        { return false; }
     }
+
+    return true;
 }
 
 //-----------------------------------------------------------------------------
-//      ノードを取得します.
+//      既存のサブグラフと重複しないサブグラフ名を生成します.
 //-----------------------------------------------------------------------------
-std::vector<Node*>& EditData::GetNodes()
-{ return m_pNodes; }
+std::string EditData::MakeSubGraphName() const
+{
+    for(size_t i=m_pSubGraphs.size(); ; ++i)
+    {
+        auto name = StringHelper::Format("SubGraph%zu", i);
+        if (IsValidSubGraphName(name.c_str()))
+        { return name; }
+    }
+}
 
 //-----------------------------------------------------------------------------
-//      ステージ出力を取得します.
+//      読み込んだサブグラフ名が全て使えるかどうかチェックします.
 //-----------------------------------------------------------------------------
-Node* EditData::GetStageOutput() 
-{ return &m_StageOutput; }
+bool EditData::CheckSubGraphNames() const
+{
+    for(size_t i=0; i<m_pSubGraphs.size(); ++i)
+    {
+        if (!IsValidSubGraphName(m_pSubGraphs[i]->Name.c_str(), m_pSubGraphs[i]))
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフを取得します.
+//-----------------------------------------------------------------------------
+std::vector<SubGraph*>& EditData::GetSubGraphs()
+{ return m_pSubGraphs; }
 
 //-----------------------------------------------------------------------------
 //      シェーダコードを生成します.
 //-----------------------------------------------------------------------------
-const std::string& EditData::GetShaderCode() const
-{ return m_ShaderCode; }
+const std::string& EditData::GetShaderCode(QualityLevel quality) const
+{ return m_ShaderCode[quality]; }
+
+//-----------------------------------------------------------------------------
+//      最後にシェーダコードを生成したときのグラフのハッシュ値を取得します.
+//
+//      生成していない場合は 0 を返します. GetGraphHash() と異なる場合は
+//      生成後にグラフが編集されています.
+//-----------------------------------------------------------------------------
+uint64_t EditData::GetCodeHash() const
+{ return m_CodeGenerated ? m_CodeHash : 0; }
 
 //-----------------------------------------------------------------------------
 //      スロットを検索します.
 //-----------------------------------------------------------------------------
 bool EditData::FindSlot(ImGuiID slotId, Slot** pResult)
 {
-    for(size_t i=0; i<m_pNodes.size(); ++i)
+    auto itr = m_SlotIndex.find(slotId);
+    if (itr == m_SlotIndex.end())
+    { return false; }
+
+    *pResult = itr->second;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      スロットのIDを設定し，検索用の索引を更新します.
+//-----------------------------------------------------------------------------
+void EditData::SetSlotId(Slot* slot, ImGuiID slotId)
+{
+    if (slot->Id == slotId)
     {
-        auto node = m_pNodes[i];
-        for(size_t j=0; j<node->pSlots.size(); ++j)
-        {
-            auto slot = node->pSlots[j];
-            if (slot->Id == slotId)
-            {
-                *pResult = slot;
-                return true;
-            }
-        }
+        // 索引から外れている場合のみ登録し直す.
+        auto itr = m_SlotIndex.find(slotId);
+        if (itr != m_SlotIndex.end() && itr->second == slot)
+        { return; }
     }
-
-    for(size_t i=0; i<m_StageOutput.pSlots.size(); ++i)
+    else
     {
-        auto slot = m_StageOutput.pSlots[i];
-        if (slot->Id == slotId)
-        {
-            *pResult = slot;
-            return true;
-        }
+        auto itr = m_SlotIndex.find(slot->Id);
+        if (itr != m_SlotIndex.end() && itr->second == slot)
+        { m_SlotIndex.erase(itr); }
+
+        slot->Id = slotId;
     }
 
-    return false;
+    if (slotId != 0)
+    { m_SlotIndex[slotId] = slot; }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードのスロットを検索用の索引から外します.
+//-----------------------------------------------------------------------------
+void EditData::UnregisterSlots(const Node* node)
+{
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        auto slot = node->pSlots[i];
+        auto itr  = m_SlotIndex.find(slot->Id);
+        if (itr != m_SlotIndex.end() && itr->second == slot)
+        { m_SlotIndex.erase(itr); }
+    }
 }
@@ -0,0 +1,482 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <EditHistory.h>
+#include <EditJournal.h>
+#include <cstring>
+
+
+///////////////////////////////////////////////////////////////////////////////
+// EditHistory class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+EditHistory::EditHistory(EditData& data)
+: m_Data(data)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//
+//      保持しているノードは編集データのプールと共に解放されるため，
+//      ここでは破棄しません.
+//-----------------------------------------------------------------------------
+EditHistory::~EditHistory()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      以降の操作を1回の取り消し単位にまとめます.
+//-----------------------------------------------------------------------------
+void EditHistory::BeginGroup()
+{
+    if (m_GroupDepth == 0)
+    { m_GroupCounter++; }
+
+    m_GroupDepth++;
+}
+
+//-----------------------------------------------------------------------------
+//      取り消し単位のまとめを終了します.
+//-----------------------------------------------------------------------------
+void EditHistory::EndGroup()
+{
+    if (m_GroupDepth == 0)
+    { return; }
+
+    m_GroupDepth--;
+    if (m_GroupDepth == 0)
+    { Evict(); }
+}
+
+//-----------------------------------------------------------------------------
+//      ドラッグ中の移動・値変更の結合を打ち切ります.
+//-----------------------------------------------------------------------------
+void EditHistory::Seal()
+{ m_Sealed = true; }
+
+//-----------------------------------------------------------------------------
+//      ノードを追加します.
+//-----------------------------------------------------------------------------
+void EditHistory::AddNode(Node* node)
+{
+    auto& command = Push(CommandAddNode, node);
+    Apply(command);
+    Evict();
+}
+
+//-----------------------------------------------------------------------------
+//      接続済みの複数のノードをまとめて追加します.
+//
+//      ノード間の接続はノードと共にグラフから外れるため記録しません.
+//-----------------------------------------------------------------------------
+void EditHistory::AddNodes(const std::vector<Node*>& nodes)
+{
+    if (nodes.empty())
+    { return; }
+
+    BeginGroup();
+
+    for(size_t i=0; i<nodes.size(); ++i)
+    { Push(CommandAddNode, nodes[i]); }
+
+    m_Data.AddNodes(nodes);
+
+    if (m_pJournal != nullptr)
+    { m_pJournal->AddNodes(nodes); }
+
+    EndGroup();
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの接続を全て解除してから削除します.
+//-----------------------------------------------------------------------------
+void EditHistory::RemoveNode(Node* node)
+{
+    BeginGroup();
+
+    for(size_t i=0; i<node->pSlots.size(); ++i)
+    {
+        auto slot = node->pSlots[i];
+        if (slot->Kind == SlotType::Input)
+        { RemoveLink(slot); }
+        else
+        {
+            while(!slot->pNexts.empty())
+            { RemoveLink(slot->pNexts.back()); }
+        }
+    }
+
+    auto& command = Push(CommandRemoveNode, node);
+    Apply(command);
+
+    EndGroup();
+}
+
+//-----------------------------------------------------------------------------
+//      出力スロットを入力スロットに接続します.
+//
+//      循環ができるため接続できなかった場合は記録せずに false を返します.
+//-----------------------------------------------------------------------------
+bool EditHistory::AddLink(Slot* output, Slot* input)
+{
+    if (input->pPrev == output)
+    { return true; }
+
+    auto oldOutput = input->pPrev;
+    if (!m_Data.AddLink(output, input))
+    { return false; }
+
+    auto& command = Push(CommandAddLink, input->pOwner);
+    command.pOutput    = output;
+    command.pInput     = input;
+    command.pOldOutput = oldOutput;
+
+    if (m_pJournal != nullptr)
+    { m_pJournal->Record(command, false); }
+
+    Evict();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      入力スロットの接続を解除します.
+//-----------------------------------------------------------------------------
+void EditHistory::RemoveLink(Slot* input)
+{
+    if (input->pPrev == nullptr)
+    { return; }
+
+    auto& command = Push(CommandRemoveLink, input->pOwner);
+    command.pOutput = input->pPrev;
+    command.pInput  = input;
+    Apply(command);
+    Evict();
+}
+
+//-----------------------------------------------------------------------------
+//      変更済みの定数値を記録します.
+//
+//      ドラッグ中の連続した変更は1つのコマンドに結合します.
+//-----------------------------------------------------------------------------
+void EditHistory::SetValues(Node* node, const float* oldValues)
+{
+    if (memcmp(node->Values, oldValues, sizeof(node->Values)) == 0)
+    { return; }
+
+    m_Data.InvalidateHash(node);
+
+    if (m_pJournal != nullptr)
+    { m_pJournal->SetValues(node); }
+
+    DiscardRedo();
+
+    if (!m_Sealed && m_Cursor > 0)
+    {
+        auto& last = m_Commands[m_Cursor - 1];
+        if (last.Type == CommandSetValues && last.pNode == node)
+        {
+            memcpy(last.NewValues, node->Values, sizeof(last.NewValues));
+            return;
+        }
+    }
+
+    auto& command = Push(CommandSetValues, node);
+    memcpy(command.OldValues, oldValues,    sizeof(command.OldValues));
+    memcpy(command.NewValues, node->Values, sizeof(command.NewValues));
+    m_Sealed = false;
+    Evict();
+}
+
+//-----------------------------------------------------------------------------
+//      移動済みのノード位置を記録します.
+//
+//      ドラッグ中の連続した移動は1つのコマンドに結合します.
+//-----------------------------------------------------------------------------
+void EditHistory::MoveNode(Node* node, const ImVec2& oldPos)
+{
+    if (node->Pos.x == oldPos.x && node->Pos.y == oldPos.y)
+    { return; }
+
+    if (m_pJournal != nullptr)
+    { m_pJournal->MoveNode(node); }
+
+    DiscardRedo();
+
+    if (!m_Sealed && m_Cursor > 0)
+    {
+        auto& last = m_Commands[m_Cursor - 1];
+        if (last.Type == CommandMoveNode && last.pNode == node)
+        {
+            last.NewPos = node->Pos;
+            return;
+        }
+    }
+
+    auto& command = Push(CommandMoveNode, node);
+    command.OldPos = oldPos;
+    command.NewPos = node->Pos;
+    m_Sealed = false;
+    Evict();
+}
+
+//-----------------------------------------------------------------------------
+//      直前の取り消し単位を元に戻します.
+//-----------------------------------------------------------------------------
+bool EditHistory::Undo()
+{
+    if (m_GroupDepth != 0 || m_Cursor == 0)
+    { return false; }
+
+    auto group = m_Commands[m_Cursor - 1].Group;
+    while(m_Cursor > 0 && m_Commands[m_Cursor - 1].Group == group)
+    {
+        m_Cursor--;
+        Revert(m_Commands[m_Cursor]);
+    }
+
+    m_Sealed = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      元に戻した取り消し単位をやり直します.
+//-----------------------------------------------------------------------------
+bool EditHistory::Redo()
+{
+    if (m_GroupDepth != 0 || m_Cursor == m_Commands.size())
+    { return false; }
+
+    auto group = m_Commands[m_Cursor].Group;
+    while(m_Cursor < m_Commands.size() && m_Commands[m_Cursor].Group == group)
+    {
+        Apply(m_Commands[m_Cursor]);
+        m_Cursor++;
+    }
+
+    m_Sealed = true;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      元に戻せるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool EditHistory::CanUndo() const
+{ return m_GroupDepth == 0 && m_Cursor > 0; }
+
+//-----------------------------------------------------------------------------
+//      やり直せるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool EditHistory::CanRedo() const
+{ return m_GroupDepth == 0 && m_Cursor < m_Commands.size(); }
+
+//-----------------------------------------------------------------------------
+//      履歴を破棄します.
+//
+//      グラフから外れたまま戻せなくなるノードはここで破棄します.
+//      編集データをリセットする前に呼び出してください.
+//-----------------------------------------------------------------------------
+void EditHistory::Clear()
+{
+    for(size_t i=0; i<m_Commands.size(); ++i)
+    { Release(m_Commands[i], i >= m_Cursor); }
+
+    m_Commands.clear();
+    m_Cursor      = 0;
+    m_MemoryUsage = 0;
+    m_Sealed      = true;
+}
+
+//-----------------------------------------------------------------------------
+//      変更の記録先となるジャーナルを設定します. nullptr で記録を止めます.
+//-----------------------------------------------------------------------------
+void EditHistory::SetJournal(EditJournal* journal)
+{ m_pJournal = journal; }
+
+//-----------------------------------------------------------------------------
+//      履歴が使用できるメモリ量の上限を設定します.
+//-----------------------------------------------------------------------------
+void EditHistory::SetMemoryBudget(size_t bytes)
+{
+    m_MemoryBudget = bytes;
+    Evict();
+}
+
+//-----------------------------------------------------------------------------
+//      履歴が使用できるメモリ量の上限を取得します.
+//-----------------------------------------------------------------------------
+size_t EditHistory::GetMemoryBudget() const
+{ return m_MemoryBudget; }
+
+//-----------------------------------------------------------------------------
+//      履歴が使用しているメモリ量の見積もりを取得します.
+//-----------------------------------------------------------------------------
+size_t EditHistory::GetMemoryUsage() const
+{ return m_MemoryUsage; }
+
+//-----------------------------------------------------------------------------
+//      コマンドを追加します.
+//-----------------------------------------------------------------------------
+EditCommand& EditHistory::Push(EditCommandType type, Node* node)
+{
+    DiscardRedo();
+
+    EditCommand command = {};
+    command.Type  = type;
+    command.Group = (m_GroupDepth > 0) ? m_GroupCounter : ++m_GroupCounter;
+    command.pNode = node;
+
+    m_Commands.push_back(command);
+    m_Cursor++;
+    m_MemoryUsage += GetCommandSize(command);
+    m_Sealed = true;
+
+    return m_Commands.back();
+}
+
+//-----------------------------------------------------------------------------
+//      やり直し用のコマンドを破棄します.
+//-----------------------------------------------------------------------------
+void EditHistory::DiscardRedo()
+{
+    while(m_Commands.size() > m_Cursor)
+    {
+        auto& command = m_Commands.back();
+        m_MemoryUsage -= GetCommandSize(command);
+        Release(command, true);
+        m_Commands.pop_back();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      メモリ量が上限を超えている間，古い取り消し単位から破棄します.
+//
+//      最新の取り消し単位は上限を超えていても残します.
+//-----------------------------------------------------------------------------
+void EditHistory::Evict()
+{
+    if (m_GroupDepth != 0)
+    { return; }
+
+    while(m_MemoryUsage > m_MemoryBudget && m_Cursor > 0)
+    {
+        auto group = m_Commands.front().Group;
+        if (group == m_Commands[m_Cursor - 1].Group)
+        { break; }
+
+        while(m_Commands.front().Group == group)
+        {
+            auto& command = m_Commands.front();
+            m_MemoryUsage -= GetCommandSize(command);
+            Release(command, false);
+            m_Commands.pop_front();
+            m_Cursor--;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドを適用します.
+//-----------------------------------------------------------------------------
+void EditHistory::Apply(const EditCommand& command)
+{
+    switch(command.Type)
+    {
+    case CommandAddNode:
+        m_Data.AddNode(command.pNode);
+        break;
+
+    case CommandRemoveNode:
+        m_Data.RemoveNode(command.pNode);
+        break;
+
+    case CommandAddLink:
+        m_Data.AddLink(command.pOutput, command.pInput);
+        break;
+
+    case CommandRemoveLink:
+        m_Data.RemoveLink(command.pInput);
+        break;
+
+    case CommandSetValues:
+        memcpy(command.pNode->Values, command.NewValues, sizeof(command.NewValues));
+        m_Data.InvalidateHash(command.pNode);
+        break;
+
+    case CommandMoveNode:
+        command.pNode->Pos = command.NewPos;
+        break;
+    }
+
+    if (m_pJournal != nullptr)
+    { m_pJournal->Record(command, false); }
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドを取り消します.
+//-----------------------------------------------------------------------------
+void EditHistory::Revert(const EditCommand& command)
+{
+    switch(command.Type)
+    {
+    case CommandAddNode:
+        m_Data.RemoveNode(command.pNode);
+        break;
+
+    case CommandRemoveNode:
+        m_Data.AddNode(command.pNode);
+        break;
+
+    case CommandAddLink:
+        {
+            if (command.pOldOutput != nullptr)
+            { m_Data.AddLink(command.pOldOutput, command.pInput); }
+            else
+            { m_Data.RemoveLink(command.pInput); }
+        }
+        break;
+
+    case CommandRemoveLink:
+        m_Data.AddLink(command.pOutput, command.pInput);
+        break;
+
+    case CommandSetValues:
+        memcpy(command.pNode->Values, command.OldValues, sizeof(command.OldValues));
+        m_Data.InvalidateHash(command.pNode);
+        break;
+
+    case CommandMoveNode:
+        command.pNode->Pos = command.OldPos;
+        break;
+    }
+
+    if (m_pJournal != nullptr)
+    { m_pJournal->Record(command, true); }
+}
+
+//-----------------------------------------------------------------------------
+//      履歴から外れるコマンドが保持していたノードを破棄します.
+//
+//      取り消し済みの追加と，適用済みの削除はグラフに戻す手段がなくなります.
+//-----------------------------------------------------------------------------
+void EditHistory::Release(const EditCommand& command, bool undone)
+{
+    if ((undone  && command.Type == CommandAddNode)
+    ||  (!undone && command.Type == CommandRemoveNode))
+    { m_Data.DestroyNode(command.pNode); }
+}
+
+//-----------------------------------------------------------------------------
+//      コマンドのメモリ量を見積もります.
+//
+//      削除したノードはスロットごと履歴が保持するものとして加算します.
+//-----------------------------------------------------------------------------
+size_t EditHistory::GetCommandSize(const EditCommand& command) const
+{
+    auto size = sizeof(EditCommand);
+    if (command.Type == CommandRemoveNode)
+    { size += sizeof(Node) + command.pNode->pSlots.size() * sizeof(Slot); }
+
+    return size;
+}
@@ -0,0 +1,969 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <EditJournal.h>
+#include <EditHistory.h>
+#include <GraphBinary.h>
+#include <ShaderPack.h>
+#include <Windows.h>
+#include <io.h>
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+static const uint32_t kJournalMagic     = 0x4C4E4A53;    // 'SJNL'
+static const uint32_t kJournalVersion   = 1;
+static const size_t   kFlushSize        = 64 * 1024;                // これを超えたら同期を待たずに書き出す.
+static const uint64_t kCompactSize      = 8 * 1024 * 1024;          // これを超えたらスナップショットを取り直す.
+static const auto     kSyncInterval     = std::chrono::seconds(1);  // ディスクへの同期間隔.
+
+//-----------------------------------------------------------------------------
+//      ノードハンドルを検索用のキーに変換します.
+//-----------------------------------------------------------------------------
+uint64_t ToKey(NodeHandle handle)
+{ return (uint64_t(handle.Generation) << 32) | handle.Index; }
+
+//-----------------------------------------------------------------------------
+//      スロット番号を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetSlotIndex(const Slot* slot)
+{
+    auto& slots = slot->pOwner->pSlots;
+    return uint32_t(std::find(slots.begin(), slots.end(), slot) - slots.begin());
+}
+
+//-----------------------------------------------------------------------------
+//      エントリーのハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint32_t ComputeEntryHash(const uint8_t* entry, size_t size)
+{
+    auto offset = sizeof(JournalEntryHeader::Hash);
+    return uint32_t(ComputeShaderPackHash(reinterpret_cast<const char*>(entry + offset), size - offset));
+}
+
+//-----------------------------------------------------------------------------
+//      ファイル全体を読み込みます.
+//-----------------------------------------------------------------------------
+bool ReadFile(const char* path, std::vector<uint8_t>& result)
+{
+    FILE* pFile = nullptr;
+    if (fopen_s(&pFile, path, "rb") != 0)
+    { return false; }
+
+    fseek(pFile, 0, SEEK_END);
+    auto size = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    result.resize((size > 0) ? size_t(size) : 0);
+    auto ok = size >= 0 && (result.empty() || fread(result.data(), result.size(), 1, pFile) == 1);
+    fclose(pFile);
+
+    return ok;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルのハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+bool ComputeFileHash(const char* path, uint64_t& hash)
+{
+    std::vector<uint8_t> data;
+    if (!ReadFile(path, data))
+    { return false; }
+
+    hash = ComputeShaderPackHash(reinterpret_cast<const char*>(data.data()), data.size());
+    return true;
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// EditJournal class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+EditJournal::EditJournal(EditData& data)
+: m_Data(data)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+EditJournal::~EditJournal()
+{ Close(); }
+
+//-----------------------------------------------------------------------------
+//      スナップショットとジャーナルのファイルパスを設定します.
+//-----------------------------------------------------------------------------
+void EditJournal::SetPath(const char* snapshotPath, const char* journalPath)
+{
+    Close();
+    m_SnapshotPath = snapshotPath;
+    m_JournalPath  = journalPath;
+}
+
+//-----------------------------------------------------------------------------
+//      スナップショットを読み込み，ジャーナルを再生して編集状態を復元します.
+//
+//      途中で途切れたり壊れたりしているエントリー以降は破棄します.
+//      スナップショットが読み込めなかった場合は false を返します.
+//-----------------------------------------------------------------------------
+bool EditJournal::Recover()
+{
+    Close();
+
+    uint64_t hash = 0;
+    if (!ComputeFileHash(m_SnapshotPath.c_str(), hash) || !m_Data.LoadBinary(m_SnapshotPath.c_str()))
+    { return false; }
+
+    ResetIds();
+
+    // 別のスナップショットに対するジャーナルは再生しない.
+    std::vector<uint8_t> journal;
+    JournalHeader header = {};
+    if (!ReadFile(m_JournalPath.c_str(), journal) || journal.size() < sizeof(header))
+    { return true; }
+
+    memcpy(&header, journal.data(), sizeof(header));
+    if (header.Magic != kJournalMagic || header.Version != kJournalVersion || header.SnapshotHash != hash)
+    { return true; }
+
+    auto offset = sizeof(header);
+    while(journal.size() - offset >= sizeof(JournalEntryHeader))
+    {
+        JournalEntryHeader entry;
+        memcpy(&entry, journal.data() + offset, sizeof(entry));
+        if (entry.Size > journal.size() - offset - sizeof(entry))
+        { break; }
+
+        auto size = sizeof(entry) + entry.Size;
+        if (ComputeEntryHash(journal.data() + offset, size) != entry.Hash)
+        { break; }
+
+        if (!Replay(entry.Type, journal.data() + offset + sizeof(entry), entry.Size))
+        { break; }
+
+        offset += size;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      現在の編集データのスナップショットの保存を開始します.
+//
+//      スナップショットの取得だけを呼び出しスレッドで行い，書き出しと
+//      ハッシュ値の計算は GraphSaver のワーカースレッドで行います.
+//      書き出しが完了するまでは古いスナップショットとジャーナルを残し，
+//      以降のエントリーはメモリに溜めて Update() で新しいジャーナルに
+//      書き出します. スナップショットを置き換えてからジャーナルを作り直す
+//      までの間に中断された場合でも，ハッシュ値が一致しないため古い
+//      ジャーナルは再生されません.
+//-----------------------------------------------------------------------------
+bool EditJournal::Checkpoint()
+{
+    if (m_SnapshotPath.empty() || m_JournalPath.empty())
+    { return false; }
+
+    // 書き出し中のスナップショットは以降の編集を含まないので，完了させてから取り直す.
+    FinishCheckpoint();
+
+    // 取得時点までのエントリーは古いジャーナルに確定しておく.
+    Flush(true);
+    m_Buffer.clear();
+    m_LastEntry = SIZE_MAX;
+    m_Retry     = false;
+
+    if (!m_Saver.Start(m_Data, m_SnapshotPath.c_str(), true))
+    { return false; }
+
+    // 以降のエントリーは新しいスナップショット上の番号で記録する.
+    ResetIds();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      溜まったエントリーを書き出し，一定間隔でディスクに同期します.
+//
+//      毎フレーム呼び出してください.
+//-----------------------------------------------------------------------------
+void EditJournal::Update()
+{
+    auto succeeded = false;
+    if (m_Saver.Poll(succeeded))
+    { Commit(succeeded); }
+
+    if (m_Saver.IsBusy())
+    { return; }
+
+    auto now = std::chrono::steady_clock::now();
+    if (m_Retry)
+    {
+        if (now - m_LastSync >= kSyncInterval)
+        { Checkpoint(); }
+        return;
+    }
+
+    if (m_pFile == nullptr)
+    { return; }
+
+    if (m_Buffer.size() >= kFlushSize)
+    { Flush(false); }
+
+    if ((!m_Buffer.empty() || m_Unsynced) && now - m_LastSync >= kSyncInterval)
+    { Flush(true); }
+
+    if (m_FileSize >= kCompactSize)
+    { Checkpoint(); }
+}
+
+//-----------------------------------------------------------------------------
+//      未書き出しのエントリーを同期してからジャーナルを閉じます.
+//
+//      書き出し中のスナップショットは完了を待ちます.
+//-----------------------------------------------------------------------------
+void EditJournal::Close()
+{
+    FinishCheckpoint();
+
+    // 取り直し待ちのエントリーは古いジャーナルと番号が合わないので書き出さない.
+    if (m_pFile == nullptr || m_Retry)
+    {
+        m_Buffer.clear();
+        m_LastEntry = SIZE_MAX;
+        m_Retry     = false;
+    }
+
+    if (m_pFile == nullptr)
+    { return; }
+
+    Flush(true);
+    fclose(m_pFile);
+    m_pFile = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      履歴のコマンドが編集データに与えた変更を記録します.
+//
+//      元に戻す・やり直しもその結果として記録されるため，再生時に履歴は
+//      必要ありません.
+//-----------------------------------------------------------------------------
+void EditJournal::Record(const EditCommand& command, bool revert)
+{
+    switch(command.Type)
+    {
+    case CommandAddNode:
+        {
+            if (revert)
+            { RemoveNode(command.pNode); }
+            else
+            { AddNode(command.pNode); }
+        }
+        break;
+
+    case CommandRemoveNode:
+        {
+            if (revert)
+            { AddNode(command.pNode); }
+            else
+            { RemoveNode(command.pNode); }
+        }
+        break;
+
+    case CommandAddLink:
+        {
+            if (!revert)
+            { AddLink(command.pOutput, command.pInput); }
+            else if (command.pOldOutput != nullptr)
+            { AddLink(command.pOldOutput, command.pInput); }
+            else
+            { RemoveLink(command.pInput); }
+        }
+        break;
+
+    case CommandRemoveLink:
+        {
+            if (revert)
+            { AddLink(command.pOutput, command.pInput); }
+            else
+            { RemoveLink(command.pInput); }
+        }
+        break;
+
+    case CommandSetValues:
+        SetValues(command.pNode);
+        break;
+
+    case CommandMoveNode:
+        MoveNode(command.pNode);
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの追加を記録します.
+//
+//      記録済みのノードは番号のみを，初出のノードは内容を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::AddNode(const Node* node)
+{
+    if (!IsRecording())
+    { return; }
+
+    auto id = FindId(node);
+    if (id == kGraphNoIndex)
+    {
+        std::vector<Node*> nodes(1, const_cast<Node*>(node));
+        AddNodes(nodes);
+        return;
+    }
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalRestoreNode, sizeof(id));
+    memcpy(data, &id, sizeof(id));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      初出のノードの追加をまとめて記録します.
+//
+//      ノード間の接続も記録します. 範囲外との接続は無いものとします.
+//-----------------------------------------------------------------------------
+void EditJournal::AddNodes(const std::vector<Node*>& nodes)
+{
+    if (!IsRecording() || nodes.empty())
+    { return; }
+
+    GraphStringTable strings;
+    std::vector<GraphNodeRecord> nodeRecords(nodes.size());
+    std::vector<GraphSlotRecord> slotRecords;
+    std::unordered_map<const Slot*, uint32_t> slotIds;
+
+    for(size_t i=0; i<nodes.size(); ++i)
+    {
+        for(size_t j=0; j<nodes[i]->pSlots.size(); ++j)
+        { slotIds[nodes[i]->pSlots[j]] = uint32_t(slotIds.size()); }
+    }
+
+    for(size_t i=0; i<nodes.size(); ++i)
+    {
+        auto node = nodes[i];
+        StoreNodeRecord(node, m_Data.GetSubGraphs(), strings, nodeRecords[i]);
+        nodeRecords[i].SlotBegin = uint32_t(slotRecords.size());
+
+        for(size_t j=0; j<node->pSlots.size(); ++j)
+        {
+            auto slot = node->pSlots[j];
+
+            GraphSlotRecord record;
+            StoreSlotRecord(slot, uint32_t(i), strings, record);
+
+            if (slot->Kind == SlotType::Input && slot->pPrev != nullptr)
+            {
+                auto prev = slotIds.find(slot->pPrev);
+                if (prev != slotIds.end())
+                { record.Prev = int32_t(int64_t(prev->second) - int64_t(slotRecords.size())); }
+            }
+
+            slotRecords.push_back(record);
+        }
+
+        AssignId(node);
+    }
+
+    JournalNodes header = {};
+    header.NodeCount  = uint32_t(nodeRecords.size());
+    header.SlotCount  = uint32_t(slotRecords.size());
+    header.StringSize = uint32_t(strings.GetData().size());
+
+    auto nodeSize = sizeof(GraphNodeRecord) * nodeRecords.size();
+    auto slotSize = sizeof(GraphSlotRecord) * slotRecords.size();
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalAddNodes, sizeof(header) + nodeSize + slotSize + header.StringSize);
+    memcpy(data, &header, sizeof(header));
+    data += sizeof(header);
+    memcpy(data, nodeRecords.data(), nodeSize);
+    data += nodeSize;
+    memcpy(data, slotRecords.data(), slotSize);
+    data += slotSize;
+    memcpy(data, strings.GetData().data(), header.StringSize);
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの削除を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::RemoveNode(const Node* node)
+{
+    auto id = FindId(node);
+    if (!IsRecording() || id == kGraphNoIndex)
+    { return; }
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalRemoveNode, sizeof(id));
+    memcpy(data, &id, sizeof(id));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      接続の追加を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::AddLink(const Slot* output, const Slot* input)
+{ WriteLink(JournalAddLink, output, input); }
+
+//-----------------------------------------------------------------------------
+//      接続の解除を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::RemoveLink(const Slot* input)
+{ WriteLink(JournalRemoveLink, nullptr, input); }
+
+//-----------------------------------------------------------------------------
+//      定数値の変更を記録します.
+//
+//      同じノードへの連続した変更は1つのエントリーに結合します.
+//-----------------------------------------------------------------------------
+void EditJournal::SetValues(const Node* node)
+{
+    JournalValues values = {};
+    values.Node = FindId(node);
+    if (!IsRecording() || values.Node == kGraphNoIndex)
+    { return; }
+
+    memcpy(values.Values, node->Values, sizeof(values.Values));
+
+    if (m_LastEntry != SIZE_MAX)
+    {
+        JournalEntryHeader last;
+        JournalValues      lastValues = {};
+        memcpy(&last, &m_Buffer[m_LastEntry], sizeof(last));
+        if (last.Type == JournalSetValues)
+        { memcpy(&lastValues, &m_Buffer[m_LastEntry + sizeof(last)], sizeof(lastValues)); }
+
+        if (last.Type == JournalSetValues && lastValues.Node == values.Node)
+        {
+            memcpy(&m_Buffer[m_LastEntry + sizeof(last)], &values, sizeof(values));
+            EndEntry(m_LastEntry);
+            return;
+        }
+    }
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalSetValues, sizeof(values));
+    memcpy(data, &values, sizeof(values));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      ノードの移動を記録します.
+//
+//      同じノードの連続した移動は1つのエントリーに結合します.
+//-----------------------------------------------------------------------------
+void EditJournal::MoveNode(const Node* node)
+{
+    JournalMove move = {};
+    move.Node = FindId(node);
+    if (!IsRecording() || move.Node == kGraphNoIndex)
+    { return; }
+
+    move.Pos[0] = node->Pos.x;
+    move.Pos[1] = node->Pos.y;
+
+    if (m_LastEntry != SIZE_MAX)
+    {
+        JournalEntryHeader last;
+        JournalMove        lastMove = {};
+        memcpy(&last, &m_Buffer[m_LastEntry], sizeof(last));
+        if (last.Type == JournalMoveNode)
+        { memcpy(&lastMove, &m_Buffer[m_LastEntry + sizeof(last)], sizeof(lastMove)); }
+
+        if (last.Type == JournalMoveNode && lastMove.Node == move.Node)
+        {
+            memcpy(&m_Buffer[m_LastEntry + sizeof(last)], &move, sizeof(move));
+            EndEntry(m_LastEntry);
+            return;
+        }
+    }
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalMoveNode, sizeof(move));
+    memcpy(data, &move, sizeof(move));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      品質設定の変更を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::SetQuality(const Node* node)
+{
+    JournalQuality quality = {};
+    quality.Node = FindId(node);
+    if (!IsRecording() || quality.Node == kGraphNoIndex)
+    { return; }
+
+    quality.MinQuality    = uint32_t(node->MinQuality);
+    quality.FallbackInput = int32_t(node->FallbackInput);
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalSetQuality, sizeof(quality));
+    memcpy(data, &quality, sizeof(quality));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      Gバッファのレイアウトの変更を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::SetLayout(const GBufferLayout& layout)
+{
+    if (!IsRecording())
+    { return; }
+
+    JournalLayout value = {};
+    value.Flags =
+        (layout.OctahedralNormal ? GraphOctahedralNormal : 0) |
+        (layout.YCoCgBaseColor   ? GraphYCoCgBaseColor   : 0) |
+        (layout.PackedRMO        ? GraphPackedRMO        : 0);
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalSetLayout, sizeof(value));
+    memcpy(data, &value, sizeof(value));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフ名の変更を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::RenameSubGraph(const SubGraph* subGraph)
+{
+    auto& subGraphs = m_Data.GetSubGraphs();
+    auto  itr       = std::find(subGraphs.begin(), subGraphs.end(), subGraph);
+    if (!IsRecording() || itr == subGraphs.end())
+    { return; }
+
+    JournalRename rename = {};
+    rename.SubGraph = uint32_t(itr - subGraphs.begin());
+    rename.NameSize = uint32_t(subGraph->Name.size());
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(JournalRenameSubGraph, sizeof(rename) + rename.NameSize);
+    memcpy(data, &rename, sizeof(rename));
+    memcpy(data + sizeof(rename), subGraph->Name.c_str(), rename.NameSize);
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      編集を記録するかどうかチェックします.
+//
+//      スナップショットの書き出し中はジャーナルが確定していなくても記録します.
+//-----------------------------------------------------------------------------
+bool EditJournal::IsRecording() const
+{ return m_pFile != nullptr || m_Saver.IsBusy(); }
+
+//-----------------------------------------------------------------------------
+//      書き出し中のスナップショットがあれば完了を待って反映します.
+//-----------------------------------------------------------------------------
+void EditJournal::FinishCheckpoint()
+{
+    if (!m_Saver.IsBusy())
+    { return; }
+
+    auto succeeded = false;
+    m_Saver.Wait();
+    m_Saver.Poll(succeeded);
+    Commit(succeeded);
+}
+
+//-----------------------------------------------------------------------------
+//      スナップショットの書き出し結果を反映します.
+//
+//      成功した場合は古いジャーナルを閉じて新しいジャーナルを作り，
+//      書き出し中に溜めたエントリーを書き出します. 失敗した場合は古い
+//      スナップショットとジャーナルをそのまま残し，一定時間後に取り直します.
+//-----------------------------------------------------------------------------
+void EditJournal::Commit(bool succeeded)
+{
+    if (!succeeded)
+    {
+        // 溜めたエントリーは新しい番号で記録しているため古いジャーナルには書けない.
+        // 取り直すスナップショットに含まれるので破棄する.
+        m_Buffer.clear();
+        m_LastEntry = SIZE_MAX;
+        m_Retry     = true;
+        m_LastSync  = std::chrono::steady_clock::now();
+        return;
+    }
+
+    if (m_pFile != nullptr)
+    {
+        fclose(m_pFile);
+        m_pFile = nullptr;
+    }
+
+    if (fopen_s(&m_pFile, m_JournalPath.c_str(), "wb") != 0)
+    {
+        m_pFile = nullptr;
+        m_Buffer.clear();
+        m_LastEntry = SIZE_MAX;
+        return;
+    }
+
+    JournalHeader header = {};
+    header.Magic        = kJournalMagic;
+    header.Version      = kJournalVersion;
+    header.SnapshotHash = m_Saver.GetFileHash();
+    fwrite(&header, sizeof(header), 1, m_pFile);
+    m_FileSize = sizeof(header);
+    m_Unsynced = true;
+    Flush(true);
+}
+
+//-----------------------------------------------------------------------------
+//      スナップショット上の並び順でノード番号を振り直します.
+//-----------------------------------------------------------------------------
+void EditJournal::ResetIds()
+{
+    std::vector<const Node*> nodes;
+    m_Data.GetFileOrder(nodes);
+
+    m_Ids.clear();
+    m_Handles.clear();
+    for(size_t i=0; i<nodes.size(); ++i)
+    { AssignId(nodes[i]); }
+}
+
+//-----------------------------------------------------------------------------
+//      ノード番号を検索します. 未登録の場合は kGraphNoIndex を返します.
+//-----------------------------------------------------------------------------
+uint32_t EditJournal::FindId(const Node* node) const
+{
+    // 破棄されたノードと同じアドレスに生成されたノードはハンドルの世代で区別する.
+    auto itr = m_Ids.find(ToKey(m_Data.GetHandle(node)));
+    if (itr == m_Ids.end())
+    { return kGraphNoIndex; }
+
+    return itr->second;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードに新しい番号を割り当てます.
+//-----------------------------------------------------------------------------
+uint32_t EditJournal::AssignId(const Node* node)
+{
+    auto handle = m_Data.GetHandle(node);
+    auto id     = uint32_t(m_Handles.size());
+
+    m_Ids[ToKey(handle)] = id;
+    m_Handles.push_back(handle);
+
+    return id;
+}
+
+//-----------------------------------------------------------------------------
+//      ノード番号からノードを取得します.
+//-----------------------------------------------------------------------------
+Node* EditJournal::FindNode(uint32_t id) const
+{
+    if (id >= m_Handles.size())
+    { return nullptr; }
+
+    return m_Data.GetNode(m_Handles[id]);
+}
+
+//-----------------------------------------------------------------------------
+//      エントリーを開始し，データの書き込み先を返します.
+//-----------------------------------------------------------------------------
+uint8_t* EditJournal::BeginEntry(JournalEntryType type, size_t size)
+{
+    JournalEntryHeader header = {};
+    header.Type = uint16_t(type);
+    header.Size = uint32_t(size);
+
+    auto offset = m_Buffer.size();
+    m_Buffer.resize(offset + sizeof(header) + size);
+    memcpy(&m_Buffer[offset], &header, sizeof(header));
+
+    return &m_Buffer[offset + sizeof(header)];
+}
+
+//-----------------------------------------------------------------------------
+//      エントリーのハッシュ値を設定して確定します.
+//-----------------------------------------------------------------------------
+void EditJournal::EndEntry(size_t offset)
+{
+    auto hash = ComputeEntryHash(&m_Buffer[offset], m_Buffer.size() - offset);
+    memcpy(&m_Buffer[offset], &hash, sizeof(hash));
+    m_LastEntry = offset;
+}
+
+//-----------------------------------------------------------------------------
+//      接続の変更を記録します.
+//-----------------------------------------------------------------------------
+void EditJournal::WriteLink(JournalEntryType type, const Slot* output, const Slot* input)
+{
+    if (!IsRecording())
+    { return; }
+
+    JournalLink link = {};
+    link.OutputNode = (output != nullptr) ? FindId(output->pOwner) : kGraphNoIndex;
+    link.OutputSlot = (output != nullptr) ? GetSlotIndex(output)   : kGraphNoIndex;
+    link.InputNode  = FindId(input->pOwner);
+    link.InputSlot  = GetSlotIndex(input);
+
+    // ジャーナルに現れないノード(サブグラフの内部など)は対象外.
+    if (link.InputNode == kGraphNoIndex || (output != nullptr && link.OutputNode == kGraphNoIndex))
+    { return; }
+
+    auto offset = m_Buffer.size();
+    auto data   = BeginEntry(type, sizeof(link));
+    memcpy(data, &link, sizeof(link));
+    EndEntry(offset);
+}
+
+//-----------------------------------------------------------------------------
+//      エントリーを再生します.
+//
+//      内容が編集データと整合しない場合は false を返します.
+//-----------------------------------------------------------------------------
+bool EditJournal::Replay(uint16_t type, const uint8_t* data, uint32_t size)
+{
+    switch(type)
+    {
+    case JournalAddNodes:
+        {
+            JournalNodes header;
+            if (size < sizeof(header))
+            { return false; }
+
+            memcpy(&header, data, sizeof(header));
+
+            auto nodeSize = uint64_t(sizeof(GraphNodeRecord)) * header.NodeCount;
+            auto slotSize = uint64_t(sizeof(GraphSlotRecord)) * header.SlotCount;
+            if (sizeof(header) + nodeSize + slotSize + header.StringSize != size || header.StringSize == 0)
+            { return false; }
+
+            std::vector<GraphNodeRecord> nodeRecords(header.NodeCount);
+            std::vector<GraphSlotRecord> slotRecords(header.SlotCount);
+            memcpy(nodeRecords.data(), data + sizeof(header), size_t(nodeSize));
+            memcpy(slotRecords.data(), data + sizeof(header) + nodeSize, size_t(slotSize));
+
+            auto strings = reinterpret_cast<const char*>(data + sizeof(header) + nodeSize + slotSize);
+            if (strings[header.StringSize - 1] != '\0')
+            { return false; }
+
+            std::vector<Node*> nodes;
+            std::vector<Slot*> slots;
+            for(size_t i=0; i<nodeRecords.size(); ++i)
+            {
+                auto& record = nodeRecords[i];
+                if (record.SlotBegin != slots.size()
+                 || record.SlotCount > slotRecords.size() - record.SlotBegin
+                 || record.Tag >= header.StringSize
+                 || record.Template >= header.StringSize
+                 || record.TexturePath >= header.StringSize)
+                { return false; }
+
+                for(uint32_t j=0; j<record.SlotCount; ++j)
+                {
+                    if (slotRecords[record.SlotBegin + j].Tag >= header.StringSize)
+                    { return false; }
+                }
+
+                auto node = RestoreNode(m_Data, record, &slotRecords[record.SlotBegin], strings);
+                if (node == nullptr)
+                { return false; }
+
+                slots.insert(slots.end(), node->pSlots.begin(), node->pSlots.end());
+                nodes.push_back(node);
+                AssignId(node);
+            }
+
+            for(size_t i=0; i<slotRecords.size(); ++i)
+            {
+                auto prev = int64_t(i) + slotRecords[i].Prev;
+                if (slotRecords[i].Prev == 0)
+                { continue; }
+
+                if (prev < 0 || prev >= int64_t(slots.size())
+                 || slots[prev]->Kind != SlotType::Output
+                 || slots[i]->Kind != SlotType::Input
+                 || slots[prev]->Type != slots[i]->Type
+                 || !m_Data.AddLink(slots[prev], slots[i]))
+                { return false; }
+            }
+
+            m_Data.AddNodes(nodes);
+        }
+        break;
+
+    case JournalRestoreNode:
+    case JournalRemoveNode:
+        {
+            uint32_t id;
+            if (size != sizeof(id))
+            { return false; }
+
+            memcpy(&id, data, sizeof(id));
+            auto node = FindNode(id);
+            if (node == nullptr || node->Type == NodeType::StageOutput)
+            { return false; }
+
+            if (type == JournalRestoreNode)
+            { m_Data.AddNode(node); }
+            else
+            { m_Data.RemoveNode(node); }
+        }
+        break;
+
+    case JournalAddLink:
+    case JournalRemoveLink:
+        {
+            JournalLink link;
+            if (size != sizeof(link))
+            { return false; }
+
+            memcpy(&link, data, sizeof(link));
+            auto input = FindNode(link.InputNode);
+            if (input == nullptr || link.InputSlot >= input->pSlots.size())
+            { return false; }
+
+            if (type == JournalRemoveLink)
+            {
+                m_Data.RemoveLink(input->pSlots[link.InputSlot]);
+                break;
+            }
+
+            auto output = FindNode(link.OutputNode);
+            if (output == nullptr || link.OutputSlot >= output->pSlots.size())
+            { return false; }
+
+            auto outputSlot = output->pSlots[link.OutputSlot];
+            auto inputSlot  = input->pSlots[link.InputSlot];
+            if (outputSlot->Kind != SlotType::Output || inputSlot->Kind != SlotType::Input || outputSlot->Type != inputSlot->Type)
+            { return false; }
+
+            if (!m_Data.AddLink(outputSlot, inputSlot))
+            { return false; }
+        }
+        break;
+
+    case JournalSetValues:
+        {
+            JournalValues values;
+            if (size != sizeof(values))
+            { return false; }
+
+            memcpy(&values, data, sizeof(values));
+            auto node = FindNode(values.Node);
+            if (node == nullptr)
+            { return false; }
+
+            memcpy(node->Values, values.Values, sizeof(node->Values));
+            m_Data.InvalidateHash(node);
+        }
+        break;
+
+    case JournalMoveNode:
+        {
+            JournalMove move;
+            if (size != sizeof(move))
+            { return false; }
+
+            memcpy(&move, data, sizeof(move));
+            auto node = FindNode(move.Node);
+            if (node == nullptr)
+            { return false; }
+
+            node->Pos.x = move.Pos[0];
+            node->Pos.y = move.Pos[1];
+        }
+        break;
+
+    case JournalSetQuality:
+        {
+            JournalQuality quality;
+            if (size != sizeof(quality))
+            { return false; }
+
+            memcpy(&quality, data, sizeof(quality));
+            auto node = FindNode(quality.Node);
+            if (node == nullptr || quality.MinQuality > QualityLevel::High || quality.FallbackInput < -1)
+            { return false; }
+
+            node->MinQuality    = QualityLevel(quality.MinQuality);
+            node->FallbackInput = quality.FallbackInput;
+            m_Data.InvalidateHash(node);
+        }
+        break;
+
+    case JournalSetLayout:
+        {
+            JournalLayout value;
+            if (size != sizeof(value))
+            { return false; }
+
+            memcpy(&value, data, sizeof(value));
+
+            GBufferLayout layout;
+            layout.OctahedralNormal = (value.Flags & GraphOctahedralNormal) != 0;
+            layout.YCoCgBaseColor   = (value.Flags & GraphYCoCgBaseColor)   != 0;
+            layout.PackedRMO        = (value.Flags & GraphPackedRMO)        != 0;
+            m_Data.SetGBufferLayout(layout);
+        }
+        break;
+
+    case JournalRenameSubGraph:
+        {
+            JournalRename rename;
+            if (size < sizeof(rename))
+            { return false; }
+
+            memcpy(&rename, data, sizeof(rename));
+            auto& subGraphs = m_Data.GetSubGraphs();
+            if (rename.NameSize != size - sizeof(rename) || rename.SubGraph >= subGraphs.size())
+            { return false; }
+
+            std::string name(reinterpret_cast<const char*>(data + sizeof(rename)), rename.NameSize);
+            if (!m_Data.RenameSubGraph(subGraphs[rename.SubGraph], name.c_str()))
+            { return false; }
+        }
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      溜まったエントリーをファイルに書き出します.
+//
+//      sync が true の場合はディスクへの書き込み完了まで待ちます.
+//-----------------------------------------------------------------------------
+void EditJournal::Flush(bool sync)
+{
+    // スナップショットの確定前のエントリーは古いジャーナルに書き出さない.
+    if (m_pFile == nullptr || m_Saver.IsBusy() || m_Retry)
+    { return; }
+
+    if (!m_Buffer.empty())
+    {
+        fwrite(m_Buffer.data(), m_Buffer.size(), 1, m_pFile);
+        fflush(m_pFile);
+        m_FileSize += m_Buffer.size();
+        m_Unsynced  = true;
+        m_Buffer.clear();
+        m_LastEntry = SIZE_MAX;
+    }
+
+    if (sync && m_Unsynced)
+    {
+        _commit(_fileno(m_pFile));
+        m_Unsynced = false;
+        m_LastSync = std::chrono::steady_clock::now();
+    }
+}
@@ -0,0 +1,677 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <GraphBinary.h>
+#include <GraphStorage.h>
+#include <GraphCompression.h>
+#include <EditData.h>
+#include <BuiltinNode.h>
+#include <algorithm>
+#include <Windows.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+
+static const uint32_t kGraphBinaryMagic   = 0x42524753; // 'SGRB'
+static const uint32_t kGraphBinaryVersion = 1;
+
+//-----------------------------------------------------------------------------
+//      指定アライメントに切り上げます.
+//-----------------------------------------------------------------------------
+uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+//-----------------------------------------------------------------------------
+//      テーブルがファイル内に収まっているかチェックします.
+//-----------------------------------------------------------------------------
+bool IsInRange(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size)
+{ return (offset % 8) == 0 && offset <= size && count <= (size - offset) / stride; }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphStringTable class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+GraphStringTable::GraphStringTable()
+{ Clear(); }
+
+//-----------------------------------------------------------------------------
+//      文字列を追加し，テーブルでのオフセットを返します.
+//-----------------------------------------------------------------------------
+uint32_t GraphStringTable::Add(const char* value)
+{
+    // オフセット0は空文字列.
+    if (value == nullptr || value[0] == '\0')
+    { return 0; }
+
+    auto itr = m_Offsets.find(value);
+    if (itr != m_Offsets.end())
+    { return itr->second; }
+
+    auto offset = uint32_t(m_Data.size());
+    m_Data.append(value);
+    m_Data.push_back('\0');
+    m_Offsets[value] = offset;
+
+    return offset;
+}
+
+//-----------------------------------------------------------------------------
+//      テーブルのデータを取得します.
+//-----------------------------------------------------------------------------
+const std::string& GraphStringTable::GetData() const
+{ return m_Data; }
+
+//-----------------------------------------------------------------------------
+//      追加済みの文字列を破棄します.
+//-----------------------------------------------------------------------------
+void GraphStringTable::Clear()
+{
+    m_Offsets.clear();
+    m_Data.assign(1, '\0');
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphBinaryWriter class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      文字列テーブルを取得します.
+//-----------------------------------------------------------------------------
+GraphStringTable& GraphBinaryWriter::GetStrings()
+{ return m_Strings; }
+
+//-----------------------------------------------------------------------------
+//      ノードを追加します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryWriter::AddNode(const GraphNodeRecord& record)
+{
+    m_Nodes.push_back(record);
+    return uint32_t(m_Nodes.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      スロットを追加します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryWriter::AddSlot(const GraphSlotRecord& record)
+{
+    m_Slots.push_back(record);
+    return uint32_t(m_Slots.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフを追加します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryWriter::AddSubGraph(const GraphSubGraphRecord& record)
+{
+    m_SubGraphs.push_back(record);
+    return uint32_t(m_SubGraphs.size() - 1);
+}
+
+//-----------------------------------------------------------------------------
+//      フラグを設定します.
+//-----------------------------------------------------------------------------
+void GraphBinaryWriter::SetFlags(uint32_t flags)
+{ m_Flags = flags; }
+
+//-----------------------------------------------------------------------------
+//      ファイルイメージをメモリ上に構築します.
+//-----------------------------------------------------------------------------
+void GraphBinaryWriter::Serialize(std::vector<uint8_t>& image) const
+{
+    GraphBinaryHeader header = {};
+    header.Magic            = kGraphBinaryMagic;
+    header.Version          = kGraphBinaryVersion;
+    header.NodeCount        = uint32_t(m_Nodes.size());
+    header.SlotCount        = uint32_t(m_Slots.size());
+    header.SubGraphCount    = uint32_t(m_SubGraphs.size());
+    header.Flags            = m_Flags;
+    header.StringSize       = uint32_t(m_Strings.GetData().size());
+    header.NodeOffset       = AlignUp(sizeof(GraphBinaryHeader), 16);
+    header.SlotOffset       = AlignUp(header.NodeOffset     + sizeof(GraphNodeRecord)     * m_Nodes.size(), 16);
+    header.SubGraphOffset   = AlignUp(header.SlotOffset     + sizeof(GraphSlotRecord)     * m_Slots.size(), 16);
+    header.StringOffset     = AlignUp(header.SubGraphOffset + sizeof(GraphSubGraphRecord) * m_SubGraphs.size(), 16);
+
+    // パディングはゼロで埋める.
+    image.assign(size_t(header.StringOffset + header.StringSize), 0);
+
+    // 各テーブルをアライメントを揃えてそのまま配置する.
+    auto copy = [&](uint64_t offset, const void* data, size_t size)
+    {
+        if (size > 0)
+        { memcpy(image.data() + offset, data, size); }
+    };
+
+    copy(0,                     &header,            sizeof(header));
+    copy(header.NodeOffset,     m_Nodes.data(),     sizeof(GraphNodeRecord)     * m_Nodes.size());
+    copy(header.SlotOffset,     m_Slots.data(),     sizeof(GraphSlotRecord)     * m_Slots.size());
+    copy(header.SubGraphOffset, m_SubGraphs.data(), sizeof(GraphSubGraphRecord) * m_SubGraphs.size());
+    copy(header.StringOffset,   m_Strings.GetData().data(), m_Strings.GetData().size());
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//-----------------------------------------------------------------------------
+bool GraphBinaryWriter::Write(const char* path) const
+{
+    std::vector<uint8_t> image;
+    Serialize(image);
+    return WriteGraphImage(image, path);
+}
+
+//-----------------------------------------------------------------------------
+//      追加済みのデータを破棄します.
+//-----------------------------------------------------------------------------
+void GraphBinaryWriter::Clear()
+{
+    m_Nodes.clear();
+    m_Slots.clear();
+    m_SubGraphs.clear();
+    m_Strings.Clear();
+    m_Flags = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphBinaryView class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+GraphBinaryView::GraphBinaryView()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+GraphBinaryView::~GraphBinaryView()
+{ Close(); }
+
+//-----------------------------------------------------------------------------
+//      ファイルをメモリマップして開きます.
+//
+//      圧縮コンテナの場合はチャンクを並列に展開したバッファを参照し，
+//      マップはすぐに閉じます.
+//-----------------------------------------------------------------------------
+bool GraphBinaryView::Open(const char* path)
+{
+    Close();
+
+    auto hFile = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+        nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    { return false; }
+
+    m_hFile = hFile;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(hFile, &size) || uint64_t(size.QuadPart) < sizeof(CompressedGraphHeader))
+    {
+        Close();
+        return false;
+    }
+
+    m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_hMapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    m_pMapped = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pMapped == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    if (IsCompressedGraph(m_pMapped, size_t(size.QuadPart)))
+    {
+        std::vector<uint8_t> buffer;
+        auto result = DecompressGraph(m_pMapped, size_t(size.QuadPart), buffer);
+        Close();
+
+        if (!result || !Validate(buffer.data(), buffer.size()))
+        { return false; }
+
+        m_Buffer.swap(buffer);
+        return true;
+    }
+
+    if (!Validate(m_pMapped, uint64_t(size.QuadPart)))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      メモリ上のデータを参照します. データは Close() まで保持してください.
+//-----------------------------------------------------------------------------
+bool GraphBinaryView::Attach(const void* data, size_t size)
+{
+    Close();
+
+    if (data == nullptr || (uintptr_t(data) % 8) != 0)
+    { return false; }
+
+    if (!Validate(static_cast<const uint8_t*>(data), size))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを閉じます.
+//-----------------------------------------------------------------------------
+void GraphBinaryView::Close()
+{
+    if (m_pMapped != nullptr)
+    {
+        UnmapViewOfFile(m_pMapped);
+        m_pMapped = nullptr;
+    }
+
+    if (m_hMapping != nullptr)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+    }
+
+    if (m_hFile != nullptr)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = nullptr;
+    }
+
+    m_pHeader       = nullptr;
+    m_pNodes        = nullptr;
+    m_pSlots        = nullptr;
+    m_pSubGraphs    = nullptr;
+    m_pStrings      = nullptr;
+
+    std::vector<uint8_t>().swap(m_Buffer);
+}
+
+//-----------------------------------------------------------------------------
+//      ヘッダとテーブルの整合性をチェックします.
+//
+//      値の解釈は行わず，番号とオフセットの範囲だけを1回走査して確認します.
+//      以降のアクセサは範囲チェックを省略できます.
+//-----------------------------------------------------------------------------
+bool GraphBinaryView::Validate(const uint8_t* data, uint64_t size)
+{
+    if (size < sizeof(GraphBinaryHeader))
+    { return false; }
+
+    auto header = reinterpret_cast<const GraphBinaryHeader*>(data);
+    if (header->Magic != kGraphBinaryMagic
+     || header->Version != kGraphBinaryVersion
+     || header->NodeCount == 0
+     || header->StringSize == 0
+     || !IsInRange(header->NodeOffset,     header->NodeCount,     sizeof(GraphNodeRecord),     size)
+     || !IsInRange(header->SlotOffset,     header->SlotCount,     sizeof(GraphSlotRecord),     size)
+     || !IsInRange(header->SubGraphOffset, header->SubGraphCount, sizeof(GraphSubGraphRecord), size)
+     || !IsInRange(header->StringOffset,   header->StringSize,    1,                           size))
+    { return false; }
+
+    auto nodes     = reinterpret_cast<const GraphNodeRecord*>    (data + header->NodeOffset);
+    auto slots     = reinterpret_cast<const GraphSlotRecord*>    (data + header->SlotOffset);
+    auto subGraphs = reinterpret_cast<const GraphSubGraphRecord*>(data + header->SubGraphOffset);
+    auto strings   = reinterpret_cast<const char*>               (data + header->StringOffset);
+
+    // 文字列は全て終端文字付き.
+    if (strings[0] != '\0' || strings[header->StringSize - 1] != '\0')
+    { return false; }
+
+    // スロットはノード順に連続して並ぶ.
+    uint32_t slotEnd = 0;
+    for(uint32_t i=0; i<header->NodeCount; ++i)
+    {
+        auto& node = nodes[i];
+        if (node.Type > NodeType::SubGraphOutput
+         || node.MinQuality > QualityLevel::High
+         || node.TextureDimension > TextureDimension::TextureCubeArray
+         || node.Sampler > SamplerType::AnisotropicMirror
+         || node.SlotBegin != slotEnd
+         || node.SlotCount > header->SlotCount - node.SlotBegin
+         || node.Tag         >= header->StringSize
+         || node.Template    >= header->StringSize
+         || node.TexturePath >= header->StringSize
+         || (node.SubGraph != kGraphNoIndex && node.SubGraph >= header->SubGraphCount))
+        { return false; }
+
+        slotEnd += node.SlotCount;
+    }
+
+    // ステージ出力は末尾に1つだけ.
+    if (slotEnd != header->SlotCount || nodes[header->NodeCount - 1].Type != NodeType::StageOutput)
+    { return false; }
+
+    for(uint32_t i=0; i<header->SlotCount; ++i)
+    {
+        auto& slot = slots[i];
+        if (slot.Kind > SlotType::Output
+         || slot.Type > DataType::Float4
+         || slot.Owner >= header->NodeCount
+         || i <  nodes[slot.Owner].SlotBegin
+         || i >= nodes[slot.Owner].SlotBegin + nodes[slot.Owner].SlotCount
+         || slot.Tag >= header->StringSize)
+        { return false; }
+
+        if (slot.Prev == 0)
+        { continue; }
+
+        auto prev = int64_t(i) + slot.Prev;
+        if (slot.Kind != SlotType::Input
+         || prev < 0 || prev >= int64_t(header->SlotCount)
+         || slots[prev].Kind != SlotType::Output
+         || slots[prev].Type != slot.Type)
+        { return false; }
+    }
+
+    // サブグラフのノードは先頭から連続して並ぶ.
+    uint32_t nodeEnd = 0;
+    for(uint32_t i=0; i<header->SubGraphCount; ++i)
+    {
+        auto& subGraph = subGraphs[i];
+        if (subGraph.NodeBegin != nodeEnd
+         || subGraph.NodeCount < 2
+         || subGraph.NodeCount >= header->NodeCount - nodeEnd
+         || subGraph.Name >= header->StringSize)
+        { return false; }
+
+        nodeEnd += subGraph.NodeCount;
+    }
+
+    m_pHeader       = header;
+    m_pNodes        = nodes;
+    m_pSlots        = slots;
+    m_pSubGraphs    = subGraphs;
+    m_pStrings      = strings;
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      フラグを取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryView::GetFlags() const
+{ return (m_pHeader != nullptr) ? m_pHeader->Flags : 0; }
+
+//-----------------------------------------------------------------------------
+//      ノード数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryView::GetNodeCount() const
+{ return (m_pHeader != nullptr) ? m_pHeader->NodeCount : 0; }
+
+//-----------------------------------------------------------------------------
+//      スロット数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryView::GetSlotCount() const
+{ return (m_pHeader != nullptr) ? m_pHeader->SlotCount : 0; }
+
+//-----------------------------------------------------------------------------
+//      サブグラフ数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryView::GetSubGraphCount() const
+{ return (m_pHeader != nullptr) ? m_pHeader->SubGraphCount : 0; }
+
+//-----------------------------------------------------------------------------
+//      メイングラフのノードの先頭位置を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryView::GetMainNodeBegin() const
+{
+    auto count = GetSubGraphCount();
+    if (count == 0)
+    { return 0; }
+
+    auto& last = m_pSubGraphs[count - 1];
+    return last.NodeBegin + last.NodeCount;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを取得します.
+//-----------------------------------------------------------------------------
+const GraphNodeRecord* GraphBinaryView::GetNode(uint32_t index) const
+{
+    if (index >= GetNodeCount())
+    { return nullptr; }
+
+    return &m_pNodes[index];
+}
+
+//-----------------------------------------------------------------------------
+//      スロットを取得します.
+//-----------------------------------------------------------------------------
+const GraphSlotRecord* GraphBinaryView::GetSlot(uint32_t index) const
+{
+    if (index >= GetSlotCount())
+    { return nullptr; }
+
+    return &m_pSlots[index];
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフを取得します.
+//-----------------------------------------------------------------------------
+const GraphSubGraphRecord* GraphBinaryView::GetSubGraph(uint32_t index) const
+{
+    if (index >= GetSubGraphCount())
+    { return nullptr; }
+
+    return &m_pSubGraphs[index];
+}
+
+//-----------------------------------------------------------------------------
+//      接続元スロットの番号を取得します. 未接続の場合は kGraphNoIndex を返します.
+//-----------------------------------------------------------------------------
+uint32_t GraphBinaryView::GetSlotPrev(uint32_t index) const
+{
+    auto slot = GetSlot(index);
+    if (slot == nullptr || slot->Prev == 0)
+    { return kGraphNoIndex; }
+
+    return uint32_t(int64_t(index) + slot->Prev);
+}
+
+//-----------------------------------------------------------------------------
+//      文字列を取得します.
+//-----------------------------------------------------------------------------
+const char* GraphBinaryView::GetString(uint32_t offset) const
+{
+    if (m_pHeader == nullptr || offset >= m_pHeader->StringSize)
+    { return ""; }
+
+    return m_pStrings + offset;
+}
+
+//-----------------------------------------------------------------------------
+//      ノードをレコードに格納します.
+//-----------------------------------------------------------------------------
+void StoreNodeRecord(const Node* node, const std::vector<SubGraph*>& subGraphs, GraphStringTable& strings, GraphNodeRecord& record)
+{
+    record = GraphNodeRecord();
+    record.Type             = uint8_t(node->Type);
+    record.MinQuality       = uint8_t(node->MinQuality);
+    record.TextureDimension = uint8_t(node->TextureDimension);
+    record.Sampler          = uint8_t(node->Sampler);
+    record.FallbackInput    = node->FallbackInput;
+    record.SlotCount        = uint32_t(node->pSlots.size());
+    record.Tag              = strings.Add(node->GetTag());
+    record.Template         = strings.Add(node->GetSourceCodeTemplate());
+    record.TexturePath      = strings.Add(node->TexturePath.c_str());
+    record.Descriptor       = GetNodeDescriptorIndex(node->pDescriptor);
+    record.SubGraph         = kGraphNoIndex;
+    record.AsColor          = node->AsColor ? 1 : 0;
+    record.Pos[0]           = node->Pos.x;
+    record.Pos[1]           = node->Pos.y;
+    memcpy(record.Values, node->Values, sizeof(record.Values));
+
+    if (node->Type == NodeType::SubGraphNode)
+    {
+        auto itr = std::find(subGraphs.begin(), subGraphs.end(), node->pSubGraph);
+        record.SubGraph = uint32_t(itr - subGraphs.begin());
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      スロットをレコードに格納します.
+//-----------------------------------------------------------------------------
+void StoreSlotRecord(const Slot* slot, uint32_t owner, GraphStringTable& strings, GraphSlotRecord& record)
+{
+    record = GraphSlotRecord();
+    record.Kind  = uint8_t(slot->Kind);
+    record.Type  = uint8_t(slot->Type);
+    record.Owner = owner;
+    record.Tag   = strings.Add(slot->GetTag());
+}
+
+//-----------------------------------------------------------------------------
+//      レコードからノードとスロットを生成します.
+//-----------------------------------------------------------------------------
+Node* RestoreNode(EditData& data, const GraphNodeRecord& record, const GraphSlotRecord* pSlots, const char* strings)
+{
+    auto& subGraphs = data.GetSubGraphs();
+    auto  type      = NodeType(record.Type);
+    if (type == NodeType::StageOutput)
+    { return nullptr; }
+
+    if (type == NodeType::SubGraphNode && record.SubGraph >= subGraphs.size())
+    { return nullptr; }
+
+    auto node = data.CreateNode();
+    node->Type               = type;
+    node->Tag                = InternString(strings + record.Tag);
+    node->SourceCodeTemplate = InternString(strings + record.Template);
+    node->TexturePath        = strings + record.TexturePath;
+    node->TextureDimension   = TextureDimension(record.TextureDimension);
+    node->Sampler            = SamplerType(record.Sampler);
+    node->MinQuality         = QualityLevel(record.MinQuality);
+    node->FallbackInput      = record.FallbackInput;
+    node->AsColor            = record.AsColor != 0;
+    node->Pos.x              = record.Pos[0];
+    node->Pos.y              = record.Pos[1];
+    memcpy(node->Values, record.Values, sizeof(node->Values));
+
+    // 記述子はタグが一致する場合のみ復元する.
+    auto descriptor = GetNodeDescriptor(record.Descriptor);
+    if (descriptor != nullptr && strcmp(descriptor->Tag, node->GetTag()) == 0)
+    { node->pDescriptor = descriptor; }
+
+    if (type == NodeType::SubGraphNode)
+    { node->pSubGraph = subGraphs[record.SubGraph]; }
+
+    for(uint32_t i=0; i<record.SlotCount; ++i)
+    {
+        auto& slot   = pSlots[i];
+        auto  symbol = InternString(strings + slot.Tag);
+        if (slot.Kind == SlotType::Input)
+        { node->AddInput(symbol, DataType(slot.Type)); }
+        else
+        { node->AddOutput(symbol, DataType(slot.Type)); }
+    }
+
+    return node;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルイメージを書き出します.
+//-----------------------------------------------------------------------------
+bool WriteGraphImage(const std::vector<uint8_t>& image, const char* path)
+{
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "wb");
+    if (err != 0)
+    { return false; }
+
+    if (!image.empty())
+    { fwrite(image.data(), image.size(), 1, pFile); }
+
+    auto result = (ferror(pFile) == 0);
+    fclose(pFile);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリグラフからグラフストレージを構築します.
+//-----------------------------------------------------------------------------
+void BuildGraphStorage(const GraphBinaryView& view, GraphStorage& storage)
+{
+    storage.Clear();
+    storage.Reserve(view.GetNodeCount(), view.GetSlotCount());
+
+    for(uint32_t i=0; i<view.GetNodeCount(); ++i)
+    {
+        auto node  = view.GetNode(i);
+        auto index = storage.AddNode(NodeType(node->Type), QualityLevel(node->MinQuality), node->FallbackInput);
+
+        // 変数番号はファイル内で一意なスロット番号から決める.
+        for(uint32_t j=0; j<node->SlotCount; ++j)
+        {
+            auto slot = view.GetSlot(node->SlotBegin + j);
+            storage.AddSlot(index, SlotType(slot->Kind), DataType(slot->Type), uint64_t(node->SlotBegin + j) + 1);
+        }
+
+        auto& detail = storage.GetDetail(index);
+        detail.Tag                  = InternString(view.GetString(node->Tag));
+        detail.SourceCodeTemplate   = InternString(view.GetString(node->Template));
+        detail.TexturePath          = view.GetString(node->TexturePath);
+        detail.TextureDimension     = TextureDimension(node->TextureDimension);
+        detail.Sampler              = SamplerType(node->Sampler);
+        detail.Pos[0]               = node->Pos[0];
+        detail.Pos[1]               = node->Pos[1];
+        memcpy(detail.Values, node->Values, sizeof(detail.Values));
+    }
+
+    // ストレージのスロット番号はファイル上の番号と一致する.
+    for(uint32_t i=0; i<view.GetSlotCount(); ++i)
+    {
+        auto prev = view.GetSlotPrev(i);
+        if (prev != kGraphNoIndex)
+        { storage.Connect(prev, i); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      XML形式のグラフをバイナリ形式に変換します.
+//-----------------------------------------------------------------------------
+bool ConvertGraphToBinary(const char* xmlPath, const char* binaryPath)
+{
+    EditData data;
+    if (!data.Load(xmlPath))
+    { return false; }
+
+    return data.SaveBinary(binaryPath);
+}
+
+//-----------------------------------------------------------------------------
+//      バイナリ形式のグラフをXML形式に変換します.
+//-----------------------------------------------------------------------------
+bool ConvertGraphToXml(const char* binaryPath, const char* xmlPath)
+{
+    EditData data;
+    if (!data.LoadBinary(binaryPath))
+    { return false; }
+
+    return data.Save(xmlPath);
+}
@@ -0,0 +1,414 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <GraphCompression.h>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+
+namespace {
+
+static const uint32_t kCompressedMagic      = 0x5A434753;   // 'SGCZ'
+static const uint32_t kCompressedVersion    = 1;
+static const uint32_t kChunkSize            = 256 * 1024;   // 展開後のチャンクサイズ.
+static const uint32_t kMinMatch             = 4;            // 一致とみなす最小の長さ.
+static const uint32_t kMaxOffset            = 0xffff;       // 一致を探す範囲.
+static const uint32_t kHashBits             = 14;
+static const uint32_t kNoPosition           = 0xffffffff;
+
+// 全ての ParallelFor() で起動中の補助スレッド数.
+std::atomic<uint32_t>   g_HelperCount(0);
+
+//-----------------------------------------------------------------------------
+//      補助スレッドを予約します.
+//
+//      同時に呼び出された ParallelFor() 全体で，補助スレッドの合計が
+//      コア数 - 1 を超えないようにします. 予約できた数を返します.
+//-----------------------------------------------------------------------------
+uint32_t ReserveHelpers(uint32_t count)
+{
+    auto coreCount = std::thread::hardware_concurrency();
+    auto limit     = (coreCount > 1) ? coreCount - 1 : 0;
+
+    auto current = g_HelperCount.load(std::memory_order_relaxed);
+    for(;;)
+    {
+        auto available = (current < limit) ? limit - current : 0;
+        auto reserved  = (count < available) ? count : available;
+        if (reserved == 0)
+        { return 0; }
+
+        if (g_HelperCount.compare_exchange_weak(current, current + reserved, std::memory_order_relaxed))
+        { return reserved; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      複数のスレッドで処理を分担します.
+//
+//      呼び出しスレッドも処理に加わります. プロジェクト読み込みのワーカー
+//      スレッドなどから同時に呼び出されてもスレッド数がコア数の2乗に
+//      ならないよう，補助スレッドは全体で共有する数だけ起動し，空きが
+//      無ければ呼び出しスレッドだけで処理します.
+//-----------------------------------------------------------------------------
+void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+{
+    std::atomic<uint32_t> next(0);
+    auto run = [&]()
+    {
+        for(;;)
+        {
+            auto index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= count)
+            { break; }
+
+            func(index);
+        }
+    };
+
+    auto helperCount = (count > 1) ? ReserveHelpers(count - 1) : 0;
+
+    std::vector<std::thread> workers;
+    for(uint32_t i=0; i<helperCount; ++i)
+    { workers.emplace_back(run); }
+
+    run();
+
+    for(size_t i=0; i<workers.size(); ++i)
+    { workers[i].join(); }
+
+    g_HelperCount.fetch_sub(helperCount, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+//      15以上の長さを追加のバイト列として書き出します.
+//-----------------------------------------------------------------------------
+void WriteLength(std::vector<uint8_t>& result, size_t length)
+{
+    while(length >= 255)
+    {
+        result.push_back(255);
+        length -= 255;
+    }
+    result.push_back(uint8_t(length));
+}
+
+//-----------------------------------------------------------------------------
+//      追加のバイト列から長さを読み込みます.
+//-----------------------------------------------------------------------------
+bool ReadLength(const uint8_t* data, size_t size, size_t& pos, size_t& length)
+{
+    for(;;)
+    {
+        if (pos >= size)
+        { return false; }
+
+        auto value = data[pos++];
+        length += value;
+        if (value != 255)
+        { return true; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      リテラルと一致の組を書き出します.
+//
+//      先頭の1バイトの上位4bitがリテラル長，下位4bitが一致長です.
+//      match が 0 の場合はリテラルのみで，チャンクの終端を表します.
+//-----------------------------------------------------------------------------
+void WriteSequence
+(
+    std::vector<uint8_t>&   result,
+    const uint8_t*          literals,
+    size_t                  literalCount,
+    size_t                  offset,
+    size_t                  match
+)
+{
+    auto literalToken = (literalCount < 15) ? literalCount : 15;
+    auto matchToken   = size_t(0);
+    if (match != 0)
+    { matchToken = (match - kMinMatch < 15) ? (match - kMinMatch) : 15; }
+
+    result.push_back(uint8_t((literalToken << 4) | matchToken));
+    if (literalToken == 15)
+    { WriteLength(result, literalCount - 15); }
+
+    result.insert(result.end(), literals, literals + literalCount);
+
+    if (match == 0)
+    { return; }
+
+    result.push_back(uint8_t(offset));
+    result.push_back(uint8_t(offset >> 8));
+    if (matchToken == 15)
+    { WriteLength(result, match - kMinMatch - 15); }
+}
+
+//-----------------------------------------------------------------------------
+//      チャンクを圧縮します.
+//
+//      4バイトのハッシュで直前の出現位置を探すだけの貪欲法です. 同じタグや
+//      テンプレートが近くに繰り返し現れるグラフファイルでは十分に縮みます.
+//-----------------------------------------------------------------------------
+void CompressChunk(const uint8_t* data, size_t size, std::vector<uint8_t>& result)
+{
+    std::vector<uint32_t> table(size_t(1) << kHashBits, kNoPosition);
+
+    size_t anchor = 0;
+    size_t pos    = 0;
+    while(pos + kMinMatch <= size)
+    {
+        uint32_t value;
+        memcpy(&value, data + pos, sizeof(value));
+
+        auto hash      = (value * 2654435761u) >> (32 - kHashBits);
+        auto candidate = table[hash];
+        table[hash] = uint32_t(pos);
+
+        if (candidate == kNoPosition || pos - candidate > kMaxOffset || memcmp(data + candidate, data + pos, kMinMatch) != 0)
+        {
+            pos++;
+            continue;
+        }
+
+        auto match = size_t(kMinMatch);
+        while(pos + match < size && data[candidate + match] == data[pos + match])
+        { match++; }
+
+        WriteSequence(result, data + anchor, pos - anchor, pos - candidate, match);
+        pos   += match;
+        anchor = pos;
+    }
+
+    WriteSequence(result, data + anchor, size - anchor, 0, 0);
+}
+
+//-----------------------------------------------------------------------------
+//      チャンクを展開します.
+//
+//      壊れたデータで範囲外に書き込まないよう，全ての長さと位置を確認します.
+//-----------------------------------------------------------------------------
+bool DecompressChunk(const uint8_t* data, size_t size, uint8_t* result, size_t rawSize)
+{
+    size_t src = 0;
+    size_t dst = 0;
+    for(;;)
+    {
+        if (src >= size)
+        { return false; }
+
+        auto token = data[src++];
+
+        size_t literal = token >> 4;
+        if (literal == 15 && !ReadLength(data, size, src, literal))
+        { return false; }
+
+        if (literal > size - src || literal > rawSize - dst)
+        { return false; }
+
+        memcpy(result + dst, data + src, literal);
+        src += literal;
+        dst += literal;
+
+        if (src == size)
+        { return dst == rawSize; }
+
+        if (size - src < 2)
+        { return false; }
+
+        size_t offset = data[src] | (size_t(data[src + 1]) << 8);
+        src += 2;
+
+        size_t match = token & 0xf;
+        if (match == 15 && !ReadLength(data, size, src, match))
+        { return false; }
+
+        match += kMinMatch;
+        if (offset == 0 || offset > dst || match > rawSize - dst)
+        { return false; }
+
+        // 一致範囲が重なる場合は1バイトずつ複写して繰り返しを展開する.
+        auto from = result + dst - offset;
+        auto to   = result + dst;
+        if (offset >= match)
+        { memcpy(to, from, match); }
+        else
+        {
+            for(size_t i=0; i<match; ++i)
+            { to[i] = from[i]; }
+        }
+        dst += match;
+    }
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      圧縮コンテナかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool IsCompressedGraph(const void* data, size_t size)
+{
+    if (data == nullptr || size < sizeof(CompressedGraphHeader))
+    { return false; }
+
+    uint32_t magic;
+    memcpy(&magic, data, sizeof(magic));
+    return magic == kCompressedMagic;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルイメージをチャンク毎に並列で圧縮します.
+//
+//      チャンクは独立して展開できるので，読み込み時も並列に展開できます.
+//      縮まなかったチャンクはそのまま格納します.
+//-----------------------------------------------------------------------------
+void CompressGraph(const uint8_t* data, size_t size, std::vector<uint8_t>& result)
+{
+    auto count = uint32_t((size + kChunkSize - 1) / kChunkSize);
+
+    std::vector<std::vector<uint8_t>> chunks(count);
+    ParallelFor(count, [&](uint32_t index)
+    {
+        auto begin   = size_t(index) * kChunkSize;
+        auto rawSize = (size - begin < kChunkSize) ? (size - begin) : kChunkSize;
+        auto& chunk  = chunks[index];
+
+        chunk.reserve(rawSize / 2);
+        CompressChunk(data + begin, rawSize, chunk);
+        if (chunk.size() >= rawSize)
+        { chunk.assign(data + begin, data + begin + rawSize); }
+    });
+
+    CompressedGraphHeader header = {};
+    header.Magic        = kCompressedMagic;
+    header.Version      = kCompressedVersion;
+    header.ChunkSize    = kChunkSize;
+    header.ChunkCount   = count;
+    header.RawSize      = size;
+
+    std::vector<CompressedGraphChunk> table(count);
+
+    auto offset = uint64_t(sizeof(header) + sizeof(CompressedGraphChunk) * count);
+    for(uint32_t i=0; i<count; ++i)
+    {
+        auto begin = size_t(i) * kChunkSize;
+        table[i].Offset  = offset;
+        table[i].Size    = uint32_t(chunks[i].size());
+        table[i].RawSize = uint32_t((size - begin < kChunkSize) ? (size - begin) : kChunkSize);
+        offset += chunks[i].size();
+    }
+
+    result.resize(size_t(offset));
+
+    auto dst = result.data();
+    memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+
+    if (count > 0)
+    {
+        memcpy(dst, table.data(), sizeof(CompressedGraphChunk) * count);
+        dst += sizeof(CompressedGraphChunk) * count;
+    }
+
+    for(uint32_t i=0; i<count; ++i)
+    {
+        if (!chunks[i].empty())
+        { memcpy(dst, chunks[i].data(), chunks[i].size()); }
+        dst += chunks[i].size();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      圧縮コンテナをチャンク毎に並列で展開します.
+//
+//      各チャンクは展開後の位置が決まっているので，結果のバッファに直接
+//      展開します.
+//-----------------------------------------------------------------------------
+bool DecompressGraph(const uint8_t* data, size_t size, std::vector<uint8_t>& result)
+{
+    if (!IsCompressedGraph(data, size))
+    { return false; }
+
+    CompressedGraphHeader header;
+    memcpy(&header, data, sizeof(header));
+
+    auto tableEnd = sizeof(header) + sizeof(CompressedGraphChunk) * uint64_t(header.ChunkCount);
+    if (header.Version != kCompressedVersion
+    ||  header.ChunkSize == 0
+    ||  tableEnd > size
+    ||  uint64_t(header.ChunkCount) * header.ChunkSize < header.RawSize
+    ||  header.RawSize > SIZE_MAX)
+    { return false; }
+
+    // チャンクの範囲を確認してから展開を始める.
+    std::vector<CompressedGraphChunk> table(header.ChunkCount);
+    if (header.ChunkCount > 0)
+    { memcpy(table.data(), data + sizeof(header), sizeof(CompressedGraphChunk) * header.ChunkCount); }
+
+    for(uint32_t i=0; i<header.ChunkCount; ++i)
+    {
+        auto& chunk = table[i];
+        auto  begin = uint64_t(i) * header.ChunkSize;
+        auto  last  = (i + 1 == header.ChunkCount);
+        if (chunk.Offset < tableEnd
+        ||  chunk.Offset > size
+        ||  chunk.Size > size - chunk.Offset
+        ||  chunk.RawSize != (last ? header.RawSize - begin : header.ChunkSize))
+        { return false; }
+    }
+
+    result.resize(size_t(header.RawSize));
+
+    std::atomic<bool> succeeded(true);
+    ParallelFor(header.ChunkCount, [&](uint32_t index)
+    {
+        auto& chunk = table[index];
+        auto  dst   = result.data() + size_t(index) * header.ChunkSize;
+        auto  src   = data + chunk.Offset;
+
+        if (chunk.Size == chunk.RawSize)
+        { memcpy(dst, src, chunk.Size); }
+        else if (!DecompressChunk(src, chunk.Size, dst, chunk.RawSize))
+        { succeeded.store(false, std::memory_order_relaxed); }
+    });
+
+    if (!succeeded.load())
+    {
+        result.clear();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルが圧縮コンテナであれば読み込んで展開します.
+//
+//      圧縮コンテナでない場合や展開に失敗した場合は，読み込み位置を先頭に
+//      戻して false を返します.
+//-----------------------------------------------------------------------------
+bool ReadCompressedGraph(FILE* pFile, std::vector<uint8_t>& result)
+{
+    CompressedGraphHeader header;
+    auto found = fread(&header, sizeof(header), 1, pFile) == 1
+              && IsCompressedGraph(&header, sizeof(header));
+
+    if (found)
+    {
+        fseek(pFile, 0, SEEK_END);
+        auto size = ftell(pFile);
+        fseek(pFile, 0, SEEK_SET);
+
+        std::vector<uint8_t> data((size > 0) ? size_t(size) : 0);
+        found = size > 0
+             && fread(data.data(), data.size(), 1, pFile) == 1
+             && DecompressGraph(data.data(), data.size(), result);
+    }
+
+    fseek(pFile, 0, SEEK_SET);
+    return found;
+}
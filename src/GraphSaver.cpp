@@ -0,0 +1,207 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <GraphSaver.h>
+#include <GraphBinary.h>
+#include <GraphCompression.h>
+#include <EditData.h>
+#include <ShaderPack.h>
+#include <Windows.h>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      経過時間をミリ秒単位で取得します.
+//-----------------------------------------------------------------------------
+double GetElapsedMsec(const std::chrono::steady_clock::time_point& begin)
+{ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count(); }
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphSaver class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+GraphSaver::GraphSaver()
+: m_Written (0)
+, m_Done    (false)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+GraphSaver::~GraphSaver()
+{ Wait(); }
+
+//-----------------------------------------------------------------------------
+//      保存を開始します.
+//
+//      スナップショットの取得だけを呼び出しスレッドで行い，書式化と
+//      ファイルへの書き出しはワーカースレッドで行います. 保存中の場合は
+//      false を返します. compress を指定すると圧縮コンテナで書き出します.
+//-----------------------------------------------------------------------------
+bool GraphSaver::Start(const EditData& data, const char* path, bool binary, bool compress)
+{
+    if (m_Pending)
+    { return false; }
+
+    m_Begin = std::chrono::steady_clock::now();
+
+    GraphBinaryWriter writer;
+    data.CaptureSnapshot(writer);
+    writer.Serialize(m_Image);
+
+    m_NodeCount   = reinterpret_cast<const GraphBinaryHeader*>(m_Image.data())->NodeCount;
+    m_Pending     = true;
+    m_Path        = path;
+    m_Binary      = binary;
+    m_Compress    = compress;
+    m_Result      = false;
+    m_FileHash    = 0;
+    m_CaptureMsec = ::GetElapsedMsec(m_Begin);
+    m_ElapsedMsec = 0.0;
+    m_Written.store(0);
+    m_Done.store(false);
+
+    m_Thread = std::thread(&GraphSaver::Run, this);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      保存の完了を確認します.
+//
+//      完了した保存について一度だけ true を返し，結果を succeeded に設定します.
+//-----------------------------------------------------------------------------
+bool GraphSaver::Poll(bool& succeeded)
+{
+    if (!m_Pending || !m_Done.load(std::memory_order_acquire))
+    { return false; }
+
+    Wait();
+    m_Pending = false;
+    succeeded = m_Result;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      保存の完了を待機します.
+//
+//      結果は次の Poll() で取得できます.
+//-----------------------------------------------------------------------------
+void GraphSaver::Wait()
+{
+    if (m_Thread.joinable())
+    { m_Thread.join(); }
+}
+
+//-----------------------------------------------------------------------------
+//      結果を取得していない保存があるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool GraphSaver::IsBusy() const
+{ return m_Pending; }
+
+//-----------------------------------------------------------------------------
+//      進捗率を取得します.
+//-----------------------------------------------------------------------------
+float GraphSaver::GetProgress() const
+{
+    if (m_NodeCount == 0)
+    { return 0.0f; }
+
+    return float(m_Written.load(std::memory_order_relaxed)) / float(m_NodeCount);
+}
+
+//-----------------------------------------------------------------------------
+//      保存するノード数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphSaver::GetNodeCount() const
+{ return m_NodeCount; }
+
+//-----------------------------------------------------------------------------
+//      保存先のパスを取得します.
+//-----------------------------------------------------------------------------
+const std::string& GraphSaver::GetPath() const
+{ return m_Path; }
+
+//-----------------------------------------------------------------------------
+//      スナップショットの取得に掛かった時間を取得します.
+//-----------------------------------------------------------------------------
+double GraphSaver::GetCaptureMsec() const
+{ return m_CaptureMsec; }
+
+//-----------------------------------------------------------------------------
+//      保存開始から完了までの時間を取得します.
+//-----------------------------------------------------------------------------
+double GraphSaver::GetElapsedMsec() const
+{ return m_Done.load(std::memory_order_acquire) ? m_ElapsedMsec : ::GetElapsedMsec(m_Begin); }
+
+//-----------------------------------------------------------------------------
+//      書き出したファイルのハッシュ値を取得します.
+//
+//      バイナリ形式で保存した場合のみ有効で，ファイル全体を ComputeShaderPackHash()
+//      で計算した値と一致します. 読み直さずにファイルを識別するのに使います.
+//-----------------------------------------------------------------------------
+uint64_t GraphSaver::GetFileHash() const
+{ return m_FileHash; }
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッドで保存を行います.
+//
+//      途中で失敗しても元のファイルが壊れないよう，一時ファイルに書き出してから
+//      置き換えます.
+//-----------------------------------------------------------------------------
+void GraphSaver::Run()
+{
+    auto temp   = m_Path + ".tmp";
+    auto result = false;
+
+    GraphBinaryView view;
+    if (view.Attach(m_Image.data(), m_Image.size()))
+    {
+        if (m_Compress)
+        {
+            // バイナリ形式はスナップショットをそのまま圧縮する.
+            std::vector<uint8_t> text;
+            if (!m_Binary)
+            { FormatGraphXml(view, text, &m_Written); }
+
+            auto& data = m_Binary ? m_Image : text;
+
+            std::vector<uint8_t> compressed;
+            CompressGraph(data.data(), data.size(), compressed);
+            result = WriteGraphImage(compressed, temp.c_str());
+            m_Written.store(m_NodeCount, std::memory_order_relaxed);
+
+            if (m_Binary)
+            { m_FileHash = ComputeShaderPackHash(reinterpret_cast<const char*>(compressed.data()), compressed.size()); }
+        }
+        else if (m_Binary)
+        {
+            result = WriteGraphImage(m_Image, temp.c_str());
+            m_Written.store(m_NodeCount, std::memory_order_relaxed);
+            m_FileHash = ComputeShaderPackHash(reinterpret_cast<const char*>(m_Image.data()), m_Image.size());
+        }
+        else
+        { result = SaveGraphXml(view, temp.c_str(), &m_Written); }
+    }
+
+    if (result && !MoveFileExA(temp.c_str(), m_Path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    { result = false; }
+
+    if (!result)
+    { DeleteFileA(temp.c_str()); }
+
+    // スナップショットは不要になったので解放する.
+    view.Close();
+    m_Image.clear();
+    m_Image.shrink_to_fit();
+
+    m_Result      = result;
+    m_ElapsedMsec = ::GetElapsedMsec(m_Begin);
+    m_Done.store(true, std::memory_order_release);
+}
@@ -0,0 +1,315 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <GraphStorage.h>
+#include <cassert>
+
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+// Frame structure
+///////////////////////////////////////////////////////////////////////////////
+struct Frame
+{
+    NodeIndex   Node;       // 対象ノード.
+    SlotIndex   Cursor;     // 次に調べるスロット.
+    SlotIndex   End;        // 調べるスロットの終端.
+    bool        Emit;       // 辿り終えたら結果に追加するかどうか.
+};
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// GraphStorage class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      全データを破棄します.
+//-----------------------------------------------------------------------------
+void GraphStorage::Clear()
+{
+    m_NodeType     .clear();
+    m_SlotBegin    .clear();
+    m_SlotCount    .clear();
+    m_MinQuality   .clear();
+    m_FallbackInput.clear();
+    m_Detail       .clear();
+
+    m_SlotKind .clear();
+    m_SlotType .clear();
+    m_SlotOwner.clear();
+    m_SlotPrev .clear();
+    m_SlotVarId.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      メモリを予約します.
+//-----------------------------------------------------------------------------
+void GraphStorage::Reserve(uint32_t nodeCount, uint32_t slotCount)
+{
+    m_NodeType     .reserve(nodeCount);
+    m_SlotBegin    .reserve(nodeCount);
+    m_SlotCount    .reserve(nodeCount);
+    m_MinQuality   .reserve(nodeCount);
+    m_FallbackInput.reserve(nodeCount);
+    m_Detail       .reserve(nodeCount);
+
+    m_SlotKind .reserve(slotCount);
+    m_SlotType .reserve(slotCount);
+    m_SlotOwner.reserve(slotCount);
+    m_SlotPrev .reserve(slotCount);
+    m_SlotVarId.reserve(slotCount);
+}
+
+//-----------------------------------------------------------------------------
+//      ノードを追加します.
+//-----------------------------------------------------------------------------
+NodeIndex GraphStorage::AddNode(NodeType type, QualityLevel minQuality, int fallbackInput)
+{
+    auto index = NodeIndex(m_NodeType.size());
+
+    m_NodeType     .push_back(uint8_t(type));
+    m_SlotBegin    .push_back(uint32_t(m_SlotKind.size()));
+    m_SlotCount    .push_back(0);
+    m_MinQuality   .push_back(uint8_t(minQuality));
+    m_FallbackInput.push_back(int32_t(fallbackInput));
+    m_Detail       .push_back(NodeDetail());
+
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+//      スロットを追加します.
+//
+//      ノードのスロットを連続して配置するため，最後に追加したノードにのみ
+//      追加できます.
+//-----------------------------------------------------------------------------
+SlotIndex GraphStorage::AddSlot(NodeIndex node, SlotType kind, DataType type, uint64_t varId)
+{
+    assert(node + 1 == m_NodeType.size());
+
+    auto index = SlotIndex(m_SlotKind.size());
+
+    m_SlotKind .push_back(uint8_t(kind));
+    m_SlotType .push_back(uint8_t(type));
+    m_SlotOwner.push_back(node);
+    m_SlotPrev .push_back(kInvalidIndex);
+    m_SlotVarId.push_back(varId);
+
+    m_SlotCount[node]++;
+
+    return index;
+}
+
+//-----------------------------------------------------------------------------
+//      出力スロットを入力スロットに接続します.
+//-----------------------------------------------------------------------------
+bool GraphStorage::Connect(SlotIndex output, SlotIndex input)
+{
+    if (output >= m_SlotKind.size() || input >= m_SlotKind.size())
+    { return false; }
+
+    if (m_SlotKind[output] != SlotType::Output || m_SlotKind[input] != SlotType::Input)
+    { return false; }
+
+    m_SlotPrev[input] = output;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ノード数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphStorage::GetNodeCount() const
+{ return uint32_t(m_NodeType.size()); }
+
+//-----------------------------------------------------------------------------
+//      スロット数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphStorage::GetSlotCount() const
+{ return uint32_t(m_SlotKind.size()); }
+
+//-----------------------------------------------------------------------------
+//      ノードタイプを取得します.
+//-----------------------------------------------------------------------------
+NodeType GraphStorage::GetNodeType(NodeIndex node) const
+{ return NodeType(m_NodeType[node]); }
+
+//-----------------------------------------------------------------------------
+//      ノードの先頭スロットを取得します.
+//-----------------------------------------------------------------------------
+SlotIndex GraphStorage::GetSlotBegin(NodeIndex node) const
+{ return m_SlotBegin[node]; }
+
+//-----------------------------------------------------------------------------
+//      ノードのスロット数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GraphStorage::GetSlotCount(NodeIndex node) const
+{ return m_SlotCount[node]; }
+
+//-----------------------------------------------------------------------------
+//      ノードが有効となる最低品質を取得します.
+//-----------------------------------------------------------------------------
+QualityLevel GraphStorage::GetMinQuality(NodeIndex node) const
+{ return QualityLevel(m_MinQuality[node]); }
+
+//-----------------------------------------------------------------------------
+//      ノードの詳細データを取得します.
+//-----------------------------------------------------------------------------
+NodeDetail& GraphStorage::GetDetail(NodeIndex node)
+{ return m_Detail[node]; }
+
+//-----------------------------------------------------------------------------
+//      ノードの詳細データを取得します.
+//-----------------------------------------------------------------------------
+const NodeDetail& GraphStorage::GetDetail(NodeIndex node) const
+{ return m_Detail[node]; }
+
+//-----------------------------------------------------------------------------
+//      スロットの種別を取得します.
+//-----------------------------------------------------------------------------
+SlotType GraphStorage::GetSlotKind(SlotIndex slot) const
+{ return SlotType(m_SlotKind[slot]); }
+
+//-----------------------------------------------------------------------------
+//      スロットのデータ型を取得します.
+//-----------------------------------------------------------------------------
+DataType GraphStorage::GetSlotType(SlotIndex slot) const
+{ return DataType(m_SlotType[slot]); }
+
+//-----------------------------------------------------------------------------
+//      スロットを所有するノードを取得します.
+//-----------------------------------------------------------------------------
+NodeIndex GraphStorage::GetSlotOwner(SlotIndex slot) const
+{ return m_SlotOwner[slot]; }
+
+//-----------------------------------------------------------------------------
+//      入力スロットの接続元を取得します.
+//-----------------------------------------------------------------------------
+SlotIndex GraphStorage::GetSlotPrev(SlotIndex slot) const
+{ return m_SlotPrev[slot]; }
+
+//-----------------------------------------------------------------------------
+//      スロットの変数番号を取得します.
+//-----------------------------------------------------------------------------
+uint64_t GraphStorage::GetSlotVarId(SlotIndex slot) const
+{ return m_SlotVarId[slot]; }
+
+//-----------------------------------------------------------------------------
+//      指定品質でノードが有効かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool GraphStorage::IsActive(NodeIndex node, QualityLevel quality) const
+{ return quality >= m_MinQuality[node]; }
+
+//-----------------------------------------------------------------------------
+//      全ての入力スロットが接続されているかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool GraphStorage::IsValid(NodeIndex node) const
+{
+    auto begin = m_SlotBegin[node];
+    auto end   = begin + m_SlotCount[node];
+
+    for(auto i=begin; i<end; ++i)
+    {
+        if (m_SlotKind[i] == SlotType::Input && m_SlotPrev[i] == kInvalidIndex)
+        { return false; }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      品質不足時に代替する入力スロットを取得します.
+//-----------------------------------------------------------------------------
+SlotIndex GraphStorage::GetFallbackSlot(NodeIndex node) const
+{
+    auto fallback = m_FallbackInput[node];
+    if (fallback < 0)
+    { return kInvalidIndex; }
+
+    auto begin = m_SlotBegin[node];
+    auto end   = begin + m_SlotCount[node];
+    auto input = 0;
+
+    for(auto i=begin; i<end; ++i)
+    {
+        if (m_SlotKind[i] != SlotType::Input)
+        { continue; }
+
+        if (input == fallback)
+        { return i; }
+
+        input++;
+    }
+
+    return kInvalidIndex;
+}
+
+//-----------------------------------------------------------------------------
+//      コード生成に必要なノードを上流が先になる順で収集します.
+//
+//      根ノードは入力が未接続でも常に末尾に追加します. 品質不足のノードは
+//      出力せず代替入力の上流のみを辿り，未接続の入力を持つノードは無効と
+//      して刈り取ります.
+//-----------------------------------------------------------------------------
+void GraphStorage::CollectNodes
+(
+    NodeIndex               root,
+    QualityLevel            quality,
+    std::vector<NodeIndex>& result
+) const
+{
+    std::vector<uint8_t> visited(m_NodeType.size(), 0);
+    std::vector<Frame>   stack;
+
+    visited[root] = 1;
+    stack.push_back(Frame{ root, m_SlotBegin[root], m_SlotBegin[root] + m_SlotCount[root], true });
+
+    while(!stack.empty())
+    {
+        auto& frame = stack.back();
+
+        // 次に辿る上流ノードを探す.
+        auto next = kInvalidIndex;
+        while(frame.Cursor < frame.End && next == kInvalidIndex)
+        {
+            auto slot = frame.Cursor;
+            frame.Cursor++;
+
+            if (m_SlotKind[slot] == SlotType::Input && m_SlotPrev[slot] != kInvalidIndex)
+            { next = m_SlotOwner[m_SlotPrev[slot]]; }
+        }
+
+        // 上流を辿り終えた.
+        if (next == kInvalidIndex)
+        {
+            if (frame.Emit)
+            { result.push_back(frame.Node); }
+
+            stack.pop_back();
+            continue;
+        }
+
+        // 収集済み.
+        if (visited[next] != 0)
+        { continue; }
+
+        visited[next] = 1;
+
+        if (!IsActive(next, quality))
+        {
+            auto fallback = GetFallbackSlot(next);
+            if (fallback != kInvalidIndex && m_SlotPrev[fallback] != kInvalidIndex)
+            { stack.push_back(Frame{ next, fallback, fallback + 1, false }); }
+            continue;
+        }
+
+        if (!IsValid(next))
+        { continue; }
+
+        auto begin = m_SlotBegin[next];
+        auto end   = begin + m_SlotCount[next];
+        stack.push_back(Frame{ next, begin, end, true });
+    }
+}
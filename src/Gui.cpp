@@ -1075,7 +1075,9 @@ void GuiMgr::OnDraw( ImDrawData* pDrawData )
                         LONG( pCmd->ClipRect.w )
                     };
 
-                    m_pContext->PSSetShaderResources( 0, 1, m_pSRV.GetAddressOf() );
+                    // ImGui::Image() で指定したテクスチャも描画できるようにする.
+                    auto pSRV = reinterpret_cast<ID3D11ShaderResourceView*>( pCmd->TextureId );
+                    m_pContext->PSSetShaderResources( 0, 1, &pSRV );
                     m_pContext->RSSetScissorRects( 1, &rc );
                     m_pContext->DrawIndexed( pCmd->ElemCount, offsetIdx, offsetVtx );
                 }
@@ -0,0 +1,81 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <IdAllocator.h>
+
+
+namespace {
+
+static const uint32_t kCacheCount = 4;      // スレッド毎に保持するブロック数.
+
+///////////////////////////////////////////////////////////////////////////////
+// IdBlock structure
+///////////////////////////////////////////////////////////////////////////////
+struct IdBlock
+{
+    uint64_t    Serial;     // 確保元の通し番号(0は未使用).
+    uint64_t    Next;       // 次に払い出す番号.
+    uint64_t    End;        // ブロックの終端(この番号を含まない).
+};
+
+std::atomic<uint64_t>   g_NextSerial(1);
+
+// 複数の編集データを交互に扱っても番号を無駄にしないよう，確保元毎に
+// 数個のブロックを保持する.
+thread_local IdBlock    t_Blocks[kCacheCount] = {};
+thread_local uint32_t   t_Victim = 0;
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// IdAllocator class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//
+//      通し番号はインスタンス毎に一意なので，破棄されたインスタンスと同じ
+//      アドレスに生成されても，以前のブロックを誤って使うことはありません.
+//-----------------------------------------------------------------------------
+IdAllocator::IdAllocator()
+: m_Serial  (g_NextSerial.fetch_add(1, std::memory_order_relaxed))
+, m_Next    (1)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      番号を割り当てます.
+//
+//      ブロックを使い切ったときだけ共有カウンタを1回進めるので，ロックは
+//      不要で，スレッド間の競合もブロック単位に抑えられます.
+//-----------------------------------------------------------------------------
+uint64_t IdAllocator::Allocate()
+{
+    IdBlock* pBlock = nullptr;
+    for(uint32_t i=0; i<kCacheCount; ++i)
+    {
+        auto& block = t_Blocks[i];
+        if (block.Serial != m_Serial)
+        { continue; }
+
+        if (block.Next != block.End)
+        { return block.Next++; }
+
+        pBlock = &block;
+        break;
+    }
+
+    // このスレッドで初めて使う場合は保持しているブロックを順番に置き換える.
+    if (pBlock == nullptr)
+    {
+        pBlock   = &t_Blocks[t_Victim];
+        t_Victim = (t_Victim + 1) % kCacheCount;
+    }
+
+    auto begin = m_Next.fetch_add(kBlockSize, std::memory_order_relaxed);
+    pBlock->Serial = m_Serial;
+    pBlock->Next   = begin + 1;
+    pBlock->End    = begin + kBlockSize;
+
+    return begin;
+}
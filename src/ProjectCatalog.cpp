@@ -0,0 +1,424 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ProjectCatalog.h>
+#include <EditData.h>
+#include <Windows.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <set>
+#include <unordered_map>
+
+
+namespace {
+
+static const uint32_t kCatalogMagic     = 0x54414353;   // 'SCAT'
+static const uint32_t kCatalogVersion   = 2;
+
+//-----------------------------------------------------------------------------
+//      パスの順序を比較します. 大文字と小文字は区別しません.
+//-----------------------------------------------------------------------------
+bool LessPath(const CatalogItem& lhs, const std::string& rhs)
+{ return _stricmp(lhs.Path.c_str(), rhs.c_str()) < 0; }
+
+//-----------------------------------------------------------------------------
+//      文字列を含むかどうかチェックします. text は小文字で渡してください.
+//-----------------------------------------------------------------------------
+bool ContainsText(const std::string& value, const std::string& text)
+{
+    auto itr = std::search(value.begin(), value.end(), text.begin(), text.end(),
+        [](char lhs, char rhs) { return tolower(uint8_t(lhs)) == rhs; });
+    return itr != value.end();
+}
+
+//-----------------------------------------------------------------------------
+//      テクスチャパスを収集します.
+//-----------------------------------------------------------------------------
+void CollectTextures(const std::vector<Node*>& nodes, std::set<std::string>& result)
+{
+    for(size_t i=0; i<nodes.size(); ++i)
+    {
+        if (nodes[i]->Type == NodeType::Texture && !nodes[i]->TexturePath.empty())
+        { result.insert(nodes[i]->TexturePath); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ファイル全体を読み込みます.
+//-----------------------------------------------------------------------------
+bool ReadFile(const char* path, std::vector<uint8_t>& result)
+{
+    FILE* pFile = nullptr;
+    if (fopen_s(&pFile, path, "rb") != 0)
+    { return false; }
+
+    fseek(pFile, 0, SEEK_END);
+    auto size = ftell(pFile);
+    fseek(pFile, 0, SEEK_SET);
+
+    result.resize((size > 0) ? size_t(size) : 0);
+    auto ok = size >= 0 && (result.empty() || fread(result.data(), result.size(), 1, pFile) == 1);
+    fclose(pFile);
+
+    return ok;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      編集データからカタログの項目を作成します.
+//
+//      ノード数はファイル上のノード数(サブグラフの内部とステージ出力を含む)
+//      と一致させます.
+//-----------------------------------------------------------------------------
+void CaptureCatalogItem(EditData& data, CatalogItem& item)
+{
+    std::set<std::string> textures;
+
+    auto& nodes     = data.GetNodes();
+    auto& subGraphs = data.GetSubGraphs();
+
+    auto count = uint32_t(nodes.size()) + 1;
+    CollectTextures(nodes, textures);
+
+    for(size_t i=0; i<subGraphs.size(); ++i)
+    {
+        count += uint32_t(subGraphs[i]->pNodes.size()) + 2;
+        CollectTextures(subGraphs[i]->pNodes, textures);
+    }
+
+    item.GraphHash = data.GetGraphHash();
+    item.CodeHash  = data.GetCodeHash();
+    item.NodeCount = count;
+    item.Textures.assign(textures.begin(), textures.end());
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ProjectCatalog class
+///////////////////////////////////////////////////////////////////////////////
+
+const char* ProjectCatalog::kFileName = "catalog.scat";
+
+//-----------------------------------------------------------------------------
+//      フォルダのカタログを読み込みます.
+//
+//      グラフファイルは開かず，カタログファイルだけを読み込みます. 読み込みに
+//      失敗した場合は空のカタログとして false を返します. 項目は相対パスの
+//      昇順で重複の無いことを前提に検索・更新するので，そうでないファイルも
+//      壊れているものとして扱います.
+//
+//      カタログファイルが無い場合は新しいカタログとして使えますが，読み込めない
+//      ファイルがある場合は IsBroken() が true となり，Save() で上書きしません.
+//-----------------------------------------------------------------------------
+bool ProjectCatalog::Load(const char* folder)
+{
+    Reset(folder);
+
+    auto path = m_Folder + "\\" + kFileName;
+    if (GetFileAttributesA(path.c_str()) == INVALID_FILE_ATTRIBUTES)
+    { return false; }
+
+    // 以降で失敗した場合は，他の項目を失わないよう既存のファイルを残す.
+    m_Broken = true;
+
+    std::vector<uint8_t> data;
+    if (!ReadFile(path.c_str(), data) || data.size() < sizeof(CatalogHeader))
+    { return false; }
+
+    CatalogHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+
+    auto entryOffset   = sizeof(CatalogHeader);
+    auto textureOffset = entryOffset   + sizeof(CatalogEntry) * uint64_t(header.EntryCount);
+    auto stringOffset  = textureOffset + sizeof(uint32_t)     * uint64_t(header.TextureCount);
+    if (header.Magic != kCatalogMagic
+    ||  header.Version != kCatalogVersion
+    ||  stringOffset + header.StringSize != data.size()
+    ||  header.StringSize == 0
+    ||  data.back() != '\0')
+    { return false; }
+
+    auto entries  = reinterpret_cast<const CatalogEntry*>(data.data() + entryOffset);
+    auto textures = reinterpret_cast<const uint32_t*>    (data.data() + textureOffset);
+    auto strings  = reinterpret_cast<const char*>        (data.data() + stringOffset);
+
+    m_Items.resize(header.EntryCount);
+    for(uint32_t i=0; i<header.EntryCount; ++i)
+    {
+        auto& entry = entries[i];
+        if (entry.Path >= header.StringSize
+        ||  uint64_t(entry.TextureBegin) + entry.TextureCount > header.TextureCount)
+        {
+            m_Items.clear();
+            return false;
+        }
+
+        auto& item = m_Items[i];
+        item.Path = strings + entry.Path;
+
+        // 昇順でないと Update() が同じパスの項目を重複して追加してしまう.
+        if (i > 0 && !LessPath(m_Items[i - 1], item.Path))
+        {
+            m_Items.clear();
+            return false;
+        }
+
+        item.GraphHash = entry.GraphHash;
+        item.CodeHash  = entry.CodeHash;
+        item.NodeCount = entry.NodeCount;
+
+        item.Textures.resize(entry.TextureCount);
+        for(uint32_t j=0; j<entry.TextureCount; ++j)
+        {
+            auto offset = textures[entry.TextureBegin + j];
+            if (offset >= header.StringSize)
+            {
+                m_Items.clear();
+                return false;
+            }
+
+            item.Textures[j] = strings + offset;
+        }
+    }
+
+    m_Broken = false;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      カタログを書き出します.
+//
+//      書き出し中に中断しても前回のカタログが壊れないよう，一時ファイルに
+//      書き出してから置き換えます. 同じ文字列は1つにまとめて格納します.
+//-----------------------------------------------------------------------------
+bool ProjectCatalog::Save() const
+{
+    if (m_Folder.empty() || m_Broken)
+    { return false; }
+
+    std::vector<CatalogEntry>                   entries(m_Items.size());
+    std::vector<uint32_t>                       textures;
+    std::string                                 strings;
+    std::unordered_map<std::string, uint32_t>   offsets;
+
+    auto intern = [&](const std::string& value)
+    {
+        auto itr = offsets.find(value);
+        if (itr != offsets.end())
+        { return itr->second; }
+
+        auto offset = uint32_t(strings.size());
+        strings.append(value.c_str(), value.size() + 1);
+        offsets[value] = offset;
+        return offset;
+    };
+
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        auto& item  = m_Items[i];
+        auto& entry = entries[i];
+        entry.GraphHash     = item.GraphHash;
+        entry.CodeHash      = item.CodeHash;
+        entry.Path          = intern(item.Path);
+        entry.NodeCount     = item.NodeCount;
+        entry.TextureBegin  = uint32_t(textures.size());
+        entry.TextureCount  = uint32_t(item.Textures.size());
+
+        for(size_t j=0; j<item.Textures.size(); ++j)
+        { textures.push_back(intern(item.Textures[j])); }
+    }
+
+    // 空のカタログでも文字列データは終端文字1つ分を持たせる.
+    if (strings.empty())
+    { strings.push_back('\0'); }
+
+    CatalogHeader header = {};
+    header.Magic        = kCatalogMagic;
+    header.Version      = kCatalogVersion;
+    header.EntryCount   = uint32_t(entries.size());
+    header.TextureCount = uint32_t(textures.size());
+    header.StringSize   = uint32_t(strings.size());
+
+    auto path = m_Folder + "\\" + kFileName;
+    auto temp = path + ".tmp";
+
+    FILE* pFile = nullptr;
+    if (fopen_s(&pFile, temp.c_str(), "wb") != 0)
+    { return false; }
+
+    fwrite(&header, sizeof(header), 1, pFile);
+    if (!entries.empty())
+    { fwrite(entries.data(), sizeof(CatalogEntry), entries.size(), pFile); }
+    if (!textures.empty())
+    { fwrite(textures.data(), sizeof(uint32_t), textures.size(), pFile); }
+    fwrite(strings.data(), strings.size(), 1, pFile);
+
+    auto result = (ferror(pFile) == 0);
+    fclose(pFile);
+
+    if (result && !MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    { result = false; }
+
+    if (!result)
+    { DeleteFileA(temp.c_str()); }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      指定フォルダの空のカタログにします.
+//-----------------------------------------------------------------------------
+void ProjectCatalog::Reset(const char* folder)
+{
+    m_Folder = folder;
+    m_Broken = false;
+    m_Items.clear();
+
+    while(!m_Folder.empty() && (m_Folder.back() == '\\' || m_Folder.back() == '/'))
+    { m_Folder.pop_back(); }
+}
+
+//-----------------------------------------------------------------------------
+//      フォルダ以下のパスかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool ProjectCatalog::Contains(const std::string& path) const
+{
+    auto length = m_Folder.size();
+    return !m_Folder.empty()
+        && path.size() > length + 1
+        && _strnicmp(path.c_str(), m_Folder.c_str(), length) == 0
+        && (path[length] == '\\' || path[length] == '/');
+}
+
+//-----------------------------------------------------------------------------
+//      項目を登録します.
+//
+//      path はフルパスで指定し，同じパスの項目があれば置き換えます.
+//      フォルダ外のパスは登録しません. シェーダを生成していない項目は，
+//      グラフが変わっていなければ以前の生成時のハッシュ値を引き継ぎます.
+//-----------------------------------------------------------------------------
+void ProjectCatalog::Update(const std::string& path, const CatalogItem& item)
+{
+    if (!Contains(path))
+    { return; }
+
+    auto relative = path.substr(m_Folder.size() + 1);
+    auto codeHash = item.CodeHash;
+
+    auto itr = std::lower_bound(m_Items.begin(), m_Items.end(), relative, LessPath);
+    if (itr == m_Items.end() || _stricmp(itr->Path.c_str(), relative.c_str()) != 0)
+    { itr = m_Items.insert(itr, CatalogItem()); }
+    else if (codeHash == 0 && itr->GraphHash == item.GraphHash)
+    { codeHash = itr->CodeHash; }
+
+    *itr = item;
+    itr->Path     = relative;
+    itr->CodeHash = codeHash;
+}
+
+//-----------------------------------------------------------------------------
+//      以前のカタログからシェーダ生成時のハッシュ値を引き継ぎます.
+//
+//      カタログを作り直す場合に使います. Update() と同じく，シェーダを生成
+//      していない項目のうちグラフが変わっていないものだけが対象です.
+//-----------------------------------------------------------------------------
+void ProjectCatalog::Inherit(const ProjectCatalog& previous)
+{
+    auto& items = previous.m_Items;
+
+    // どちらも相対パスの昇順なので先頭から突き合わせる.
+    size_t j = 0;
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        auto& item = m_Items[i];
+        while(j < items.size() && LessPath(items[j], item.Path))
+        { j++; }
+
+        if (j == items.size())
+        { break; }
+
+        if (item.CodeHash == 0
+        &&  item.GraphHash == items[j].GraphHash
+        &&  _stricmp(item.Path.c_str(), items[j].Path.c_str()) == 0)
+        { item.CodeHash = items[j].CodeHash; }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      パスまたはテクスチャに文字列を含む項目を検索します.
+//
+//      大文字と小文字は区別しません. 空文字列の場合は全ての項目を返します.
+//-----------------------------------------------------------------------------
+void ProjectCatalog::Search(const char* text, std::vector<uint32_t>& result) const
+{
+    std::string lower(text);
+    for(size_t i=0; i<lower.size(); ++i)
+    { lower[i] = char(tolower(uint8_t(lower[i]))); }
+
+    result.clear();
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        auto& item = m_Items[i];
+        auto  hit  = ContainsText(item.Path, lower);
+        for(size_t j=0; j<item.Textures.size() && !hit; ++j)
+        { hit = ContainsText(item.Textures[j], lower); }
+
+        if (hit)
+        { result.push_back(uint32_t(i)); }
+    }
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを登録するカタログのフォルダを探します.
+//
+//      サブフォルダのファイルを保存したときに，上位のカタログとは別の
+//      カタログを作らないようにします.
+//-----------------------------------------------------------------------------
+std::string ProjectCatalog::FindFolder(const std::string& path)
+{
+    auto pos = path.find_last_of("\\/");
+    if (pos == std::string::npos)
+    { return std::string(); }
+
+    auto result = path.substr(0, pos);
+    auto folder = result;
+    for(;;)
+    {
+        pos = folder.find_last_of("\\/");
+        if (pos == std::string::npos || pos == 0)
+        { break; }
+
+        folder.resize(pos);
+        if (GetFileAttributesA((folder + "\\" + kFileName).c_str()) != INVALID_FILE_ATTRIBUTES)
+        { result = folder; }
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      読み込めないカタログファイルがあったかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool ProjectCatalog::IsBroken() const
+{ return m_Broken; }
+
+//-----------------------------------------------------------------------------
+//      カタログのフォルダを取得します.
+//-----------------------------------------------------------------------------
+const std::string& ProjectCatalog::GetFolder() const
+{ return m_Folder; }
+
+//-----------------------------------------------------------------------------
+//      項目を取得します.
+//-----------------------------------------------------------------------------
+const std::vector<CatalogItem>& ProjectCatalog::GetItems() const
+{ return m_Items; }
+
+//-----------------------------------------------------------------------------
+//      項目のフルパスを取得します.
+//-----------------------------------------------------------------------------
+std::string ProjectCatalog::GetFullPath(const CatalogItem& item) const
+{ return m_Folder + "\\" + item.Path; }
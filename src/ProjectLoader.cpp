@@ -0,0 +1,259 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ProjectLoader.h>
+#include <ShaderPack.h>
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+
+//-----------------------------------------------------------------------------
+//      指定した拡張子かどうかチェックします.
+//-----------------------------------------------------------------------------
+bool HasExtension(const std::string& path, const char* ext)
+{
+    auto length = strlen(ext);
+    return path.size() >= length && _stricmp(path.c_str() + path.size() - length, ext) == 0;
+}
+
+//-----------------------------------------------------------------------------
+//      フォルダ以下のグラフファイルを再帰的に収集します.
+//-----------------------------------------------------------------------------
+void CollectGraphFiles(const std::string& folder, std::vector<ProjectMaterial>& result)
+{
+    WIN32_FIND_DATAA data = {};
+    auto handle = FindFirstFileA((folder + "\\*").c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE)
+    { return; }
+
+    do
+    {
+        if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+        { continue; }
+
+        auto path = folder + "\\" + data.cFileName;
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        { CollectGraphFiles(path, result); }
+        else if (HasExtension(path, ".xml") || HasExtension(path, ".sgb"))
+        {
+            ProjectMaterial material;
+            material.Path     = path;
+            material.FileSize = (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+            result.push_back(std::move(material));
+        }
+    }
+    while (FindNextFileA(handle, &data));
+
+    FindClose(handle);
+}
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ProjectLoader class
+///////////////////////////////////////////////////////////////////////////////
+
+const char* ProjectLoader::kPackFileName = "shader.spak";
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ProjectLoader::ProjectLoader()
+: m_NextIndex   (0)
+, m_LoadedCount (0)
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ProjectLoader::~ProjectLoader()
+{ Wait(); }
+
+//-----------------------------------------------------------------------------
+//      フォルダ以下のグラフの読み込みを開始します.
+//
+//      グラフ毎に独立した編集データへ読み込むので，ワーカースレッド間で
+//      共有するのは読み込む順番のカウンタだけです. 読み込み中の場合は
+//      false を返します.
+//-----------------------------------------------------------------------------
+bool ProjectLoader::Start(const char* folder)
+{
+    if (IsBusy())
+    { return false; }
+
+    m_Begin         = std::chrono::steady_clock::now();
+    m_PendingFolder = folder;
+
+    m_Pending.clear();
+    CollectGraphFiles(m_PendingFolder, m_Pending);
+
+    std::sort(m_Pending.begin(), m_Pending.end(),
+        [](const ProjectMaterial& lhs, const ProjectMaterial& rhs) { return lhs.Path < rhs.Path; });
+
+    // 大きいファイルから読み込み，終盤にスレッドが遊ばないようにする.
+    m_Order.resize(m_Pending.size());
+    for(size_t i=0; i<m_Order.size(); ++i)
+    { m_Order[i] = uint32_t(i); }
+
+    std::stable_sort(m_Order.begin(), m_Order.end(),
+        [this](uint32_t lhs, uint32_t rhs) { return m_Pending[lhs].FileSize > m_Pending[rhs].FileSize; });
+
+    m_NextIndex  .store(0);
+    m_LoadedCount.store(0);
+    m_Loading = true;
+
+    // ファイルが無くても完了を Poll() で通知できるよう最低1つは起動する.
+    auto count = std::thread::hardware_concurrency();
+    if (count > m_Pending.size())
+    { count = uint32_t(m_Pending.size()); }
+    if (count == 0)
+    { count = 1; }
+
+    for(uint32_t i=0; i<count; ++i)
+    { m_Workers.emplace_back(&ProjectLoader::Run, this); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      読み込みの完了を確認します.
+//
+//      全てのグラフを読み込み終えたときに一度だけ true を返し，結果を
+//      まとめて公開します. 公開するまで前回のプロジェクトはそのまま参照できます.
+//-----------------------------------------------------------------------------
+bool ProjectLoader::Poll()
+{
+    if (!IsBusy() || m_LoadedCount.load(std::memory_order_acquire) < m_Pending.size())
+    { return false; }
+
+    Wait();
+    m_Loading = false;
+
+    m_Folder.swap(m_PendingFolder);
+    m_Materials.swap(m_Pending);
+    m_Pending.clear();
+    m_Order.clear();
+
+    m_FailedCount = 0;
+    for(size_t i=0; i<m_Materials.size(); ++i)
+    {
+        if (m_Materials[i].pData == nullptr)
+        { m_FailedCount++; }
+    }
+
+    m_LoadMsec = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Begin).count();
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      読み込みの完了を待機します.
+//
+//      結果は次の Poll() で公開されます.
+//-----------------------------------------------------------------------------
+void ProjectLoader::Wait()
+{
+    for(size_t i=0; i<m_Workers.size(); ++i)
+    { m_Workers[i].join(); }
+
+    m_Workers.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      公開していない読み込みがあるかどうかチェックします.
+//-----------------------------------------------------------------------------
+bool ProjectLoader::IsBusy() const
+{ return m_Loading; }
+
+//-----------------------------------------------------------------------------
+//      進捗率を取得します.
+//-----------------------------------------------------------------------------
+float ProjectLoader::GetProgress() const
+{
+    if (m_Pending.empty())
+    { return 0.0f; }
+
+    return float(m_LoadedCount.load(std::memory_order_relaxed)) / float(m_Pending.size());
+}
+
+//-----------------------------------------------------------------------------
+//      公開済みのプロジェクトのフォルダを取得します.
+//-----------------------------------------------------------------------------
+const std::string& ProjectLoader::GetFolder() const
+{ return m_Folder; }
+
+//-----------------------------------------------------------------------------
+//      公開済みのマテリアルを取得します.
+//-----------------------------------------------------------------------------
+std::vector<ProjectMaterial>& ProjectLoader::GetMaterials()
+{ return m_Materials; }
+
+//-----------------------------------------------------------------------------
+//      読み込みに失敗したマテリアル数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t ProjectLoader::GetFailedCount() const
+{ return m_FailedCount; }
+
+//-----------------------------------------------------------------------------
+//      読み込みに掛かった時間を取得します.
+//-----------------------------------------------------------------------------
+double ProjectLoader::GetLoadMsec() const
+{ return m_LoadMsec; }
+
+//-----------------------------------------------------------------------------
+//      全マテリアルのシェーダをプロジェクトフォルダのシェーダパックに出力します.
+//
+//      キーはプロジェクトフォルダからの相対パスを '/' 区切りにしたものに
+//      品質名を付けたものです(例: "rock/granite.xml/High").
+//      読み込みに失敗したマテリアルは含めません.
+//-----------------------------------------------------------------------------
+bool ProjectLoader::ExportPack()
+{
+    if (m_Folder.empty())
+    { return false; }
+
+    ShaderPackWriter writer;
+    for(size_t i=0; i<m_Materials.size(); ++i)
+    {
+        auto& material = m_Materials[i];
+        if (material.pData == nullptr)
+        { continue; }
+
+        // パスは "<フォルダ>\\<相対パス>" の形式.
+        auto name = material.Path.substr(m_Folder.size() + 1);
+        std::replace(name.begin(), name.end(), '\\', '/');
+
+        if (!material.pData->ExportPack(writer, name))
+        { return false; }
+    }
+
+    auto path = m_Folder + "\\" + kPackFileName;
+    return writer.Write(path.c_str());
+}
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッドで読み込みを行います.
+//-----------------------------------------------------------------------------
+void ProjectLoader::Run()
+{
+    for(;;)
+    {
+        auto index = m_NextIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index >= m_Order.size())
+        { break; }
+
+        auto& material = m_Pending[m_Order[index]];
+
+        std::unique_ptr<EditData> data(new EditData());
+        auto result = HasExtension(material.Path, ".sgb")
+            ? data->LoadBinary(material.Path.c_str())
+            : data->Load(material.Path.c_str());
+        if (result)
+        { material.pData = std::move(data); }
+
+        m_LoadedCount.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -8,6 +8,8 @@
 #include <imgui/imgui_internal.h>
 #include <asura_sdk/StringHelper.h>
 #include <BuiltinNode.h>
+#include <algorithm>
+#include <chrono>
 
 
 namespace {
@@ -20,6 +22,9 @@ const ImColor NodeTagColor[] = {
     ImColor(255, 125, 125), // OBJECT_TYPE_TEXTURE
     ImColor(125, 255, 125), // OBJECT_TYPE_CONSTANT
     ImColor(255, 125, 50),  // OBJECT_TYPE_STAGE_DATA
+    ImColor(200, 125, 255), // OBJECT_TYPE_SUBGRAPH
+    ImColor(200, 200, 200), // OBJECT_TYPE_SUBGRAPH_INPUT
+    ImColor(200, 200, 200), // OBJECT_TYPE_SUBGRAPH_OUTPUT
 };
 
 const ImColor FUNC_TAG_COLOR = ImColor(125, 125, 255);
@@ -42,6 +47,12 @@ static const char* kSlotKind[] = {
     u8"出力スロット",
 };
 
+static const char* kQualityName[] = {
+    u8"Low",
+    u8"Medium",
+    u8"High",
+};
+
 
 const char* DefinedFuncName[] = {
     "abs\0",
@@ -106,6 +117,16 @@ const char* DefinedFuncName[] = {
 
 
 
+//-----------------------------------------------------------------------------
+//      バイナリ形式のグラフファイルかどうか判定します.
+//-----------------------------------------------------------------------------
+bool IsBinaryGraphPath(const std::string& path)
+{
+    static const char kExt[] = ".sgb";
+    auto length = sizeof(kExt) - 1;
+    return path.size() >= length && _stricmp(path.c_str() + path.size() - length, kExt) == 0;
+}
+
 //-----------------------------------------------------------------------------
 //      オープンファイルダイアログを開きます.
 //-----------------------------------------------------------------------------
@@ -138,6 +159,48 @@ bool OpenFileDlg
     return false;
 }
 
+//-----------------------------------------------------------------------------
+//      セーブファイルダイアログを開きます.
+//-----------------------------------------------------------------------------
+bool SaveFileDlg
+(
+    const char*     title,
+    const char*     filter,
+    const char*     ext,
+    std::string&    result
+)
+{
+    char path[MAX_PATH + 1] = {};
+
+    OPENFILENAMEA ofn = {};
+    ofn.lStructSize     = sizeof(OPENFILENAMEA);
+    ofn.hwndOwner       = nullptr;
+    ofn.lpstrFilter     = filter;
+    ofn.lpstrFile       = path;
+    ofn.nMaxFile        = MAX_PATH;
+    ofn.lpstrDefExt     = ext;
+    ofn.nMaxFileTitle   = MAX_PATH;
+    ofn.lpstrTitle      = title;
+    ofn.Flags           = OFN_OVERWRITEPROMPT;
+
+    if (GetSaveFileNameA(&ofn))
+    {
+        result = path;
+        return true;
+    }
+
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//      経過時間をミリ秒単位で取得します.
+//-----------------------------------------------------------------------------
+double GetElapsedMsec(const std::chrono::steady_clock::time_point& begin)
+{
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - begin).count();
+}
+
 int __stdcall BrowseCallbackProc(HWND hWnd, UINT uMsg, LPARAM lParam, LPARAM lpData)
 {
     CHAR dir[MAX_PATH] = {};
@@ -357,9 +420,7 @@ bool ImGuiDragSlot(Slot* slot, ImGuiID* hoverredId, bool& remove)
     const ImGuiID id = window->GetID(ptr_id);
     const float w = ImGui::CalcItemWidth();
 
-    slot->Id = id;
-
-    const ImVec2 label_size = ImGui::CalcTextSize(slot->Tag.c_str(), nullptr, true);
+    const ImVec2 label_size = ImGui::CalcTextSize(slot->GetTag(), nullptr, true);
     const ImRect frame_bb(window->DC.CursorPos, window->DC.CursorPos + ImVec2(w + NODE_SLOT_RADIUS + style.FramePadding.x + 8.0f, label_size.y + style.FramePadding.y * 2.0f));
     const ImRect inner_bb(frame_bb.Min + style.FramePadding, frame_bb.Max - style.FramePadding);
     const ImRect total_bb(frame_bb.Min, frame_bb.Max + ImVec2(style.ItemInnerSpacing.x, 0));
@@ -414,7 +475,7 @@ bool ImGuiDragSlot(Slot* slot, ImGuiID* hoverredId, bool& remove)
     ImVec2 dst;
     const bool value_changed = ImGuiDragBehavior2D(
         center, NODE_SLOT_RADIUS, id, &dst, hoverredId);
-    ImGui::RenderText(textPos, slot->Tag.c_str());
+    ImGui::RenderText(textPos, slot->GetTag());
 
     if (value_changed && *hoverredId == 0)
     {
@@ -501,14 +562,14 @@ void DrawGrid(ImVec2 offset)
 //-----------------------------------------------------------------------------
 //      リンクの接続線を描画します.
 //-----------------------------------------------------------------------------
-void DrawLink(Link& link)
+void DrawLink(const Slot* lhs, const Slot* rhs)
 {
     auto drawList = ImGui::GetWindowDrawList();
     drawList->AddBezierCurve(
-        link.Lhs->Pos,
-        link.Lhs->Pos + ImVec2(50.0f, 0.0f),
-        link.Rhs->Pos - ImVec2(50.0f, 0.0f),
-        link.Rhs->Pos,
+        lhs->Pos,
+        lhs->Pos + ImVec2(50.0f, 0.0f),
+        rhs->Pos - ImVec2(50.0f, 0.0f),
+        rhs->Pos,
         ImColor(200, 200, 200),
         3.0f);
 }
@@ -544,17 +605,32 @@ bool CheckName(const char* name)
 //      コンストラクタです.
 //-----------------------------------------------------------------------------
 Editor::Editor()
+: m_History(m_EditData)
+, m_Journal(m_EditData)
 { 
     auto node = m_EditData.GetStageOutput();
     node->Pos.x = 800;
     node->Pos.y = 400;
+
+    // 前回のセッションを復元し，その状態から記録を始める.
+    m_Journal.SetPath("autosave.sgb", "autosave.sjl");
+    if (m_Journal.Recover())
+    { m_Status = u8"前回の編集内容を復元しました"; }
+
+    m_Journal.Checkpoint();
+    m_History.SetJournal(&m_Journal);
 }
 
 //-----------------------------------------------------------------------------
 //      デストラクタです.
 //-----------------------------------------------------------------------------
 Editor::~Editor()
-{ m_EditData.Reset(); }
+{
+    m_History.SetJournal(nullptr);
+    m_Journal.Close();
+    m_History.Clear();
+    m_EditData.Reset();
+}
 
 //-----------------------------------------------------------------------------
 //      描画処理を行います.
@@ -563,6 +639,28 @@ void Editor::Render(uint32_t w, uint32_t h)
 {
     m_Size = ImVec2(float(w), float(h));
 
+    // ボタンを離したらドラッグ中の変更の結合を打ち切る.
+    if (!ImGui::IsMouseDown(0))
+    { m_History.Seal(); }
+
+    // 元に戻す・やり直し.
+    auto& io = ImGui::GetIO();
+    if (io.KeyCtrl && !io.WantTextInput)
+    {
+        if (ImGui::IsKeyPressed('Z'))
+        { Undo(); }
+        else if (ImGui::IsKeyPressed('Y'))
+        { Redo(); }
+        else if (ImGui::IsKeyPressed('C'))
+        { Copy(); }
+        else if (ImGui::IsKeyPressed('V'))
+        { Paste(ImGui::GetMousePos()); }
+    }
+
+    // バックグラウンド保存・プロジェクト読み込みの完了確認.
+    PollSave();
+    PollProject();
+
     // 編集パネル.
     DrawEditPanel();
 
@@ -571,6 +669,28 @@ void Editor::Render(uint32_t w, uint32_t h)
 
     // プロパティパネル.
     DrawPropPanel();
+
+    // カタログパネル.
+    DrawCatalogPanel();
+
+    // フレーム終端で破棄済みノードを解放.
+    m_EditData.ReclaimNodes();
+
+    // ジャーナルの書き出し.
+    m_Journal.Update();
+}
+
+//-----------------------------------------------------------------------------
+//      描画に使うデバイスを設定します.
+//
+//      nullptr を設定するとデバイスに依存するリソースを解放します.
+//-----------------------------------------------------------------------------
+void Editor::SetDevice(ID3D11Device* pDevice)
+{
+    if (pDevice != nullptr)
+    { m_Thumbnails.Init(pDevice); }
+    else
+    { m_Thumbnails.Term(); }
 }
 
 //-----------------------------------------------------------------------------
@@ -626,8 +746,16 @@ void Editor::DrawEditPanel()
         DrawNode(m_EditData.GetStageOutput(), offset, openContextMenu);
 
         // 接続確定後にリンクを描画.
-        for(size_t i=0; i<m_Links.size(); ++i)
-        { DrawLink(m_Links[i]); }
+        for(size_t i=0; i<=nodes.size(); ++i)
+        {
+            auto node = (i < nodes.size()) ? nodes[i] : m_EditData.GetStageOutput();
+            for(size_t j=0; j<node->pSlots.size(); ++j)
+            {
+                auto slot = node->pSlots[j];
+                if (slot->Kind == SlotType::Input && slot->pPrev != nullptr)
+                { DrawLink(slot->pPrev, slot); }
+            }
+        }
 
         // レイヤーを合成.
         drawList->ChannelsMerge();
@@ -641,7 +769,7 @@ void Editor::DrawEditPanel()
           //&& ImGui::IsMouseHoveringWindow()
           && ImGui::IsMouseClicked(1))
         {
-            m_pSelectedNode = nullptr;
+            ClearSelection();
             openContextMenu = true;
             m_GeneratePos = ImGui::GetMousePos();
         }
@@ -672,7 +800,6 @@ void Editor::DrawEditPanel()
     ImGui::EndGroup();
     ImGui::End();
 
-    //m_SelectedId = (m_pSelectedNode != nullptr) ? m_pSelectedNode->Id : -1;
 }
 
 //-----------------------------------------------------------------------------
@@ -700,7 +827,14 @@ void Editor::DrawNode(Node* node, ImVec2& offset, bool& openContextMenu)
             auto color = NodeTagColor[(int)node->Type];
 
             // ノード名.
-            ImGui::TextColored(color, "%s", node->Tag.c_str());
+            ImGui::TextColored(color, "%s", node->GetTag());
+
+            // 最低品質.
+            if (node->MinQuality != QualityLevel::Low)
+            {
+                ImGui::SameLine();
+                ImGui::TextDisabled("[%s+]", kQualityName[node->MinQuality]);
+            }
 
             // スロットを描画.
             for(size_t idx=0; idx<node->pSlots.size(); ++idx)
@@ -751,7 +885,21 @@ void Editor::DrawNode(Node* node, ImVec2& offset, bool& openContextMenu)
             }
             else if (node->Type == NodeType::Texture)
             {
-                ImGui::Image(node->TextureId, ImVec2(64, 64));
+                // 見えているときだけ要求し，デコードが終わるまでは枠を表示する.
+                auto size  = ImVec2(float(ThumbnailCache::kSize), float(ThumbnailCache::kSize));
+                auto state = ThumbnailLoading;
+                if (ImGui::IsRectVisible(size))
+                { state = m_Thumbnails.Request(node->TexturePath, node->TextureId); }
+
+                if (node->TextureId != nullptr)
+                { ImGui::Image(node->TextureId, size); }
+                else
+                {
+                    auto pos = ImGui::GetCursorScreenPos();
+                    drawList->AddRect(pos, pos + size, ImColor(100, 100, 100));
+                    ImGui::Dummy(size);
+                    drawList->AddText(pos + ImVec2(4, 4), ImColor(150, 150, 150), (state == ThumbnailFailed) ? u8"読込失敗" : u8"読込中");
+                }
             }
         }
         ImGui::EndGroup();
@@ -771,27 +919,45 @@ void Editor::DrawNode(Node* node, ImVec2& offset, bool& openContextMenu)
         // ドラッグ移動できるように設定.
         ImGui::InvisibleButton("Node", node->Size);
 
+        auto handle = m_EditData.GetHandle(node);
+
         if (ImGui::IsItemHovered())
         {
-            m_pHoveredNode = node;
+            m_HoveredNode = handle;
             openContextMenu |= ImGui::IsMouseClicked(1);
         }
 
         bool movingActive = ImGui::IsItemActive();
 
+        // 複数選択更新. Ctrlキー押下時は選択を切り替える.
+        if (ImGui::IsItemClicked(0))
+        {
+            auto itr = std::find(m_SelectedNodes.begin(), m_SelectedNodes.end(), handle);
+            if (!ImGui::GetIO().KeyCtrl)
+            {
+                m_SelectedNodes.clear();
+                m_SelectedNodes.push_back(handle);
+            }
+            else if (itr != m_SelectedNodes.end())
+            { m_SelectedNodes.erase(itr); }
+            else
+            { m_SelectedNodes.push_back(handle); }
+        }
+
         // 選択ノード更新.
         if (widgetsActive || movingActive)
-        { m_pSelectedNode = node; }
+        { m_SelectedNode = handle; }
 
         // ドラッグ移動.
         if (movingActive && ImGui::IsMouseDragging(0))
-        { node->Pos = node->Pos + ImGui::GetIO().MouseDelta; }
-
-        bool match = false;
-        if (m_pSelectedNode != nullptr)
-        { match = m_pSelectedNode == node; }
+        {
+            auto oldPos = node->Pos;
+            node->Pos = node->Pos + ImGui::GetIO().MouseDelta;
+            m_History.MoveNode(node, oldPos);
+        }
 
-        bool active = match;
+        bool active = (m_SelectedNode == handle)
+            || std::find(m_SelectedNodes.begin(), m_SelectedNodes.end(), handle) != m_SelectedNodes.end();
 
         // 塗りつぶし色決定
         ImU32 bgColor = (active) ? ImColor(80, 80, 80) : ImColor(0, 0, 0);
@@ -823,6 +989,9 @@ void Editor::DrawSlot(Slot* slot)
     auto window = ImGui::GetCurrentWindow();
     bool remove = false;
 
+    // 接続先を検索できるようにIDを登録.
+    m_EditData.SetSlotId(slot, window->GetID((const void*)slot));
+
     // スロット描画.
     auto ret = ImGuiDragSlot(
         slot,
@@ -831,7 +1000,7 @@ void Editor::DrawSlot(Slot* slot)
 
     // 複数つながっているときに困るので入力ピンに刺さっている側から削除させない.
     if (remove && slot->Kind == SlotType::Input)
-    { RemoveLink(slot); }
+    { m_History.RemoveLink(slot); }
 
     if (!ret)
     { return; }
@@ -851,10 +1020,11 @@ void Editor::DrawSlot(Slot* slot)
             return;
         }
 
-        // 既に入力スロットは1つしか入力を受け付けない。
+        // 入力スロットは1つしか入力を受け付けない。
         // そのため，入力スロットに既に接続がある場合は除外する.
-        if (slot->Kind == SlotType::Output && targetSlot->pPrev != nullptr
-         || slot->Kind == SlotType::Input  && targetSlot->pNext != nullptr)
+        // 出力スロットは複数の入力スロットに接続できる.
+        auto input = (slot->Kind == SlotType::Input) ? slot : targetSlot;
+        if (input->pPrev != nullptr)
         {
             return;
         }
@@ -867,14 +1037,15 @@ void Editor::DrawSlot(Slot* slot)
         }
 
         // 入力と出力を決定.
-        if (targetSlot->Kind == SlotType::Input)
-        { AddLink(slot, targetSlot); }
-        else
-        { AddLink(targetSlot, slot); }
+        auto linked = (targetSlot->Kind == SlotType::Input)
+            ? m_History.AddLink(slot, targetSlot)
+            : m_History.AddLink(targetSlot, slot);
+        if (!linked)
+        { ErrorDlg("接続不能", "接続すると循環するため接続できません\n"); }
     }
     else if (slot->Kind == SlotType::Input)
     {
-        RemoveLink(slot);
+        m_History.RemoveLink(slot);
     }
 }
 
@@ -886,35 +1057,85 @@ void Editor::DrawContextMenu()
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, NODE_WINDOW_PADDING);
     if (ImGui::BeginPopup("ContextMenu"))
     {
-        if (m_pSelectedNode != nullptr && m_pSelectedNode->Type != NodeType::StageOutput)
+        auto selected = GetSelectedNode();
+        if (selected != nullptr && selected->Type != NodeType::StageOutput)
         {
             if (ImGui::MenuItem(u8"ノード削除"))
             {
-                for(size_t i=0; i<m_pSelectedNode->pSlots.size(); ++i)
+                m_History.RemoveNode(selected);
+                ClearSelection();
+            }
+
+            if (ImGui::MenuItem(u8"コピー", "Ctrl+C"))
+            { Copy(); }
+
+            if (ImGui::MenuItem(u8"サブグラフに集約"))
+            {
+                auto nodes = GetSelectedNodes();
+                auto name  = m_EditData.MakeSubGraphName();
+                auto error = CollapseOk;
+                auto node  = m_EditData.CollapseNodes(nodes, name.c_str(), &error);
+                if (node != nullptr)
                 {
-                    RemoveLink(m_pSelectedNode->pSlots[i]);
+                    // 集約・展開は履歴に記録しないため，それ以前の履歴は破棄する.
+                    // 失敗した場合はグラフが変わらないので履歴を残す.
+                    m_History.Clear();
+                    m_SelectedNodes.clear();
+                    m_SelectedNode = m_EditData.GetHandle(node);
+                    m_Journal.Checkpoint();
                 }
-                m_EditData.RemoveNode(m_pSelectedNode);
-                m_pSelectedNode = nullptr;
+                else if (error == CollapseInvalidName)
+                { ErrorDlg("集約失敗", "サブグラフ名を決定できないため集約できません\n"); }
+                else if (error == CollapseNoTarget)
+                { ErrorDlg("集約失敗", "集約できるノードが選択されていません\n"); }
+                else
+                { ErrorDlg("集約失敗", "選択外のノードを経由して選択ノードに戻る接続があるため集約できません\n"); }
+            }
+
+            if (selected->Type == NodeType::SubGraphNode && ImGui::MenuItem(u8"サブグラフを展開"))
+            {
+                if (m_EditData.ExpandSubGraph(selected))
+                {
+                    m_History.Clear();
+                    ClearSelection();
+                    m_Journal.Checkpoint();
+                }
+                else
+                { ErrorDlg("展開失敗", "サブグラフを展開できませんでした\n"); }
             }
         }
         else
         {
+            if (ImGui::MenuItem(u8"元に戻す", "Ctrl+Z", false, m_History.CanUndo()))
+            { Undo(); }
+
+            if (ImGui::MenuItem(u8"やり直し", "Ctrl+Y", false, m_History.CanRedo()))
+            { Redo(); }
+
+            if (ImGui::MenuItem(u8"貼り付け", "Ctrl+V", false, !m_Clipboard.IsEmpty()))
+            { Paste(m_GeneratePos); }
+
+            ImGui::Separator();
+
             if (ImGui::MenuItem(u8"新規作成"))
-            {
-            }
+            { NewFile(); }
 
             if (ImGui::MenuItem(u8"ファイルを開く"))
-            {
-            }
+            { OpenFile(); }
 
             if (ImGui::MenuItem(u8"上書き保存"))
-            {
-            }
+            { SaveFile(false); }
 
             if (ImGui::MenuItem(u8"名前をつけて保存"))
-            {
-            }
+            { SaveFile(true); }
+
+            ImGui::MenuItem(u8"圧縮して保存", nullptr, &m_CompressSave);
+
+            if (ImGui::MenuItem(u8"プロジェクトを開く", nullptr, false, !m_Project.IsBusy()))
+            { OpenProject(); }
+
+            if (ImGui::MenuItem(u8"カタログを開く"))
+            { OpenCatalog(); }
 
             if (ImGui::MenuItem(u8"シェーダコンパイル"))
             {
@@ -929,43 +1150,61 @@ void Editor::DrawContextMenu()
                 { ErrorDlg("シェーダ出力失敗", "シェーダの出力に失敗しました..."); }
             }
 
+            if (ImGui::MenuItem(u8"シェーダパック出力", nullptr, false, !m_Project.IsBusy() && !m_Project.GetFolder().empty()))
+            {
+                if (m_Project.ExportPack())
+                {
+                    // 出力時に生成したシェーダのハッシュ値をカタログに反映する.
+                    RebuildCatalog();
+                    InfoDlg("シェーダパック出力成功", "シェーダパックを出力しました!");
+                }
+                else
+                { ErrorDlg("シェーダパック出力失敗", "シェーダパックの出力に失敗しました..."); }
+            }
+
             ImGui::Separator();
 
             if (ImGui::BeginMenu(u8"ノードを追加"))
             {
                 if (ImGui::BeginMenu(u8"定数"))
                 {
-                    DrawConstantNodeMenu();
+                    DrawNodeMenu(CategoryConstant);
                     ImGui::EndMenu();
                 }
 
                 if (ImGui::BeginMenu(u8"パッキング"))
                 {
-                    DrawPackingNodeMenu();
+                    DrawNodeMenu(CategoryPacking);
                     ImGui::EndMenu();
                 }
 
                 if (ImGui::BeginMenu(u8"演算子"))
                 {
-                    DrawOperatorNodeMenu(); 
+                    DrawNodeMenu(CategoryOperator);
                     ImGui::EndMenu();
                 }
 
                 if (ImGui::BeginMenu(u8"組み込み関数"))
                 {
-                    DrawBuiltinFuncNodeMenu();
+                    DrawNodeMenu(CategoryBuiltinFunc);
                     ImGui::EndMenu();
                 }
 
                 if (ImGui::BeginMenu(u8"テクスチャ"))
                 {
-                    DrawTextureNodeMenu();
+                    DrawNodeMenu(CategoryTexture);
                     ImGui::EndMenu();
                 }
 
                 if (ImGui::BeginMenu(u8"プリセット関数"))
                 {
-                    DrawPresetFuncNodeMenu();
+                    DrawNodeMenu(CategoryPresetFunc);
+                    ImGui::EndMenu();
+                }
+
+                if (ImGui::BeginMenu(u8"サブグラフ", !m_EditData.GetSubGraphs().empty()))
+                {
+                    DrawSubGraphNodeMenu();
                     ImGui::EndMenu();
                 }
 
@@ -980,245 +1219,392 @@ void Editor::DrawContextMenu()
 }
 
 //-----------------------------------------------------------------------------
-//      演算子ノードのコンテキストメニューを表示します.
+//      ノード記述子からノード追加のコンテキストメニューを表示します.
 //-----------------------------------------------------------------------------
-void Editor::DrawOperatorNodeMenu()
+void Editor::DrawNodeMenu(NodeCategory category)
 {
-    if (ImGui::BeginMenu("operator +"))
-    {
-        if (ImGui::MenuItem("float"))
-        {
-            auto node = OpAdd(DataType::Float1);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float2"))
-        {
-            auto node = OpAdd(DataType::Float2);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float3"))
-        {
-            auto node = OpAdd(DataType::Float3);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float4"))
-        {
-            auto node = OpAdd(DataType::Float4);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
+    const char* group = nullptr;
+    auto open = true;
 
-        ImGui::EndMenu();
-    }
-    if (ImGui::BeginMenu("operator -"))
+    auto count = GetNodeDescriptorCount();
+    for(uint32_t i=0; i<count; ++i)
     {
-        if (ImGui::MenuItem("float"))
-        {
-            auto node = OpSub(DataType::Float1);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float2"))
-        {
-            auto node = OpSub(DataType::Float2);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float3"))
-        {
-            auto node = OpSub(DataType::Float3);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float4"))
+        auto descriptor = GetNodeDescriptor(i);
+        if (descriptor->Category != category)
+        { continue; }
+
+        // サブグループが切り替わったらサブメニューを開き直す.
+        auto same = (descriptor->Group == group)
+                 || (descriptor->Group != nullptr && group != nullptr && strcmp(descriptor->Group, group) == 0);
+        if (!same)
         {
-            auto node = OpSub(DataType::Float4);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
+            if (group != nullptr && open)
+            { ImGui::EndMenu(); }
 
-        ImGui::EndMenu();
-    }
-    if (ImGui::BeginMenu("operator *"))
-    {
-        if (ImGui::MenuItem("float"))
-        {
-            auto node = OpMul(DataType::Float1);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float2"))
-        {
-            auto node = OpMul(DataType::Float2);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float3"))
-        {
-            auto node = OpMul(DataType::Float3);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
+            group = descriptor->Group;
+            open  = (group != nullptr) ? ImGui::BeginMenu(group) : true;
         }
-        else if (ImGui::MenuItem("float4"))
+
+        if (!open)
+        { continue; }
+
+        ImGui::PushID(int(i));
+        if (ImGui::MenuItem(descriptor->Label))
         {
-            auto node = OpMul(DataType::Float4);
+            auto node = CreateBuiltinNode(m_EditData, descriptor);
             node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
+            m_History.AddNode(node);
         }
-
-        ImGui::EndMenu();
+        ImGui::PopID();
     }
-    if (ImGui::BeginMenu("operator /"))
+
+    if (group != nullptr && open)
+    { ImGui::EndMenu(); }
+}
+
+//-----------------------------------------------------------------------------
+//      サブグラフノードのコンテキストメニューを表示します.
+//-----------------------------------------------------------------------------
+void Editor::DrawSubGraphNodeMenu()
+{
+    auto& subGraphs = m_EditData.GetSubGraphs();
+    for(size_t i=0; i<subGraphs.size(); ++i)
     {
-        if (ImGui::MenuItem("float"))
-        {
-            auto node = OpDiv(DataType::Float1);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float2"))
-        {
-            auto node = OpDiv(DataType::Float2);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float3"))
-        {
-            auto node = OpDiv(DataType::Float3);
-            node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
-        }
-        else if (ImGui::MenuItem("float4"))
+        ImGui::PushID(subGraphs[i]);
+        if (ImGui::MenuItem(subGraphs[i]->Name.c_str()))
         {
-            auto node = OpDiv(DataType::Float4);
+            auto node = m_EditData.CreateSubGraphNode(subGraphs[i]);
             node->Pos = m_GeneratePos;
-            m_EditData.AddNode(node);
+            m_History.AddNode(node);
         }
-
-        ImGui::EndMenu();
+        ImGui::PopID();
     }
 }
 
 //-----------------------------------------------------------------------------
-//      パッキングノードのコンテキストメニューを表示します.
+//      選択中のノードを取得します. 破棄済みの場合は nullptr を返します.
+//-----------------------------------------------------------------------------
+Node* Editor::GetSelectedNode() const
+{ return m_EditData.GetNode(m_SelectedNode); }
+
+//-----------------------------------------------------------------------------
+//      複数選択ノードと選択中のノードを破棄済みのものを除いて取得します.
 //-----------------------------------------------------------------------------
-void Editor::DrawPackingNodeMenu()
+std::vector<Node*> Editor::GetSelectedNodes() const
 {
-    if (ImGui::MenuItem("ToFloat2"))
-    {
-        auto node = ToFloat2();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("ToFloat3"))
-    {
-        auto node = ToFloat3();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("ToFloat4"))
-    {
-        auto node = ToFloat4();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("FromFloat2"))
-    {
-        auto node = FromFloat2();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("FromFloat3"))
-    {
-        auto node = FromFloat3();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("FromFloat4"))
+    std::vector<Node*> result;
+    result.reserve(m_SelectedNodes.size() + 1);
+
+    for(size_t i=0; i<m_SelectedNodes.size(); ++i)
     {
-        auto node = FromFloat4();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
+        auto node = m_EditData.GetNode(m_SelectedNodes[i]);
+        if (node != nullptr)
+        { result.push_back(node); }
     }
+
+    auto selected = GetSelectedNode();
+    if (selected != nullptr && std::find(result.begin(), result.end(), selected) == result.end())
+    { result.push_back(selected); }
+
+    return result;
 }
 
 //-----------------------------------------------------------------------------
-//      定数ノードのコンテキストメニューを表示します.
+//      選択を解除します.
 //-----------------------------------------------------------------------------
-void Editor::DrawConstantNodeMenu()
+void Editor::ClearSelection()
 {
-    if (ImGui::MenuItem("float"))
-    {
-        auto node = ConstantValue(DataType::Float1);
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("float2"))
-    {
-        auto node = ConstantValue(DataType::Float2);
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("float3"))
-    {
-        auto node = ConstantValue(DataType::Float3);
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("float4"))
-    {
-        auto node = ConstantValue(DataType::Float4);
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("color3"))
-    {
-        auto node = Color3();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
-    }
-    else if (ImGui::MenuItem("color4"))
+    m_SelectedNodes.clear();
+    m_SelectedNode = NodeHandle();
+    m_HoveredNode  = NodeHandle();
+}
+
+//-----------------------------------------------------------------------------
+//      直前の編集を元に戻します.
+//-----------------------------------------------------------------------------
+void Editor::Undo()
+{
+    if (!m_History.Undo())
+    { return; }
+
+    // 選択中のノードがグラフから外れている可能性があるため選択を解除.
+    ClearSelection();
+}
+
+//-----------------------------------------------------------------------------
+//      元に戻した編集をやり直します.
+//-----------------------------------------------------------------------------
+void Editor::Redo()
+{
+    if (!m_History.Redo())
+    { return; }
+
+    ClearSelection();
+}
+
+//-----------------------------------------------------------------------------
+//      選択中のノードをコピーします.
+//-----------------------------------------------------------------------------
+void Editor::Copy()
+{
+    auto nodes = GetSelectedNodes();
+    if (nodes.empty())
+    { return; }
+
+    m_EditData.CopyNodes(nodes, m_Clipboard);
+}
+
+//-----------------------------------------------------------------------------
+//      コピーしたノードを貼り付けます.
+//-----------------------------------------------------------------------------
+void Editor::Paste(const ImVec2& pos)
+{
+    if (m_Clipboard.IsEmpty())
+    { return; }
+
+    std::vector<Node*> nodes;
+    m_EditData.PasteNodes(m_Clipboard, pos, nodes);
+    m_History.AddNodes(nodes);
+
+    // 貼り付けたノードを選択状態にする.
+    ClearSelection();
+    for(size_t i=0; i<nodes.size(); ++i)
+    { m_SelectedNodes.push_back(m_EditData.GetHandle(nodes[i])); }
+}
+
+//-----------------------------------------------------------------------------
+//      編集データを破棄して新規作成します.
+//-----------------------------------------------------------------------------
+void Editor::NewFile()
+{
+    m_History.Clear();
+    m_EditData.Reset();
+    m_Journal.Checkpoint();
+    ClearSelection();
+    m_FilePath.clear();
+    m_Status.clear();
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを開きます.
+//-----------------------------------------------------------------------------
+void Editor::OpenFile()
+{
+    std::string path;
+    if (!OpenFileDlg("ファイルを開く", "Shader Graph(*.xml)\0*.xml\0Shader Graph Binary(*.sgb)\0*.sgb\0\0", "xml", path))
+    { return; }
+
+    LoadFile(path);
+}
+
+//-----------------------------------------------------------------------------
+//      指定したファイルを読み込みます.
+//-----------------------------------------------------------------------------
+void Editor::LoadFile(const std::string& path)
+{
+    // 保存中のファイルを読み込まないよう完了を待つ.
+    m_Saver.Wait();
+    PollSave();
+
+    m_History.Clear();
+    ClearSelection();
+
+    auto begin = std::chrono::steady_clock::now();
+    auto result = IsBinaryGraphPath(path) ? m_EditData.LoadBinary(path.c_str()) : m_EditData.Load(path.c_str());
+    m_Journal.Checkpoint();
+    if (!result)
     {
-        auto node = Color4();
-        node->Pos = m_GeneratePos;
-        m_EditData.AddNode(node);
+        m_FilePath.clear();
+        m_Status.clear();
+        ErrorDlg("読み込み失敗", "ファイルの読み込みに失敗しました...");
+        return;
     }
+
+    m_FilePath = path;
+    m_Status   = StringHelper::Format(u8"読み込み : %zu ノード %.1f ms", m_EditData.GetNodes().size(), GetElapsedMsec(begin));
 }
 
 //-----------------------------------------------------------------------------
-//      テクスチャノードのコンテキストメニューを表示します.
+//      ファイルを保存します.
 //-----------------------------------------------------------------------------
-void Editor::DrawTextureNodeMenu()
+void Editor::SaveFile(bool saveAs)
 {
-    if (ImGui::MenuItem(u8"Sample"))
+    if (m_Saver.IsBusy())
     {
+        m_Status = u8"前回の保存が完了していません";
+        return;
     }
-    else if (ImGui::MenuItem(u8"SampleLevel"))
+
+    if (saveAs || m_FilePath.empty())
     {
+        std::string path;
+        if (!SaveFileDlg("名前をつけて保存", "Shader Graph(*.xml)\0*.xml\0Shader Graph Binary(*.sgb)\0*.sgb\0\0", "xml", path))
+        { return; }
+
+        m_FilePath = path;
     }
-    else if (ImGui::MenuItem(u8"SampleGrad"))
+
+    // スナップショットだけを取り，書き出しはワーカースレッドで行う.
+    // カタログの項目も同じ時点の内容から作る.
+    CaptureCatalogItem(m_EditData, m_SaveItem);
+    m_Saver.Start(m_EditData, m_FilePath.c_str(), IsBinaryGraphPath(m_FilePath), m_CompressSave);
+}
+
+//-----------------------------------------------------------------------------
+//      バックグラウンド保存の結果を反映します.
+//
+//      失敗してもダイアログは出さず，ステータスに表示します.
+//-----------------------------------------------------------------------------
+void Editor::PollSave()
+{
+    bool succeeded = false;
+    if (!m_Saver.Poll(succeeded))
+    { return; }
+
+    if (succeeded)
     {
+        m_Status = StringHelper::Format(u8"保存 : %u ノード %.1f ms (スナップショット %.1f ms)",
+            m_Saver.GetNodeCount(), m_Saver.GetElapsedMsec(), m_Saver.GetCaptureMsec());
+        UpdateCatalog(m_Saver.GetPath(), m_SaveItem);
     }
-    else if (ImGui::MenuItem(u8"Load"))
+    else
+    { m_Status = StringHelper::Format(u8"保存失敗 : %s", m_Saver.GetPath().c_str()); }
+}
+
+//-----------------------------------------------------------------------------
+//      プロジェクトを開きます.
+//
+//      フォルダ以下の全グラフをワーカースレッドで読み込みます.
+//-----------------------------------------------------------------------------
+void Editor::OpenProject()
+{
+    char folder[MAX_PATH] = {};
+    if (!OpenFolderDlg("プロジェクトフォルダを指定", m_Project.GetFolder().c_str(), folder))
+    { return; }
+
+    m_Project.Start(folder);
+}
+
+//-----------------------------------------------------------------------------
+//      プロジェクトの読み込み結果を反映します.
+//-----------------------------------------------------------------------------
+void Editor::PollProject()
+{
+    if (!m_Project.Poll())
+    { return; }
+
+    m_Status = StringHelper::Format(u8"プロジェクト : %zu マテリアル (失敗 %u) %.1f ms",
+        m_Project.GetMaterials().size(), m_Project.GetFailedCount(), m_Project.GetLoadMsec());
+
+    RebuildCatalog();
+    m_ShowCatalog = true;
+}
+
+//-----------------------------------------------------------------------------
+//      読み込んだ全マテリアルからプロジェクトのカタログを作り直します.
+//
+//      読み込んだだけのマテリアルはシェーダを生成していないので，以前の
+//      カタログからシェーダ生成時のハッシュ値を引き継ぎます.
+//-----------------------------------------------------------------------------
+void Editor::RebuildCatalog()
+{
+    ProjectCatalog previous;
+    previous.Load(m_Project.GetFolder().c_str());
+
+    m_Catalog.Reset(m_Project.GetFolder().c_str());
+
+    auto& materials = m_Project.GetMaterials();
+    for(size_t i=0; i<materials.size(); ++i)
     {
+        if (materials[i].pData == nullptr)
+        { continue; }
+
+        CatalogItem item;
+        CaptureCatalogItem(*materials[i].pData, item);
+        m_Catalog.Update(materials[i].Path, item);
     }
+
+    m_Catalog.Inherit(previous);
+    m_Catalog.Save();
+    SearchCatalog();
+}
+
+//-----------------------------------------------------------------------------
+//      カタログを開きます.
+//
+//      グラフファイルは読み込まず，フォルダ直下のカタログファイルだけを
+//      読み込みます.
+//-----------------------------------------------------------------------------
+void Editor::OpenCatalog()
+{
+    char folder[MAX_PATH] = {};
+    if (!OpenFolderDlg("カタログのフォルダを指定", m_Catalog.GetFolder().c_str(), folder))
+    { return; }
+
+    auto begin = std::chrono::steady_clock::now();
+    if (m_Catalog.Load(folder))
+    { m_Status = StringHelper::Format(u8"カタログ : %zu マテリアル %.1f ms", m_Catalog.GetItems().size(), GetElapsedMsec(begin)); }
+    else if (m_Catalog.IsBroken())
+    { m_Status = StringHelper::Format(u8"カタログを読み込めません(プロジェクトを開くと作り直します) : %s", folder); }
+    else
+    { m_Status = StringHelper::Format(u8"カタログがありません : %s", folder); }
+
+    m_ShowCatalog = true;
+    SearchCatalog();
 }
 
 //-----------------------------------------------------------------------------
-//      組み込み関数ノードのコンテキストメニューを表示します.
+//      検索文字列でカタログを検索し直します.
 //-----------------------------------------------------------------------------
-void Editor::DrawBuiltinFuncNodeMenu()
+void Editor::SearchCatalog()
 {
+    auto begin = std::chrono::steady_clock::now();
+    m_Catalog.Search(m_CatalogFilter, m_CatalogHits);
+    m_CatalogSearchMsec = GetElapsedMsec(begin);
 }
 
 //-----------------------------------------------------------------------------
-//      プリセット関数ノードのコンテキストメニューを表示します.
+//      保存したグラフをカタログに登録します.
+//
+//      表示中のカタログのフォルダ以下ならそのカタログに，プロジェクトの
+//      フォルダ以下ならプロジェクトのカタログに登録します. それ以外は
+//      カタログのある最も外側の祖先フォルダか，ファイルと同じフォルダの
+//      カタログに登録します.
 //-----------------------------------------------------------------------------
-void Editor::DrawPresetFuncNodeMenu()
+void Editor::UpdateCatalog(const std::string& path, const CatalogItem& item)
 {
+    if (m_Catalog.Contains(path))
+    {
+        if (m_Catalog.IsBroken())
+        {
+            m_Status += StringHelper::Format(u8" (カタログを読み込めないため更新しません : %s)", m_Catalog.GetFolder().c_str());
+            return;
+        }
+
+        m_Catalog.Update(path, item);
+        m_Catalog.Save();
+        SearchCatalog();
+        return;
+    }
+
+    ProjectCatalog catalog;
+    catalog.Reset(m_Project.GetFolder().c_str());
+
+    auto folder = catalog.Contains(path) ? catalog.GetFolder() : ProjectCatalog::FindFolder(path);
+    if (folder.empty())
+    { return; }
+
+    // 壊れたカタログや古い形式のカタログを1項目だけのカタログで上書きしない.
+    // プロジェクトを開き直すと全マテリアルから作り直される.
+    catalog.Load(folder.c_str());
+    if (catalog.IsBroken())
+    {
+        m_Status += StringHelper::Format(u8" (カタログを読み込めないため更新しません : %s)", folder.c_str());
+        return;
+    }
+
+    catalog.Update(path, item);
+    catalog.Save();
 }
 
 //-----------------------------------------------------------------------------
@@ -1230,6 +1616,75 @@ void Editor::DrawPreviewPanel()
     ImGui::SetNextWindowSize(ImVec2(400.0f, 420.0f), ImGuiCond_Once);
     ImGui::Begin(u8"プレビュー");
     ImGui::Image(m_Preview, ImVec2(390, 390));
+
+    // 保存中・読み込み中は進捗を表示し，それ以外は直前のファイル操作の所要時間.
+    if (m_Saver.IsBusy())
+    {
+        auto label = StringHelper::Format(u8"保存中 : %u ノード", m_Saver.GetNodeCount());
+        ImGui::ProgressBar(m_Saver.GetProgress(), ImVec2(-1.0f, 0.0f), label.c_str());
+    }
+    else if (m_Project.IsBusy())
+    { ImGui::ProgressBar(m_Project.GetProgress(), ImVec2(-1.0f, 0.0f), u8"プロジェクト読み込み中"); }
+    else if (!m_Status.empty())
+    { ImGui::TextUnformatted(m_Status.c_str()); }
+
+    ImGui::End();
+}
+
+//-----------------------------------------------------------------------------
+//      カタログパネルを描画します.
+//
+//      表示する行だけを描画するので，項目数が多くても描画の負荷は増えません.
+//-----------------------------------------------------------------------------
+void Editor::DrawCatalogPanel()
+{
+    if (!m_ShowCatalog)
+    { return; }
+
+    ImGui::SetNextWindowPos(ImVec2(0.0f, m_Size.y - 300.0f), ImGuiCond_Once);
+    ImGui::SetNextWindowSize(ImVec2(600.0f, 300.0f), ImGuiCond_Once);
+    if (!ImGui::Begin(u8"カタログ", &m_ShowCatalog))
+    {
+        ImGui::End();
+        return;
+    }
+
+    if (ImGui::InputText(u8"検索", m_CatalogFilter, sizeof(m_CatalogFilter)))
+    { SearchCatalog(); }
+
+    auto& items = m_Catalog.GetItems();
+    ImGui::Text(u8"%zu / %zu 件 (%.2f ms)", m_CatalogHits.size(), items.size(), m_CatalogSearchMsec);
+    ImGui::Separator();
+
+    ImGui::BeginChild("CatalogItems");
+    ImGuiListClipper clipper;
+    clipper.Begin(int(m_CatalogHits.size()));
+    while(clipper.Step())
+    {
+        for(auto i=clipper.DisplayStart; i<clipper.DisplayEnd; ++i)
+        {
+            auto& item  = items[m_CatalogHits[i]];
+            auto  code  = (item.CodeHash == 0) ? u8"未生成" : (item.CodeHash == item.GraphHash) ? u8"生成済" : u8"要再生成";
+            auto  label = StringHelper::Format(u8"%s  (%u ノード, テクスチャ %zu, %016llx, シェーダ %s)",
+                item.Path.c_str(), item.NodeCount, item.Textures.size(), (unsigned long long)item.GraphHash, code);
+
+            ImGui::PushID(i);
+            if (ImGui::Selectable(label.c_str(), false, ImGuiSelectableFlags_AllowDoubleClick)
+            && ImGui::IsMouseDoubleClicked(0))
+            { LoadFile(m_Catalog.GetFullPath(item)); }
+
+            if (ImGui::IsItemHovered() && !item.Textures.empty())
+            {
+                ImGui::BeginTooltip();
+                for(size_t j=0; j<item.Textures.size(); ++j)
+                { ImGui::TextUnformatted(item.Textures[j].c_str()); }
+                ImGui::EndTooltip();
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+
     ImGui::End();
 }
 
@@ -1242,7 +1697,7 @@ void Editor::DrawPropPanel()
     ImGui::SetNextWindowSize(ImVec2(400.0f, m_Size.y - 420.0f), ImGuiCond_Once);
     ImGui::Begin(u8"プロパティ");
 
-    auto node = m_pSelectedNode;
+    auto node = GetSelectedNode();
 
     // 選択されていなければ終了.
     if (node == nullptr)
@@ -1252,16 +1707,19 @@ void Editor::DrawPropPanel()
         return;
     }
 
+    float oldValues[4];
+    memcpy(oldValues, node->Values, sizeof(oldValues));
+
     switch(node->Type)
     {
     case NodeType::Function:
         {
             ImGui::Text(u8"関数ノード");
-            ImGui::Text(u8"関数名：%s", node->Tag.c_str());
+            ImGui::Text(u8"関数名：%s", node->GetTag());
             for(size_t i=0; i<node->pSlots.size(); ++i)
             {
                 auto slot = node->pSlots[i];
-                ImGui::Text(u8"%s : %s %s", kSlotKind[slot->Kind], kDataType[slot->Type], slot->Tag.c_str());
+                ImGui::Text(u8"%s : %s %s", kSlotKind[slot->Kind], kDataType[slot->Type], slot->GetTag());
             }
         }
         break;
@@ -1306,6 +1764,8 @@ void Editor::DrawPropPanel()
                     ImGui::DragFloat4(u8"値", node->Values, 0.1f);
                 }
             }
+
+            m_History.SetValues(node, oldValues);
         }
         break;
 
@@ -1348,66 +1808,101 @@ void Editor::DrawPropPanel()
         }
         break;
 
+    case NodeType::SubGraphNode:
+        {
+            ImGui::Text(u8"サブグラフノード");
+
+            char name[256] = {};
+            strcpy_s(name, node->pSubGraph->Name.c_str());
+            if (ImGui::InputText(u8"名前", name, sizeof(name), ImGuiInputTextFlags_EnterReturnsTrue))
+            {
+                if (CheckName(name))
+                {
+                    if (m_EditData.RenameSubGraph(node->pSubGraph, name))
+                    { m_Journal.RenameSubGraph(node->pSubGraph); }
+                    else
+                    { ErrorDlg("エラー", "同じ名前のサブグラフが既にあります.\n別の名前を入力してください."); }
+                }
+            }
+
+            for(size_t i=0; i<node->pSlots.size(); ++i)
+            {
+                auto slot = node->pSlots[i];
+                ImGui::Text(u8"%s : %s %s", kSlotKind[slot->Kind], kDataType[slot->Type], slot->GetTag());
+            }
+        }
+        break;
+
     case NodeType::StageOutput:
         {
             ImGui::Text(u8"ステージ出力ノード");
             for(size_t i=0; i<node->pSlots.size(); ++i)
             {
                 auto slot = node->pSlots[i];
-                ImGui::Text(u8"%s : %s %s", kSlotKind[slot->Kind], kDataType[slot->Type], slot->Tag.c_str());
+                ImGui::Text(u8"%s : %s %s", kSlotKind[slot->Kind], kDataType[slot->Type], slot->GetTag());
+            }
+
+            // Gバッファのエンコード.
+            ImGui::Separator();
+            auto layout  = m_EditData.GetGBufferLayout();
+            auto changed = false;
+            changed |= ImGui::Checkbox(u8"法線 : 八面体圧縮", &layout.OctahedralNormal);
+            changed |= ImGui::Checkbox(u8"ベースカラー : YCoCg圧縮", &layout.YCoCgBaseColor);
+            changed |= ImGui::Checkbox(u8"ラフネス・メタルネス・遮蔽 : パック", &layout.PackedRMO);
+            if (changed)
+            {
+                m_EditData.SetGBufferLayout(layout);
+                m_Journal.SetLayout(layout);
             }
         }
         break;
     }
 
+    // 品質設定.
+    if (node->Type != NodeType::StageOutput)
+    {
+        ImGui::Separator();
 
-    ImGui::End();
-}
+        // 品質設定は履歴に記録しないため，ジャーナルにだけ記録する.
+        auto oldQuality  = node->MinQuality;
+        auto oldFallback = node->FallbackInput;
 
-//-----------------------------------------------------------------------------
-//      リンクを追加します.
-//-----------------------------------------------------------------------------
-void Editor::AddLink(Slot* lhs, Slot* rhs)
-{
-    lhs->pNext = rhs;
-    rhs->pPrev = lhs;
+        int quality = node->MinQuality;
+        if (ImGui::Combo(u8"最低品質", &quality, kQualityName, IM_ARRAYSIZE(kQualityName)))
+        { node->MinQuality = QualityLevel(quality); }
 
-    auto find = false;
-    for(size_t i=0; i<m_Links.size(); ++i)
-    {
-        if (m_Links[i].Lhs == lhs && m_Links[i].Rhs == rhs)
+        // 品質不足時に代替する入力.
+        auto fallback = node->GetFallbackSlot();
+        auto preview  = (fallback != nullptr) ? fallback->GetTag() : u8"既定値";
+        if (ImGui::BeginCombo(u8"代替入力", preview))
         {
-            find = true;
-            break;
-        }
-    }
+            if (ImGui::Selectable(u8"既定値", fallback == nullptr))
+            { node->FallbackInput = -1; }
 
-    if (!find)
-    {
-        Link link;
-        link.Lhs = lhs;
-        link.Rhs = rhs;
-        m_Links.push_back(link);
-    }
-}
+            int input = 0;
+            for(size_t i=0; i<node->pSlots.size(); ++i)
+            {
+                auto slot = node->pSlots[i];
+                if (slot->Kind != SlotType::Input)
+                { continue; }
 
-//-----------------------------------------------------------------------------
-//      リンクを削除します.
-//-----------------------------------------------------------------------------
-void Editor::RemoveLink(Slot* slot)
-{
-    auto itr = m_Links.begin();
-    while(itr != m_Links.end())
-    {
-        if (itr->Lhs == slot ||
-            itr->Rhs == slot)
-        {
-            itr->Lhs->pNext = nullptr;
-            itr->Rhs->pPrev = nullptr;
-            itr = m_Links.erase(itr);
-            break;
+                ImGui::PushID(input);
+                if (ImGui::Selectable(slot->GetTag(), slot == fallback))
+                { node->FallbackInput = input; }
+                ImGui::PopID();
+
+                input++;
+            }
+
+            ImGui::EndCombo();
         }
 
-        itr++;
+        if (node->MinQuality != oldQuality || node->FallbackInput != oldFallback)
+        {
+            m_EditData.InvalidateHash(node);
+            m_Journal.SetQuality(node);
+        }
     }
+
+    ImGui::End();
 }
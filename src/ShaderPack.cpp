@@ -0,0 +1,365 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ShaderPack.h>
+#include <Windows.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+
+static const uint32_t kShaderPackMagic   = 0x4B415053; // 'SPAK'
+static const uint32_t kShaderPackVersion = 1;
+
+//-----------------------------------------------------------------------------
+//      指定アライメントに切り上げます.
+//-----------------------------------------------------------------------------
+uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{ return (value + alignment - 1) & ~(alignment - 1); }
+
+//-----------------------------------------------------------------------------
+//      エントリーのハッシュ値比較.
+//-----------------------------------------------------------------------------
+bool LessKeyHash(const ShaderPackEntry& lhs, uint64_t rhs)
+{ return lhs.KeyHash < rhs; }
+
+//-----------------------------------------------------------------------------
+//      配列がファイル内に収まっているかチェックします.
+//-----------------------------------------------------------------------------
+bool IsInRange(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size)
+{ return offset <= size && count <= (size - offset) / stride; }
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値を計算します.
+//-----------------------------------------------------------------------------
+uint64_t ComputeShaderPackHash(const char* data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i=0; i<size; ++i)
+    {
+        hash ^= uint8_t(data[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderPackWriter class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      シェーダを追加します.
+//
+//      同じ名前が追加済みの場合は追加せず false を返します.
+//-----------------------------------------------------------------------------
+bool ShaderPackWriter::Add(const char* name, uint32_t quality, const std::string& code)
+{
+    if (!m_Names.insert(name).second)
+    { return false; }
+
+    Item item;
+    item.Name    = name;
+    item.Code    = code;
+    item.Quality = quality;
+    m_Items.push_back(item);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルに書き出します.
+//
+//      名前を先にまとめて格納し，その後にシェーダコードを格納します.
+//      名前だけを参照する検索や検証でシェーダコードのページに触れずに済みます.
+//-----------------------------------------------------------------------------
+bool ShaderPackWriter::Write(const char* path) const
+{
+    // インデックスを作成.
+    std::vector<ShaderPackEntry> entries;
+    entries.resize(m_Items.size());
+
+    ShaderPackHeader header = {};
+    header.Magic        = kShaderPackMagic;
+    header.Version      = kShaderPackVersion;
+    header.EntryCount   = uint32_t(m_Items.size());
+    header.IndexOffset  = AlignUp(sizeof(ShaderPackHeader), 16);
+    header.DataOffset   = AlignUp(header.IndexOffset + sizeof(ShaderPackEntry) * entries.size(), 16);
+
+    auto offset = header.DataOffset;
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        auto& item  = m_Items[i];
+        auto& entry = entries[i];
+
+        entry.KeyHash    = ComputeShaderPackHash(item.Name.c_str(), item.Name.size());
+        entry.CodeHash   = ComputeShaderPackHash(item.Code.c_str(), item.Code.size());
+        entry.NameSize   = uint32_t(item.Name.size());
+        entry.CodeSize   = uint32_t(item.Code.size());
+        entry.Quality    = item.Quality;
+        entry.Reserved   = 0;
+
+        entry.NameOffset = offset;
+        offset += entry.NameSize + 1;
+    }
+
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        entries[i].CodeOffset = offset;
+        offset += entries[i].CodeSize + 1;
+    }
+
+    // 二分探索できるようにハッシュ値で整列.
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const ShaderPackEntry& lhs, const ShaderPackEntry& rhs)
+        { return lhs.KeyHash < rhs.KeyHash; });
+
+    FILE* pFile;
+    auto err = fopen_s(&pFile, path, "wb");
+    if (err != 0)
+    { return false; }
+
+    static const uint8_t kPadding[16] = {};
+    static const char    kTerminator  = '\0';
+
+    fwrite(&header, sizeof(header), 1, pFile);
+    fwrite(kPadding, size_t(header.IndexOffset - sizeof(header)), 1, pFile);
+
+    if (!entries.empty())
+    { fwrite(entries.data(), sizeof(ShaderPackEntry), entries.size(), pFile); }
+
+    auto indexEnd = header.IndexOffset + sizeof(ShaderPackEntry) * entries.size();
+    fwrite(kPadding, size_t(header.DataOffset - indexEnd), 1, pFile);
+
+    // 文字列は終端文字付きで格納し，そのまま参照できるようにする.
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        auto& item = m_Items[i];
+        fwrite(item.Name.c_str(), item.Name.size(), 1, pFile);
+        fwrite(&kTerminator, 1, 1, pFile);
+    }
+
+    for(size_t i=0; i<m_Items.size(); ++i)
+    {
+        auto& item = m_Items[i];
+        fwrite(item.Code.c_str(), item.Code.size(), 1, pFile);
+        fwrite(&kTerminator, 1, 1, pFile);
+    }
+
+    auto result = (ferror(pFile) == 0);
+    fclose(pFile);
+
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+//      追加済みのシェーダを破棄します.
+//-----------------------------------------------------------------------------
+void ShaderPackWriter::Clear()
+{
+    m_Items.clear();
+    m_Names.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ShaderPackReader class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ShaderPackReader::ShaderPackReader()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ShaderPackReader::~ShaderPackReader()
+{ Close(); }
+
+//-----------------------------------------------------------------------------
+//      ファイルをメモリマップして開きます.
+//-----------------------------------------------------------------------------
+bool ShaderPackReader::Open(const char* path)
+{
+    Close();
+
+    auto hFile = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+        nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    { return false; }
+
+    m_hFile = hFile;
+
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(hFile, &size) || uint64_t(size.QuadPart) < sizeof(ShaderPackHeader))
+    {
+        Close();
+        return false;
+    }
+
+    m_hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_hMapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pData == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    if (!Validate(m_pData, uint64_t(size.QuadPart)))
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ヘッダとインデックスの整合性をチェックします.
+//
+//      全エントリーの名前とシェーダコードの範囲を1回走査して確認するので，
+//      以降のアクセサは範囲チェックを省略できます. 名前は終端文字まで
+//      確認しますが，シェーダコードの終端文字はファイル全体を読み込むことに
+//      なるため GetCode() で確認します.
+//-----------------------------------------------------------------------------
+bool ShaderPackReader::Validate(const uint8_t* data, uint64_t size)
+{
+    auto header = reinterpret_cast<const ShaderPackHeader*>(data);
+    if (header->Magic != kShaderPackMagic
+     || header->Version != kShaderPackVersion
+     || !IsInRange(header->IndexOffset, header->EntryCount, sizeof(ShaderPackEntry), size)
+     || (header->IndexOffset % alignof(ShaderPackEntry)) != 0
+     || header->DataOffset > size)
+    { return false; }
+
+    auto entries = reinterpret_cast<const ShaderPackEntry*>(data + header->IndexOffset);
+    for(uint32_t i=0; i<header->EntryCount; ++i)
+    {
+        auto& entry = entries[i];
+        if (entry.NameOffset < header->DataOffset
+         || entry.CodeOffset < header->DataOffset
+         || !IsInRange(entry.NameOffset, uint64_t(entry.NameSize) + 1, 1, size)
+         || !IsInRange(entry.CodeOffset, uint64_t(entry.CodeSize) + 1, 1, size)
+         || data[entry.NameOffset + entry.NameSize] != '\0')
+        { return false; }
+
+        // 二分探索できるようハッシュ値の昇順であること.
+        if (i > 0 && entries[i - 1].KeyHash > entry.KeyHash)
+        { return false; }
+    }
+
+    m_pEntries = entries;
+    m_Count    = header->EntryCount;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      ファイルを閉じます.
+//-----------------------------------------------------------------------------
+void ShaderPackReader::Close()
+{
+    if (m_pData != nullptr)
+    {
+        UnmapViewOfFile(m_pData);
+        m_pData = nullptr;
+    }
+
+    if (m_hMapping != nullptr)
+    {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+    }
+
+    if (m_hFile != nullptr)
+    {
+        CloseHandle(m_hFile);
+        m_hFile = nullptr;
+    }
+
+    m_pEntries = nullptr;
+    m_Count    = 0;
+}
+
+//-----------------------------------------------------------------------------
+//      エントリー数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t ShaderPackReader::GetCount() const
+{ return m_Count; }
+
+//-----------------------------------------------------------------------------
+//      エントリーを取得します.
+//-----------------------------------------------------------------------------
+const ShaderPackEntry* ShaderPackReader::GetEntry(uint32_t index) const
+{
+    if (index >= m_Count)
+    { return nullptr; }
+
+    return &m_pEntries[index];
+}
+
+//-----------------------------------------------------------------------------
+//      ハッシュ値からエントリーを二分探索します.
+//-----------------------------------------------------------------------------
+const ShaderPackEntry* ShaderPackReader::Find(uint64_t keyHash) const
+{
+    auto end = m_pEntries + m_Count;
+    auto itr = std::lower_bound(m_pEntries, end, keyHash, LessKeyHash);
+    if (itr == end || itr->KeyHash != keyHash)
+    { return nullptr; }
+
+    return itr;
+}
+
+//-----------------------------------------------------------------------------
+//      名前からエントリーを検索します.
+//-----------------------------------------------------------------------------
+const ShaderPackEntry* ShaderPackReader::Find(const char* name) const
+{
+    auto size = strlen(name);
+    auto hash = ComputeShaderPackHash(name, size);
+    auto end  = m_pEntries + m_Count;
+
+    // ハッシュ値が衝突している場合に備えて名前も比較する.
+    for(auto itr = Find(hash); itr != nullptr && itr != end && itr->KeyHash == hash; ++itr)
+    {
+        if (itr->NameSize == size && memcmp(GetName(itr), name, size) == 0)
+        { return itr; }
+    }
+
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+//      名前を取得します.
+//-----------------------------------------------------------------------------
+const char* ShaderPackReader::GetName(const ShaderPackEntry* entry) const
+{ return reinterpret_cast<const char*>(m_pData + entry->NameOffset); }
+
+//-----------------------------------------------------------------------------
+//      シェーダコードを取得します.
+//
+//      終端文字が無い場合は壊れたデータとして nullptr を返します.
+//-----------------------------------------------------------------------------
+const char* ShaderPackReader::GetCode(const ShaderPackEntry* entry) const
+{
+    if (m_pData[entry->CodeOffset + entry->CodeSize] != '\0')
+    { return nullptr; }
+
+    return reinterpret_cast<const char*>(m_pData + entry->CodeOffset);
+}
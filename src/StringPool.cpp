@@ -0,0 +1,153 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <StringPool.h>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace {
+
+static const uint32_t kFirstChunkBits   = 8;    // 先頭チャンクの要素数(2の冪)のビット数.
+static const uint32_t kMaxChunks        = 24;   // チャンク数の上限(要素数は毎回2倍).
+
+///////////////////////////////////////////////////////////////////////////////
+// StringPool class
+///////////////////////////////////////////////////////////////////////////////
+class StringPool
+{
+public:
+    StringPool()
+    : m_Count(0)
+    {
+        // シンボル0は空文字列.
+        auto itr = m_Symbols.insert(std::make_pair(std::string(), kEmptySymbol)).first;
+        Append(itr->first.c_str());
+    }
+
+    Symbol Intern(const std::string& text)
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+
+        auto found = m_Symbols.find(text);
+        if (found != m_Symbols.end())
+        { return found->second; }
+
+        // キーの文字列はノードベースのコンテナ内で移動しないため，そのまま参照する.
+        auto symbol = m_Count.load(std::memory_order_relaxed);
+        auto itr    = m_Symbols.insert(std::make_pair(text, symbol)).first;
+        Append(itr->first.c_str());
+
+        return symbol;
+    }
+
+    //-------------------------------------------------------------------------
+    //      シンボルに対応する文字列を取得します.
+    //
+    //      表は追記のみのチャンクに格納し，確保したチャンクは移動しません.
+    //      登録数は release で公開するので，acquire で読んだ登録数未満の
+    //      シンボルはロック無しで参照できます.
+    //-------------------------------------------------------------------------
+    const char* GetString(Symbol symbol) const
+    {
+        if (symbol >= m_Count.load(std::memory_order_acquire))
+        { symbol = kEmptySymbol; }
+
+        uint32_t chunk;
+        uint32_t offset;
+        Locate(symbol, chunk, offset);
+
+        return m_pChunks[chunk][offset];
+    }
+
+    uint32_t GetCount() const
+    { return m_Count.load(std::memory_order_acquire); }
+
+private:
+    std::mutex                              m_Mutex;
+    std::unordered_map<std::string, Symbol> m_Symbols;
+    std::unique_ptr<const char*[]>          m_pChunks[kMaxChunks];  // k番目のチャンクの要素数は (1 << kFirstChunkBits) << k.
+    std::atomic<uint32_t>                   m_Count;                // 公開済みの登録数.
+
+    //-------------------------------------------------------------------------
+    //      シンボルを格納するチャンクと位置を求めます.
+    //-------------------------------------------------------------------------
+    static void Locate(Symbol symbol, uint32_t& chunk, uint32_t& offset)
+    {
+        auto value = (symbol >> kFirstChunkBits) + 1;
+
+        chunk = 0;
+        while((value >> (chunk + 1)) != 0)
+        { chunk++; }
+
+        offset = symbol - (((1u << chunk) - 1) << kFirstChunkBits);
+    }
+
+    //-------------------------------------------------------------------------
+    //      文字列を末尾に追加して公開します(ロック中に呼び出します).
+    //-------------------------------------------------------------------------
+    void Append(const char* text)
+    {
+        auto symbol = m_Count.load(std::memory_order_relaxed);
+
+        uint32_t chunk;
+        uint32_t offset;
+        Locate(symbol, chunk, offset);
+        assert(chunk < kMaxChunks);
+
+        if (!m_pChunks[chunk])
+        { m_pChunks[chunk].reset(new const char*[size_t(1u << kFirstChunkBits) << chunk]); }
+
+        m_pChunks[chunk][offset] = text;
+        m_Count.store(symbol + 1, std::memory_order_release);
+    }
+};
+
+//-----------------------------------------------------------------------------
+//      文字列プールを取得します.
+//-----------------------------------------------------------------------------
+StringPool& GetStringPool()
+{
+    static StringPool s_Pool;
+    return s_Pool;
+}
+
+} // namespace
+
+
+//-----------------------------------------------------------------------------
+//      文字列を登録し，シンボルを取得します.
+//-----------------------------------------------------------------------------
+Symbol InternString(const char* text)
+{
+    if (text == nullptr || text[0] == '\0')
+    { return kEmptySymbol; }
+
+    return GetStringPool().Intern(text);
+}
+
+//-----------------------------------------------------------------------------
+//      文字列を登録し，シンボルを取得します.
+//-----------------------------------------------------------------------------
+Symbol InternString(const std::string& text)
+{
+    if (text.empty())
+    { return kEmptySymbol; }
+
+    return GetStringPool().Intern(text);
+}
+
+//-----------------------------------------------------------------------------
+//      シンボルに対応する文字列を取得します.
+//-----------------------------------------------------------------------------
+const char* GetSymbolString(Symbol symbol)
+{ return GetStringPool().GetString(symbol); }
+
+//-----------------------------------------------------------------------------
+//      登録済みの文字列数を取得します.
+//-----------------------------------------------------------------------------
+uint32_t GetSymbolCount()
+{ return GetStringPool().GetCount(); }
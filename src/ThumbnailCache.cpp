@@ -0,0 +1,229 @@
+﻿//-----------------------------------------------------------------------------
+// Includes
+//-----------------------------------------------------------------------------
+#include <ThumbnailCache.h>
+#include <Windows.h>
+#include <wincodec.h>
+#include <algorithm>
+
+
+namespace {
+
+static const uint32_t kMaxWorkerCount = 4;   // デコードを行うスレッドの最大数.
+
+} // namespace
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ThumbnailCache class
+///////////////////////////////////////////////////////////////////////////////
+
+//-----------------------------------------------------------------------------
+//      コンストラクタです.
+//-----------------------------------------------------------------------------
+ThumbnailCache::ThumbnailCache()
+{ /* DO_NOTHING */ }
+
+//-----------------------------------------------------------------------------
+//      デストラクタです.
+//-----------------------------------------------------------------------------
+ThumbnailCache::~ThumbnailCache()
+{ Term(); }
+
+//-----------------------------------------------------------------------------
+//      初期化処理を行います.
+//
+//      D3D11 デバイスはフリースレッドなので，テクスチャはワーカースレッドで
+//      生成します.
+//-----------------------------------------------------------------------------
+bool ThumbnailCache::Init(ID3D11Device* pDevice)
+{
+    Term();
+
+    if (pDevice == nullptr)
+    { return false; }
+
+    m_pDevice = pDevice;
+
+    auto count = (std::min)(kMaxWorkerCount, (std::max)(1u, std::thread::hardware_concurrency()));
+    for(uint32_t i=0; i<count; ++i)
+    { m_Workers.emplace_back(&ThumbnailCache::Run, this); }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//      終了処理を行います.
+//
+//      デコード中のものは完了を待ち，未着手のものは破棄します.
+//-----------------------------------------------------------------------------
+void ThumbnailCache::Term()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Mutex);
+        m_Quit = true;
+    }
+    m_Condition.notify_all();
+
+    for(size_t i=0; i<m_Workers.size(); ++i)
+    { m_Workers[i].join(); }
+
+    m_Workers.clear();
+    m_Queue  .clear();
+    m_Entries.clear();
+    m_pDevice.Reset();
+    m_Quit = false;
+}
+
+//-----------------------------------------------------------------------------
+//      サムネイルを要求します.
+//
+//      初回の要求でデコードを予約し，準備ができるまでは ThumbnailLoading を
+//      返します. 描画時に毎フレーム呼び出してください.
+//-----------------------------------------------------------------------------
+ThumbnailState ThumbnailCache::Request(const std::string& path, ImTextureID& texture)
+{
+    texture = nullptr;
+
+    if (path.empty() || m_pDevice.Get() == nullptr)
+    { return ThumbnailFailed; }
+
+    std::lock_guard<std::mutex> locker(m_Mutex);
+
+    auto itr = m_Entries.find(path);
+    if (itr == m_Entries.end())
+    {
+        m_Entries[path] = Entry();
+        m_Queue.push_back(path);
+        m_Condition.notify_one();
+        return ThumbnailLoading;
+    }
+
+    texture = itr->second.pSRV.Get();
+    return itr->second.State;
+}
+
+//-----------------------------------------------------------------------------
+//      ワーカースレッドでデコードを行います.
+//-----------------------------------------------------------------------------
+void ThumbnailCache::Run()
+{
+    // WIC を使うスレッドごとに COM を初期化する.
+    auto hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    {
+        Microsoft::WRL::ComPtr<IWICImagingFactory> pFactory;
+        CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(pFactory.GetAddressOf()));
+
+        for(;;)
+        {
+            std::string path;
+            {
+                std::unique_lock<std::mutex> locker(m_Mutex);
+                m_Condition.wait(locker, [this]() { return m_Quit || !m_Queue.empty(); });
+                if (m_Quit)
+                { break; }
+
+                path = std::move(m_Queue.front());
+                m_Queue.pop_front();
+            }
+
+            Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pSRV;
+            auto result = (pFactory.Get() != nullptr) && Decode(pFactory.Get(), path, pSRV);
+
+            {
+                std::lock_guard<std::mutex> locker(m_Mutex);
+                auto& entry = m_Entries[path];
+                entry.State = result ? ThumbnailReady : ThumbnailFailed;
+                entry.pSRV  = pSRV;
+            }
+        }
+    }
+
+    if (SUCCEEDED(hr))
+    { CoUninitialize(); }
+}
+
+//-----------------------------------------------------------------------------
+//      画像をデコードし，縮小したテクスチャを生成します.
+//-----------------------------------------------------------------------------
+bool ThumbnailCache::Decode
+(
+    IWICImagingFactory*                                 pFactory,
+    const std::string&                                  path,
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>&   result
+)
+{
+    wchar_t widePath[MAX_PATH];
+    if (MultiByteToWideChar(CP_ACP, 0, path.c_str(), -1, widePath, MAX_PATH) == 0)
+    { return false; }
+
+    Microsoft::WRL::ComPtr<IWICBitmapDecoder> pDecoder;
+    auto hr = pFactory->CreateDecoderFromFilename(widePath, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, pDecoder.GetAddressOf());
+    if (FAILED(hr))
+    { return false; }
+
+    Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> pFrame;
+    hr = pDecoder->GetFrame(0, pFrame.GetAddressOf());
+    if (FAILED(hr))
+    { return false; }
+
+    UINT width  = 0;
+    UINT height = 0;
+    hr = pFrame->GetSize(&width, &height);
+    if (FAILED(hr) || width == 0 || height == 0)
+    { return false; }
+
+    // 縦横比を保ったまま長辺を kSize に縮小する.
+    auto scale = (std::min)(1.0, double(kSize) / double((std::max)(width, height)));
+    auto w     = (std::max)(1u, UINT(width  * scale));
+    auto h     = (std::max)(1u, UINT(height * scale));
+
+    Microsoft::WRL::ComPtr<IWICBitmapScaler> pScaler;
+    hr = pFactory->CreateBitmapScaler(pScaler.GetAddressOf());
+    if (FAILED(hr))
+    { return false; }
+
+    hr = pScaler->Initialize(pFrame.Get(), w, h, WICBitmapInterpolationModeFant);
+    if (FAILED(hr))
+    { return false; }
+
+    Microsoft::WRL::ComPtr<IWICFormatConverter> pConverter;
+    hr = pFactory->CreateFormatConverter(pConverter.GetAddressOf());
+    if (FAILED(hr))
+    { return false; }
+
+    hr = pConverter->Initialize(pScaler.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom);
+    if (FAILED(hr))
+    { return false; }
+
+    std::vector<uint8_t> pixels(w * h * 4);
+    hr = pConverter->CopyPixels(nullptr, w * 4, UINT(pixels.size()), pixels.data());
+    if (FAILED(hr))
+    { return false; }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width              = w;
+    desc.Height             = h;
+    desc.MipLevels          = 1;
+    desc.ArraySize          = 1;
+    desc.Format             = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count   = 1;
+    desc.Usage              = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags          = D3D11_BIND_SHADER_RESOURCE;
+
+    D3D11_SUBRESOURCE_DATA res = {};
+    res.pSysMem             = pixels.data();
+    res.SysMemPitch         = w * 4;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
+    hr = m_pDevice->CreateTexture2D(&desc, &res, pTexture.GetAddressOf());
+    if (FAILED(hr))
+    { return false; }
+
+    hr = m_pDevice->CreateShaderResourceView(pTexture.Get(), nullptr, result.GetAddressOf());
+    if (FAILED(hr))
+    { return false; }
+
+    return true;
+}